@@ -19,6 +19,13 @@
 #include "ap_defs.h"
 #include "ap_convert.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
 #define INT8_MIN (-128)
 #define INT8_MAX (127)
 #define INT16_MIN (-32767-1)
@@ -84,6 +91,11 @@ static FXfloat s24_to_float(FXint x) {
   }
 
 
+static FXfloat s32_to_float(FXint x) {
+  return (FXfloat)((FXdouble)x / 2147483648.0);
+  }
+
+
 static FXshort float_to_s16(FXfloat x) {
   FXfloat c = x*INT16_MAX;
   if (c>=INT16_MAX)
@@ -153,14 +165,28 @@ void s24le3_to_float(FXuchar * input,FXuint nsamples, MemoryBuffer & out){
   out.wroteBytes(nsamples*4);
   }
 
-
-void s24le3_to_s32(const FXuchar * input,FXuint nsamples,MemoryBuffer & out){
+void s32_to_float(FXuchar * buffer,FXuint nsamples, MemoryBuffer & out){
   out.clear();
   out.reserve(nsamples*4);
-  FXint * output = out.s32();
+  const FXint * input = reinterpret_cast<const FXint*>(buffer);
+  FXfloat * output = out.flt();
+  for (FXuint i=0;i<nsamples;i++) {
+    output[i]=s32_to_float(input[i]);
+    }
+  out.wroteBytes(nsamples*4);
+  }
+
+
+void s24le3_to_s32(const FXuchar * input,FXuint nsamples,FXint * output){
   for (FXuint i=0;i<nsamples;i++,input+=3) {
     output[i] = s24_to_s32(input[0]|input[1]<<8|input[2]<<16);
     }
+  }
+
+void s24le3_to_s32(const FXuchar * input,FXuint nsamples,MemoryBuffer & out){
+  out.clear();
+  out.reserve(nsamples*4);
+  s24le3_to_s32(input,nsamples,out.s32());
   out.wroteBytes(nsamples*4);
   }
 
@@ -172,4 +198,205 @@ void float_to_s32(FXuchar * buffer,FXuint nsamples){
     }
   }
 
+/*
+  Planar to interleaved kernels.
+
+  The channel count is a template parameter, so the inner loop is fully
+  unrolled and the compiler is free to vectorise it. Stereo 16 and 32 bit
+  output, by far the most common, have hand written SSE2 and NEON versions.
+  Kernels are picked once per format through interleave_planar.
+*/
+
+template<FXuint N>
+static void interleave_s8(const FXint * const * in,FXuint offset,FXuint nframes,FXuchar * out) {
+  FXchar * o = reinterpret_cast<FXchar*>(out);
+  for (FXuint s=offset;s<offset+nframes;s++) {
+    for (FXuint c=0;c<N;c++) {
+      *o++ = in[c][s];
+      }
+    }
+  }
+
+template<FXuint N>
+static void interleave_s16(const FXint * const * in,FXuint offset,FXuint nframes,FXuchar * out) {
+  FXshort * o = reinterpret_cast<FXshort*>(out);
+  for (FXuint s=offset;s<offset+nframes;s++) {
+    for (FXuint c=0;c<N;c++) {
+      *o++ = in[c][s];
+      }
+    }
+  }
+
+template<FXuint N>
+static void interleave_s24le3(const FXint * const * in,FXuint offset,FXuint nframes,FXuchar * out) {
+  for (FXuint s=offset;s<offset+nframes;s++) {
+    for (FXuint c=0;c<N;c++,out+=3) {
+      const FXint v = in[c][s];
+      out[0] = (v&0xFF);
+      out[1] = (v&0xFF00)>>8;
+      out[2] = (v&0xFF0000)>>16;
+      }
+    }
+  }
+
+template<FXuint N>
+static void interleave_s32(const FXint * const * in,FXuint offset,FXuint nframes,FXuchar * out) {
+#if FOX_BIGENDIAN == 0
+  FXint * o = reinterpret_cast<FXint*>(out);
+  for (FXuint s=offset;s<offset+nframes;s++) {
+    for (FXuint c=0;c<N;c++) {
+      *o++ = in[c][s];
+      }
+    }
+#else
+  for (FXuint s=offset;s<offset+nframes;s++) {
+    for (FXuint c=0;c<N;c++,out+=4) {
+      const FXint v = in[c][s];
+      out[0] = (v&0xFF);
+      out[1] = (v&0xFF00)>>8;
+      out[2] = (v&0xFF0000)>>16;
+      out[3] = (v&0xFF000000)>>24;
+      }
+    }
+#endif
+  }
+
+template<FXuint N>
+static void interleave_float(const FXfloat * const * in,FXuint offset,FXuint nframes,FXfloat * out) {
+  for (FXuint s=offset;s<offset+nframes;s++) {
+    for (FXuint c=0;c<N;c++) {
+      *out++ = in[c][s];
+      }
+    }
+  }
+
+
+// Samples are known to fit in 16 bits, so saturating or narrowing gives the same result.
+static void interleave_s16_stereo(const FXint * const * in,FXuint offset,FXuint nframes,FXuchar * out) {
+  const FXint * l = in[0] + offset;
+  const FXint * r = in[1] + offset;
+  FXshort * o = reinterpret_cast<FXshort*>(out);
+  FXuint i=0;
+#if defined(__SSE2__)
+  for (;i+8<=nframes;i+=8,o+=16) {
+    const __m128i l16 = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(l+i)),_mm_loadu_si128(reinterpret_cast<const __m128i*>(l+i+4)));
+    const __m128i r16 = _mm_packs_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r+i)),_mm_loadu_si128(reinterpret_cast<const __m128i*>(r+i+4)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(o),_mm_unpacklo_epi16(l16,r16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(o+8),_mm_unpackhi_epi16(l16,r16));
+    }
+#elif defined(HAVE_NEON)
+  for (;i+8<=nframes;i+=8,o+=16) {
+    int16x8x2_t v;
+    v.val[0] = vcombine_s16(vmovn_s32(vld1q_s32(l+i)),vmovn_s32(vld1q_s32(l+i+4)));
+    v.val[1] = vcombine_s16(vmovn_s32(vld1q_s32(r+i)),vmovn_s32(vld1q_s32(r+i+4)));
+    vst2q_s16(o,v);
+    }
+#endif
+  for (;i<nframes;i++) {
+    *o++ = l[i];
+    *o++ = r[i];
+    }
+  }
+
+
+static void interleave_s32_stereo(const FXint * const * in,FXuint offset,FXuint nframes,FXuchar * out) {
+#if defined(__SSE2__) || defined(HAVE_NEON)
+  const FXint * l = in[0] + offset;
+  const FXint * r = in[1] + offset;
+  FXint * o = reinterpret_cast<FXint*>(out);
+  FXuint i=0;
+#if defined(__SSE2__)
+  for (;i+4<=nframes;i+=4,o+=8) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l+i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(r+i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(o),_mm_unpacklo_epi32(a,b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(o+4),_mm_unpackhi_epi32(a,b));
+    }
+#else
+  for (;i+4<=nframes;i+=4,o+=8) {
+    int32x4x2_t v;
+    v.val[0] = vld1q_s32(l+i);
+    v.val[1] = vld1q_s32(r+i);
+    vst2q_s32(o,v);
+    }
+#endif
+  for (;i<nframes;i++) {
+    *o++ = l[i];
+    *o++ = r[i];
+    }
+#else
+  interleave_s32<2>(in,offset,nframes,out);
+#endif
+  }
+
+
+static void interleave_float_stereo(const FXfloat * const * in,FXuint offset,FXuint nframes,FXfloat * out) {
+  const FXfloat * l = in[0] + offset;
+  const FXfloat * r = in[1] + offset;
+  FXuint i=0;
+#if defined(__SSE2__)
+  for (;i+4<=nframes;i+=4,out+=8) {
+    const __m128 a = _mm_loadu_ps(l+i);
+    const __m128 b = _mm_loadu_ps(r+i);
+    _mm_storeu_ps(out,_mm_unpacklo_ps(a,b));
+    _mm_storeu_ps(out+4,_mm_unpackhi_ps(a,b));
+    }
+#elif defined(HAVE_NEON)
+  for (;i+4<=nframes;i+=4,out+=8) {
+    float32x4x2_t v;
+    v.val[0] = vld1q_f32(l+i);
+    v.val[1] = vld1q_f32(r+i);
+    vst2q_f32(out,v);
+    }
+#endif
+  for (;i<nframes;i++) {
+    *out++ = l[i];
+    *out++ = r[i];
+    }
+  }
+
+
+InterleaveFunc interleave_planar(FXuint bps,FXuint nchannels) {
+  static const InterleaveFunc s8[8]={
+    interleave_s8<1>,interleave_s8<2>,interleave_s8<3>,interleave_s8<4>,
+    interleave_s8<5>,interleave_s8<6>,interleave_s8<7>,interleave_s8<8>
+    };
+  static const InterleaveFunc s16[8]={
+    interleave_s16<1>,interleave_s16_stereo,interleave_s16<3>,interleave_s16<4>,
+    interleave_s16<5>,interleave_s16<6>,interleave_s16<7>,interleave_s16<8>
+    };
+  static const InterleaveFunc s24[8]={
+    interleave_s24le3<1>,interleave_s24le3<2>,interleave_s24le3<3>,interleave_s24le3<4>,
+    interleave_s24le3<5>,interleave_s24le3<6>,interleave_s24le3<7>,interleave_s24le3<8>
+    };
+  static const InterleaveFunc s32[8]={
+    interleave_s32<1>,interleave_s32_stereo,interleave_s32<3>,interleave_s32<4>,
+    interleave_s32<5>,interleave_s32<6>,interleave_s32<7>,interleave_s32<8>
+    };
+
+  if (nchannels<1 || nchannels>8)
+    return nullptr;
+
+  switch(bps) {
+    case  8: return s8[nchannels-1];  break;
+    case 16: return s16[nchannels-1]; break;
+    case 24: return s24[nchannels-1]; break;
+    case 32: return s32[nchannels-1]; break;
+    default: break;
+    }
+  return nullptr;
+  }
+
+
+InterleaveFloatFunc interleave_planar_float(FXuint nchannels) {
+  static const InterleaveFloatFunc flt[8]={
+    interleave_float<1>,interleave_float_stereo,interleave_float<3>,interleave_float<4>,
+    interleave_float<5>,interleave_float<6>,interleave_float<7>,interleave_float<8>
+    };
+  if (nchannels<1 || nchannels>8)
+    return nullptr;
+  return flt[nchannels-1];
+  }
+
+
 }
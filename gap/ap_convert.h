@@ -25,14 +25,29 @@ namespace ap {
 
 extern void s16_to_float(FXuchar * buffer, FXuint nsamples, MemoryBuffer & out);
 extern void s24le3_to_float(FXuchar * buffer,FXuint nsamples, MemoryBuffer & out);
+extern void s32_to_float(FXuchar * buffer,FXuint nsamples, MemoryBuffer & out);
 
 
 extern void s24le3_to_s16(FXuchar * buffer,FXuint nsamples);
 extern void  float_to_s16(FXuchar * buffer,FXuint nsamples);
 
 extern void s24le3_to_s32(const FXuchar * buffer,FXuint nsamples,MemoryBuffer & out);
+extern void s24le3_to_s32(const FXuchar * buffer,FXuint nsamples,FXint * out);
 extern void  float_to_s32(FXuchar * buffer,FXuint nsamples);
 
+
+/// Interleave nframes starting at offset from planar 32 bit channels into packed little endian samples
+typedef void (*InterleaveFunc)(const FXint * const * in,FXuint offset,FXuint nframes,FXuchar * out);
+
+/// Interleave nframes starting at offset from planar float channels
+typedef void (*InterleaveFloatFunc)(const FXfloat * const * in,FXuint offset,FXuint nframes,FXfloat * out);
+
+/// Return the interleave kernel for the given bits per sample (8,16,24,32) and 1-8 channels. nullptr if unsupported.
+extern InterleaveFunc interleave_planar(FXuint bps,FXuint nchannels);
+
+/// Return the float interleave kernel for 1-8 channels. nullptr if unsupported.
+extern InterleaveFloatFunc interleave_planar_float(FXuint nchannels);
+
 }
 #endif
 
@@ -40,6 +40,9 @@ public:
 
   // Post output configuration
   virtual void post_configuration(ConfigureEvent*)=0;
+
+  // Number of threads a decoder may use. Less than 2 means single threaded.
+  virtual FXint get_decode_threads() const { return 0; }
   };
 
 
@@ -182,6 +182,10 @@ void DecoderThread::post_output_packet(Packet *& packet,FXbool eos/*=false*/) {
 void DecoderThread::post_configuration(ConfigureEvent * event) {
   engine->output->post(event);
   }
+
+FXint DecoderThread::get_decode_threads() const {
+  return atomicAdd(&engine->decode_threads,0);
+  }
 }
 
 
@@ -49,6 +49,8 @@ public: // DecoderContext Interface
 
   void post_configuration(ConfigureEvent*) override;
 
+  FXint get_decode_threads() const override;
+
 public:
   DecoderThread(AudioEngine*);
 
@@ -116,7 +116,7 @@ void SndioConfig::save(FXSettings & settings) const {
   }
 
 
-OutputConfig::OutputConfig() {
+OutputConfig::OutputConfig() : resampler(ResamplerOff), flags(0), fixed_rate(0), fixed_format(FixedFormatS32), fixed_channels(2) {
 #if defined(__linux__) && defined(HAVE_ALSA)
   device=DeviceAlsa;
 #elif defined(HAVE_OSS)
@@ -178,6 +178,30 @@ void OutputConfig::load(FXSettings & settings) {
       break;
       }
     }
+
+  if (settings.readBoolEntry("engine","low-latency",false))
+    flags|=LowLatency;
+  else
+    flags&=~LowLatency;
+
+  if (settings.readBoolEntry("engine","parallel-decode",false))
+    flags|=ParallelDecode;
+  else
+    flags&=~ParallelDecode;
+
+  resampler=FXCLAMP(ResamplerOff,settings.readIntEntry("engine","resampler",ResamplerOff),ResamplerBest);
+
+  fixed_rate=FXMAX(0,settings.readIntEntry("engine","fixed-rate",0));
+  fixed_channels=FXCLAMP(1,settings.readIntEntry("engine","fixed-channels",2),8);
+
+  FXString format=settings.readStringEntry("engine","fixed-format","s32");
+  if (format=="s16")
+    fixed_format=FixedFormatS16;
+  else if (format=="float")
+    fixed_format=FixedFormatFloat;
+  else
+    fixed_format=FixedFormatS32;
+
   alsa.load(settings);
   oss.load(settings);
   sndio.load(settings);
@@ -196,6 +220,17 @@ void OutputConfig::save(FXSettings & settings) const {
   else
     settings.deleteEntry("engine","output");
 
+  settings.writeBoolEntry("engine","low-latency",flags&LowLatency);
+  settings.writeBoolEntry("engine","parallel-decode",flags&ParallelDecode);
+  settings.writeIntEntry("engine","resampler",resampler);
+  settings.writeIntEntry("engine","fixed-rate",fixed_rate);
+  settings.writeIntEntry("engine","fixed-channels",fixed_channels);
+  switch(fixed_format) {
+    case FixedFormatS16  : settings.writeStringEntry("engine","fixed-format","s16");   break;
+    case FixedFormatFloat: settings.writeStringEntry("engine","fixed-format","float"); break;
+    default              : settings.writeStringEntry("engine","fixed-format","s32");   break;
+    }
+
   alsa.save(settings);
   oss.save(settings);
   sndio.save(settings);
@@ -24,7 +24,7 @@
 
 namespace ap {
 
-AudioEngine::AudioEngine() : fifo(nullptr) {
+AudioEngine::AudioEngine() : fifo(nullptr), decode_threads(0) {
   input   = new InputThread(this);
   decoder = new DecoderThread(this);
   output  = new OutputThread(this);
@@ -34,6 +34,7 @@ public:
   EngineThread  * input;
   DecoderThread * decoder;
   EngineThread  * output;
+  volatile FXint  decode_threads; // Threads available to decoders, set by the player
 public:
   AudioEngine();
 
@@ -42,6 +42,7 @@ enum EventTypePrivate {
   Ctrl_Set_Cross_Fade,
   Ctrl_Get_Cross_Fade,
   Ctrl_Volume,
+  Ctrl_Prefetch,
 
   Buffer,
   Configure,
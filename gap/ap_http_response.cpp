@@ -726,6 +726,69 @@ FXString HttpResponse::textBody() {
   }
 
 
+// Stream the full message body into sink using fixed size buffers
+FXbool HttpResponse::body(HttpSink & sink) {
+  const FXival BLOCK = 4096;
+  FXchar buffer[BLOCK];
+  FXival n;
+
+  if (flags&HeadRequest)
+    return true;
+
+  if (flags&ContentEncodingGZip) {
+#ifdef HAVE_ZLIB
+    FXchar   output[4*BLOCK];
+    z_stream stream;
+    int      zerror=Z_OK;
+
+    memset(&stream,0,sizeof(stream));
+    if (inflateInit2(&stream,15+16)!=Z_OK)
+      return false;
+
+    while(zerror!=Z_STREAM_END && (n=readBody(buffer,BLOCK))>0) {
+      stream.next_in  = (Bytef*)buffer;
+      stream.avail_in = n;
+      do {
+        stream.next_out  = (Bytef*)output;
+        stream.avail_out = sizeof(output);
+
+        zerror = inflate(&stream,Z_NO_FLUSH);
+        if (zerror!=Z_OK && zerror!=Z_STREAM_END && zerror!=Z_BUF_ERROR) {
+          GM_DEBUG_PRINT("[http] body() - inflate failed %d\n",zerror);
+          inflateEnd(&stream);
+          return false;
+          }
+
+        const FXival nout = sizeof(output) - stream.avail_out;
+        if (nout>0 && !sink.write(output,nout)) {
+          inflateEnd(&stream);
+          return false;
+          }
+        }
+      while(stream.avail_out==0 && zerror!=Z_STREAM_END);
+      }
+    inflateEnd(&stream);
+
+    if (zerror!=Z_STREAM_END)
+      return false;
+
+    // Consume anything after the end of the gzip stream
+    while(readBody(buffer,BLOCK)>0) ;
+    return true;
+#else
+    return false;
+#endif
+    }
+  else {
+    while((n=readBody(buffer,BLOCK))>0) {
+      if (!sink.write(buffer,n))
+        return false;
+      }
+    return (n==0);
+    }
+  }
+
+
 FXival HttpResponse::readBody(void * ptr,FXival len) {
   if (flags&HeadRequest)
     return 0;
@@ -25,6 +25,7 @@ namespace ap {
 
 extern InputPlugin * ap_file_plugin(IOContext * context);
 extern InputPlugin * ap_http_plugin(IOContext * context);
+extern void ap_file_prefetch(const FXString & url);
 
   /// Open plugin for given url
 InputPlugin* InputPlugin::open(IOContext * ctx,const FXString & url) {
@@ -52,6 +53,13 @@ InputPlugin* InputPlugin::open(IOContext * ctx,const FXString & url) {
   }
 
 
+void InputPlugin::prefetch(const FXString & url) {
+  FXString scheme = FXURL::scheme(url);
+  if (scheme.empty() || scheme=="file")
+    ap_file_prefetch(url);
+  }
+
+
 
 
 FXbool InputPlugin::read_uint24_be(FXuint & value) {
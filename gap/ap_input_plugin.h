@@ -79,6 +79,9 @@ public:
   /// End of Input
   virtual FXbool eof()=0;
 
+  /// File information. Returns false if the input isn't a file.
+  virtual FXbool stat(FXStat &) { return false; }
+
   /// Serial
   virtual FXbool serial() const=0;
 
@@ -88,6 +91,9 @@ public:
   /// Open plugin for given url
   static InputPlugin* open(IOContext * ctx,const FXString & url);
 
+  /// Store the head of url in the head cache
+  static void prefetch(const FXString & url);
+
   /// Destructor
   virtual ~InputPlugin() {}
   };
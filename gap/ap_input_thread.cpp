@@ -28,6 +28,9 @@
 
 namespace ap {
 
+// Maximum number of urls waiting to be prefetched
+static const FXint max_prefetch = 16;
+
 
 InputThread::InputThread(AudioEngine*e) : EngineThread(e),
   input(nullptr),
@@ -80,10 +83,20 @@ FXint InputThread::run(){
   ap_set_thread_name("ap_input");
 
   for (;;) {
-    if (reader && state==StateProcessing)
+    if (reader && state==StateProcessing) {
       event = wait_for_packet();
-    else
-      event = fifo.wait();
+      }
+    else {
+      // Prefetch queued files while there's nothing else to do
+      event = fifo.pop();
+      if (event==nullptr) {
+        if (prefetch.no()) {
+          ctrl_prefetch();
+          continue;
+          }
+        event = fifo.wait();
+        }
+      }
 
     switch(event->type) {
       case Ctrl_Close     : ctrl_flush(true);
@@ -100,6 +113,8 @@ FXint InputThread::run(){
                             break;
       case Ctrl_Seek      : ctrl_seek(static_cast<CtrlSeekEvent*>(event)->pos);
                             break;
+      case Ctrl_Prefetch  : ctrl_queue_prefetch(static_cast<ControlEvent*>(event)->text);
+                            break;
       case End            : if (event->stream==stream) {
                               ctrl_eos();
                               }
@@ -154,6 +169,22 @@ void InputThread::ctrl_eos() {
     }
   }
 
+void InputThread::ctrl_queue_prefetch(const FXString & url) {
+  for (FXint i=0;i<prefetch.no();i++) {
+    if (prefetch[i]==url) return;
+    }
+  // Keep the most recent requests
+  if (prefetch.no()>=max_prefetch)
+    prefetch.erase(0);
+  prefetch.append(url);
+  }
+
+void InputThread::ctrl_prefetch() {
+  FXString url = prefetch[0];
+  prefetch.erase(0);
+  InputPlugin::prefetch(url);
+  }
+
 void InputThread::ctrl_seek(FXdouble pos) {
   FXlong offset;
   if (reader && !input->serial() && reader->can_seek()) {
@@ -38,6 +38,7 @@ protected:
   InputPlugin  * input;
   ReaderPlugin * reader;
   FXuchar        state;
+  FXStringList   prefetch;     // urls waiting to be prefetched
 
 protected:
   enum {
@@ -69,6 +70,9 @@ protected:
 
   void ctrl_eos();
 
+  void ctrl_queue_prefetch(const FXString & url);
+  void ctrl_prefetch();
+
 public:
   void post_configuration(ConfigureEvent*) override;
 
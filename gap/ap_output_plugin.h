@@ -75,6 +75,17 @@ public:
   /// Write frames to playback buffer
   virtual FXbool write(const void*, FXuint)=0;
 
+  /// Map at most nframes of the playback buffer for writing. On return
+  /// nframes holds the number of frames that may be written. Returns
+  /// nullptr if the buffer couldn't be mapped.
+  virtual FXuchar * map(FXuint & nframes) { nframes=0; return nullptr; }
+
+  /// Commit nframes written to the mapped playback buffer
+  virtual FXbool commit(FXuint) { return false; }
+
+  /// Whether map and commit can be used instead of write
+  virtual FXbool mappable() const { return false; }
+
   /// Return delay in no. of frames
   virtual FXint delay() { return 0; }
 
@@ -35,20 +35,22 @@
 #error "AP_PLUGIN_PATH PATH not defined"
 #endif
 
-#ifdef HAVE_SAMPLERATE
-#include <samplerate.h>
-#endif
-
 namespace ap {
 
 
 class FrameTimer {
+public:
+  FrameTimer * next = nullptr;
 private:
   FXint nold;
   FXint nwait;
   FXint nwritten;
 public:
-  FrameTimer(FXint n) : nold(n),nwait(n),nwritten(0) {
+  FrameTimer(FXint n) { set(n); }
+
+  void set(FXint n) {
+    nold=nwait=n;
+    nwritten=0;
     GM_DEBUG_PRINT("[output] frame timer set to %d\n",nwait);
     }
 
@@ -98,15 +100,18 @@ public:
 
   virtual void execute(AudioEngine*) {}
 
+  /// Called once the timer is done with. Reusable timers put themselves on the free list.
+  virtual void release(FrameTimer *&) { delete this; }
+
   virtual ~FrameTimer() {}
   };
 
 
 class MetaTimer : public FrameTimer {
 public:
-  Event  * meta;
+  Event  * meta = nullptr;
 public:
-  MetaTimer(Event * m,FXint n) : FrameTimer(n), meta(m) {}
+  MetaTimer() : FrameTimer(0) {}
   ~MetaTimer() {
     if (meta)
       meta->unref();
@@ -116,6 +121,15 @@ public:
     engine->post(meta);
     meta=nullptr;
     }
+
+  void release(FrameTimer *& freelist) {
+    if (meta) {
+      meta->unref();
+      meta=nullptr;
+      }
+    next=freelist;
+    freelist=this;
+    }
   };
 
 
@@ -129,6 +143,70 @@ public:
   };
 
 
+/*
+  TimeUpdates are posted to the application about once a second. Instead of
+  allocating a new one each time, they're recycled through a lock free queue
+  once the application is done with them. The pool is shared between the
+  output thread and every event still in flight, so it's reference counted
+  and deleted by whoever lets go of it last.
+*/
+class PooledTimeUpdate : public TimeUpdate {
+  friend class TimeUpdatePool;
+protected:
+  TimeUpdatePool * pool;
+protected:
+  PooledTimeUpdate(TimeUpdatePool * p) : TimeUpdate(0,0), pool(p) {}
+  ~PooledTimeUpdate() {}
+public:
+  void unref() override;
+  };
+
+
+class TimeUpdatePool {
+protected:
+  FXLFQueueOf<PooledTimeUpdate> events;
+  volatile FXint                refs;
+protected:
+  ~TimeUpdatePool() {
+    PooledTimeUpdate * event = nullptr;
+    while(events.pop(event)) delete event;
+    }
+public:
+  TimeUpdatePool(FXint n) : refs(1) {
+    events.setSize(16);
+    for (FXint i=0;i<n;i++) {
+      events.push(new PooledTimeUpdate(this));
+      }
+    }
+
+  // Get an event from the pool, only allocates if the pool ran dry
+  TimeUpdate * get(FXuint position,FXuint length) {
+    PooledTimeUpdate * event = nullptr;
+    if (!events.pop(event)) {
+      event = new PooledTimeUpdate(this);
+      }
+    atomicAdd(&refs,1);
+    event->position = position;
+    event->length   = length;
+    return event;
+    }
+
+  void push(PooledTimeUpdate * event) {
+    if (!events.push(event)) delete event;
+    release();
+    }
+
+  void release() {
+    if (atomicAdd(&refs,-1)==1) delete this;
+    }
+  };
+
+
+void PooledTimeUpdate::unref() {
+  pool->push(this);
+  }
+
+
 OutputThread::OutputThread(AudioEngine*e) : EngineThread(e), fifoinput(nullptr),plugin(nullptr),draining(false),pausing(false) {
   stream=-1;
   stream_length=0;
@@ -143,6 +221,8 @@ FXbool OutputThread::init() {
   if (EngineThread::init()) {
     fifoinput=new Reactor::Input(fifo.signal().handle(),Reactor::Input::Readable);
     reactor.addInput(fifoinput);
+    if (timeupdates==nullptr)
+      timeupdates=new TimeUpdatePool(8);
     return true;
     }
   return false;
@@ -154,13 +234,21 @@ OutputThread::~OutputThread() {
   reactor.removeInput(fifoinput);
   delete fifoinput;
   clear_timers();
+  while(freetimers) {
+    FrameTimer * timer = freetimers;
+    freetimers = timer->next;
+    delete timer;
+    }
+  if (timeupdates)
+    timeupdates->release();
   if (crossfader)
     delete crossfader;
   }
 
 
 void OutputThread::reconfigure() {
-  AudioFormat old=af;
+  AudioFormat old = pinned ? stream_af : af;
+  pinned=false;
   af.reset();
   configure(old);
   }
@@ -174,7 +262,7 @@ void OutputThread::notify_position() {
     timestamp=tm;
     FXuint len =0;
     len = floor((double)stream_length / (double)plugin->af.rate);
-    engine->post(new TimeUpdate(timestamp,len));
+    engine->post(timeupdates->get(timestamp,len));
     }
   }
 
@@ -187,24 +275,108 @@ void OutputThread::notify_volume(FXfloat value) {
   engine->post(new VolumeNotify(value));
   }
 
+void OutputThread::add_timer(FrameTimer * timer) {
+  timer->next=timers;
+  timers=timer;
+  }
+
+void OutputThread::add_meta_timer(Event * meta,FXint nframes) {
+  MetaTimer * timer;
+  if (freetimers) {
+    timer=static_cast<MetaTimer*>(freetimers);
+    freetimers=timer->next;
+    }
+  else {
+    timer=new MetaTimer();
+    }
+  timer->meta=meta;
+  timer->set(nframes);
+  add_timer(timer);
+  }
+
 void OutputThread::clear_timers() {
-  for (FXint i=0;i<timers.no();i++){
-    delete timers[i];
+  while(timers) {
+    FrameTimer * timer=timers;
+    timers=timer->next;
+    timer->release(freetimers);
     }
-  timers.clear();
   }
 
 void OutputThread::update_timers(FXint delay,FXint nframes) {
-  for (FXint i=timers.no()-1;i>=0;i--){
-    if (timers[i]->update(delay,nframes)) {
-      timers[i]->execute(engine);
-      delete timers[i];
-      timers.erase(i);
+  FrameTimer ** link=&timers;
+  while(*link) {
+    FrameTimer * timer=*link;
+    if (timer->update(delay,nframes)) {
+      *link=timer->next;
+      timer->execute(engine);
+      timer->release(freetimers);
+      }
+    else {
+      link=&timer->next;
       }
     }
   }
 
 
+/*
+  Reserve everything the output path may need while playing, so once the
+  thread is running there's nothing left to allocate. Decoded packets are
+  8192 bytes. Converting s24le3 to s32 grows them by a third and mono to
+  stereo doubles them. Resampling grows them by the rate ratio.
+*/
+void OutputThread::preallocate() {
+  samples.formatted.clear();
+  samples.formatted.reserve(2*8192);
+  samples.remapped.clear();
+  samples.remapped.reserve(4*8192);
+  resampled.clear();
+  resampled.reserve(8*8192);
+  samples.normalized.clear();
+  samples.normalized.reserve(16*8192);
+  FXint n=0;
+  for (FrameTimer * timer=freetimers;timer;timer=timer->next) n++;
+  for (;n<4;n++) {
+    MetaTimer * timer = new MetaTimer();
+    timer->release(freetimers);
+    }
+  }
+
+
+/*
+  Low latency mode runs the output thread with real-time priority and keeps
+  its memory locked. If we're not allowed to use SCHED_FIFO, fall back to
+  a lower nice value. Both need the appropriate rlimits (or CAP_SYS_NICE).
+*/
+void OutputThread::set_low_latency(FXbool enable) {
+  if (enable==lowlatency)
+    return;
+
+  lowlatency=enable;
+  if (lowlatency) {
+    GM_DEBUG_PRINT("[output] enable low latency mode\n");
+    preallocate();
+    saved_policy   = policy();
+    saved_priority = priority();
+    if (saved_policy==FXThread::PolicyError) saved_policy=FXThread::PolicyDefault;
+    if (saved_priority==FXThread::PriorityError) saved_priority=FXThread::PriorityDefault;
+    if (!policy(FXThread::PolicyFifo) || !priority(FXThread::PriorityHigher)) {
+      GM_DEBUG_PRINT("[output] unable to set real-time priority\n");
+      if (!ap_set_thread_nice(-10))
+        GM_DEBUG_PRINT("[output] unable to set nice value\n");
+      }
+    if (!ap_lock_memory(true))
+      GM_DEBUG_PRINT("[output] unable to lock memory\n");
+    }
+  else {
+    GM_DEBUG_PRINT("[output] disable low latency mode\n");
+    policy(saved_policy);
+    priority(saved_priority);
+    ap_set_thread_nice(0);
+    ap_lock_memory(false);
+    }
+  }
+
+
 
 
 void OutputThread::update_position(FXint sid,FXlong position,FXint nframes,FXlong length) {
@@ -475,6 +647,8 @@ void OutputThread::close_plugin() {
   if (plugin) {
     plugin->close();
     }
+  resampler.clear();
+  pinned=false;
   draining=false;
   af.reset();
   }
@@ -494,7 +668,10 @@ void OutputThread::configure(const AudioFormat & fmt) {
     }
   FXASSERT(plugin);
 
-  if (af==fmt || fmt==plugin->af){
+  if (configure_pinned(fmt))
+    return;
+
+  if (!pinned && (af==fmt || fmt==plugin->af || can_resample(fmt))){
     if (crossfader && crossfader->readable_frames()) {
       GM_DEBUG_PRINT("[crossfader] has buffer\n");
       if (af != fmt && !crossfader->convert(fmt)) {
@@ -507,7 +684,13 @@ void OutputThread::configure(const AudioFormat & fmt) {
         crossfader->recording = false;
         }
       }
+
+    // Keep the device open and convert the rate instead
+    if (!resampler.match(fmt,plugin->af.rate,output_config.resampler))
+      drain_resampler();
+
     af=fmt;
+    configure_resampler();
     draining=false;
 
 #ifdef DEBUG
@@ -529,8 +712,10 @@ void OutputThread::configure(const AudioFormat & fmt) {
     reset_crossfader();
     }
 
+  drain_resampler();
   drain();
 
+  pinned=false;
   af=fmt;
 
   if (!plugin->configure(af)) {
@@ -540,6 +725,10 @@ void OutputThread::configure(const AudioFormat & fmt) {
     return;
     }
 
+  // The device may not support the stream rate
+  resampler.clear();
+  configure_resampler();
+
 #ifdef DEBUG
   fxmessage("[output] stream ");
   af.debug();
@@ -551,6 +740,55 @@ void OutputThread::configure(const AudioFormat & fmt) {
   draining=false;
   }
 
+/*
+  With resampling enabled, streams that only differ in rate from the current
+  one don't reconfigure the device. It stays at its rate and the resampler
+  converts. The resampler state carries over between streams with the same
+  format, so gapless playback is preserved.
+*/
+FXbool OutputThread::can_resample(const AudioFormat & fmt) const {
+  return (output_config.resampler!=ResamplerOff &&
+          af.set() &&
+          fmt.format==af.format &&
+          fmt.channels==af.channels &&
+          fmt.channelmap==af.channelmap &&
+          Resampler::supported(fmt));
+  }
+
+
+void OutputThread::configure_resampler() {
+  if (output_config.resampler==ResamplerOff || af.rate==plugin->af.rate) {
+    resampler.clear();
+    return;
+    }
+  if (!resampler.match(af,plugin->af.rate,output_config.resampler))
+    resampler.init(af,plugin->af.rate,output_config.resampler);
+  }
+
+
+// Write out the frames still held back by the resampler
+void OutputThread::drain_resampler() {
+  if (resampler.active() && af.set()) {
+    samples.buffer    = &resampled;
+    samples.nframes   = resampler.drain(resampled);
+    samples.crossfade = false;
+    samples.deferred  = 0;
+    if (samples.nframes) {
+      if (pinned) format_samples();
+      if (convert_samples()) write_samples();
+      }
+    }
+  }
+
+
+void OutputThread::resample_samples() {
+  samples.nframes  = resampler.process(samples.data(),samples.nframes,resampled);
+  samples.buffer   = &resampled;
+  samples.position = resampler.position(samples.position);
+  samples.length   = resampler.position(samples.length);
+  }
+
+
 static FXbool mono_to_stereo(FXuchar * in,FXuint nsamples,FXuchar bps,MemoryBuffer & out){
   out.clear();
   out.reserve(nsamples*bps*2);
@@ -562,47 +800,128 @@ static FXbool mono_to_stereo(FXuchar * in,FXuint nsamples,FXuchar bps,MemoryBuff
   }
 
 
-#ifdef HAVE_SAMPLERATE
-void OutputThread::resample(Packet * packet,FXint & nframes) {
-  static SRC_STATE * src_state = nullptr;
-  SRC_DATA srcdata;
+/*
+  With a fixed output rate the device is opened once in the configured
+  format and stays that way. Every stream is resampled to the fixed rate,
+  converted to float and mapped onto the fixed channel layout before replay
+  gain and crossfading, so af never changes between tracks and crossfades
+  work across formats. Streams we can't map fall back to reconfiguring the
+  device.
+*/
+FXbool OutputThread::can_pin(const AudioFormat & fmt) const {
+  if (output_config.fixed_rate==0 || !Resampler::supported(fmt))
+    return false;
+  return (fmt.channels==output_config.fixed_channels) ||
+         (fmt.channels==1 && output_config.fixed_channels==2) ||
+         (fmt.channels==2 && output_config.fixed_channels==1);
+  }
 
-  FXint framesize = packet->af.framesize();
 
-  if (src_state==nullptr) {
-    int error;
-    src_state = src_new(SRC_SINC_BEST_QUALITY,packet->af.channels,&error);
-    }
+FXbool OutputThread::configure_pinned(const AudioFormat & fmt) {
+  const FXuchar quality = output_config.resampler ? output_config.resampler : (FXuchar)ResamplerMedium;
 
-//  src_input.clear();
-  src_input.append(packet->data(),packet->size());
+  if (!can_pin(fmt))
+    return false;
 
-  srcdata.data_in      = reinterpret_cast<FXfloat*>(src_input.data());
-  srcdata.input_frames = src_input.size() / packet->af.framesize();
-  srcdata.data_out     = reinterpret_cast<FXfloat*>(converted_samples.data());
-  srcdata.src_ratio    = (FXdouble)plugin->af.rate / (FXdouble)packet->af.rate;
-  srcdata.output_frames= (FXint)((FXdouble)srcdata.input_frames*srcdata.src_ratio);
-  srcdata.end_of_input = 0;
+  if (!pinned) {
+    if (crossfader && crossfader->readable_frames()) {
+      GM_DEBUG_PRINT("[crossfader] cannot crossfade, play remaining samples\n");
+      drain_crossfader();
+      reset_crossfader();
+      }
+    drain_resampler();
+    drain();
+
+    AudioFormat device;
+    switch(output_config.fixed_format) {
+      case FixedFormatS16  : device.set(AP_FORMAT_S16,output_config.fixed_rate,output_config.fixed_channels);   break;
+      case FixedFormatFloat: device.set(AP_FORMAT_FLOAT,output_config.fixed_rate,output_config.fixed_channels); break;
+      default              : device.set(AP_FORMAT_S32,output_config.fixed_rate,output_config.fixed_channels);   break;
+      }
 
-  converted_samples.reserve(framesize*srcdata.output_frames);
+    resampler.clear();
+    af.reset();
 
-  if (src_process(src_state,&srcdata)==0) {
-    fxmessage("converted %ld|%ld|%d\n",srcdata.output_frames_gen,srcdata.input_frames_used,packet->numFrames());
-    if (srcdata.input_frames_used) {
-      if ((srcdata.input_frames_used*framesize)<src_input.size())
-        src_input.trimBegin((srcdata.input_frames_used*framesize));
-      else
-        src_input.clear();
+    if (!plugin->configure(device)) {
+      plugin->drop();
+      close_plugin();
+      engine->input->post(new ControlEvent(Ctrl_Close));
+      return true;
       }
-    if (srcdata.output_frames_gen) {
-      nframes=srcdata.output_frames_gen;
+
+    // Samples are processed in float at the rate the device accepted
+    af.set(AP_FORMAT_FLOAT,plugin->af.rate,output_config.fixed_channels);
+    pinned=true;
+    }
+  else {
+    if (crossfader && crossfader->readable_frames()) {
+      GM_DEBUG_PRINT("[crossfader] switch to playback\n");
+      crossfader->recording = false;
+      }
+    if (!resampler.match(fmt,af.rate,quality))
+      drain_resampler();
+    }
+
+  stream_af=fmt;
+  if (stream_af.rate==af.rate)
+    resampler.clear();
+  else if (!resampler.match(stream_af,af.rate,quality))
+    resampler.init(stream_af,af.rate,quality);
+
+  draining=false;
+
+#ifdef DEBUG
+  fxmessage("[output] stream ");
+  stream_af.debug();
+  fxmessage("[output] plugin ");
+  plugin->af.debug();
+#endif
+  return true;
+  }
+
+
+// Resample to the pinned rate and convert to float with the pinned channels
+void OutputThread::normalize_samples() {
+  if (resampler.active())
+    resample_samples();
+  if (samples.nframes)
+    format_samples();
+  }
+
+
+void OutputThread::format_samples() {
+  const FXuint nsamples = samples.nframes * stream_af.channels;
+
+  switch(stream_af.format) {
+    case AP_FORMAT_S16  : s16_to_float(samples.data(), nsamples, samples.normalized);
+                          samples.buffer = &samples.normalized;
+                          break;
+    case AP_FORMAT_S24_3: s24le3_to_float(samples.data(), nsamples, samples.normalized);
+                          samples.buffer = &samples.normalized;
+                          break;
+    case AP_FORMAT_S32  : s32_to_float(samples.data(), nsamples, samples.normalized);
+                          samples.buffer = &samples.normalized;
+                          break;
+    default             : break;
+    }
+
+  if (stream_af.channels != af.channels) {
+    if (stream_af.channels == 1) {
+      mono_to_stereo(samples.data(), samples.nframes, 4, samples.remapped);
+      samples.buffer = &samples.remapped;
       }
     else {
-      nframes=0;
+      FXfloat * data = reinterpret_cast<FXfloat*>(samples.data());
+      for (FXint i=0;i<samples.nframes;i++)
+        data[i] = 0.5f * (data[2*i] + data[2*i+1]);
+      samples.buffer->trimEnd(samples.nframes * 4);
       }
     }
   }
-#endif
+
+
+
+
 
 void OutputThread::reset_position() {
   stream_position=0;
@@ -686,6 +1005,7 @@ void OutputThread::init_samples(Packet * packet) {
   samples.nframes = packet->numFrames();
   samples.stream = packet->stream;
   samples.crossfade = true;
+  samples.deferred = 0;
   }
 
 
@@ -697,11 +1017,19 @@ void OutputThread::init_crossfade_samples() {
   samples.nframes = crossfader->buffer.size() / crossfader->af.framesize();
   samples.stream = crossfader->stream;
   samples.crossfade = false;
+  samples.deferred = 0;
   }
 
 
 void OutputThread::process_samples() {
 
+  // Crossfader samples are already in the pinned format
+  if (pinned && samples.crossfade) {
+    normalize_samples();
+    if (samples.nframes == 0)
+      return;
+    }
+
   replay_gain();
 
   if (crossfader && samples.crossfade) {
@@ -710,6 +1038,12 @@ void OutputThread::process_samples() {
       return;
     }
 
+  if (!pinned && resampler.active()) {
+    resample_samples();
+    if (samples.nframes == 0)
+      return;
+    }
+
   if (!convert_samples())
     return;
 
@@ -816,8 +1150,13 @@ bool OutputThread::convert_samples() {
               float_to_s32(samples.data(), samples.nframes * af.channels);
               break;
             case AP_FORMAT_S24_3:
-              s24le3_to_s32(samples.data(), samples.nframes * af.channels, samples.formatted);
-              samples.buffer = &samples.formatted;
+              if (plugin->mappable()) {
+                samples.deferred |= Samples::ExpandS24;
+                }
+              else {
+                s24le3_to_s32(samples.data(), samples.nframes * af.channels, samples.formatted);
+                samples.buffer = &samples.formatted;
+                }
               break;
             default:
               goto mismatch;
@@ -828,8 +1167,13 @@ bool OutputThread::convert_samples() {
     }
   if (af.channels != plugin->af.channels) {
     if (af.channels == 1 && plugin->af.channels == 2) {
-      mono_to_stereo(samples.data(), samples.nframes, af.packing(), samples.remapped);
-      samples.buffer = &samples.remapped;
+      if (plugin->mappable()) {
+        samples.deferred |= Samples::MonoToStereo;
+        }
+      else {
+        mono_to_stereo(samples.data(), samples.nframes, af.packing(), samples.remapped);
+        samples.buffer = &samples.remapped;
+        }
       }
     else {
       goto mismatch;
@@ -847,6 +1191,9 @@ mismatch:
 
 FXbool OutputThread::write_samples() {
   FXuint nframes;
+  if (plugin->mappable())
+    return map_samples();
+
   while (samples.nframes) {
     nframes = FXMIN(FXint(plugin->af.rate >> 1), samples.nframes);
     update_position(samples.stream, samples.position, nframes, samples.length);
@@ -865,6 +1212,55 @@ FXbool OutputThread::write_samples() {
 
 
 
+/*
+  Copy samples into the mapped device buffer, doing any deferred conversions
+  on the way. Output is in the plugin format, so when expanding mono to stereo
+  we first write the mono samples and then spread them out back to front.
+*/
+static void render_samples(FXuchar * out,const FXuchar * in,FXuint nframes,FXuchar deferred,const AudioFormat & af) {
+  const FXuint nsamples = nframes * ((deferred&Samples::MonoToStereo) ? 1 : af.channels);
+  const FXuint bps = af.packing();
+
+  if (deferred&Samples::ExpandS24)
+    s24le3_to_s32(in,nsamples,reinterpret_cast<FXint*>(out));
+  else
+    memcpy(out,in,nsamples*bps);
+
+  if (deferred&Samples::MonoToStereo) {
+    for (FXint i=nframes-1;i>=0;i--) {
+      memmove(out+(2*i+1)*bps,out+i*bps,bps);
+      memmove(out+(2*i)*bps,out+i*bps,bps);
+      }
+    }
+  }
+
+
+FXbool OutputThread::map_samples() {
+  const FXuint nchannels = (samples.deferred&Samples::MonoToStereo) ? 1 : plugin->af.channels;
+  const FXuint npacking  = (samples.deferred&Samples::ExpandS24) ? 3 : plugin->af.packing();
+  FXuint nframes;
+  FXuchar * out;
+  while (samples.nframes) {
+    nframes = FXMIN(FXint(plugin->af.rate >> 1), samples.nframes);
+    if ((out=plugin->map(nframes))==nullptr)
+      goto failed;
+    update_position(samples.stream, samples.position, nframes, samples.length);
+    render_samples(out, samples.data(), nframes, samples.deferred, plugin->af);
+    if (!plugin->commit(nframes))
+      goto failed;
+    samples.buffer->readBytes(nchannels * npacking * nframes);
+    samples.nframes -= nframes;
+    }
+  return true;
+failed:
+  GM_DEBUG_PRINT("[output] write failed\n");
+  engine->input->post(new ControlEvent(Ctrl_Close));
+  engine->post(new ErrorMessage(FXString::value("Output Error")));
+  close_plugin();
+  return false;
+  }
+
+
 FXint OutputThread::run(){
   pausing=false;
   draining=false;
@@ -897,6 +1293,7 @@ FXint OutputThread::run(){
           if (crossfader) {
             reset_crossfader();
             }
+          resampler.reset();
           pausing=false;
           draining=false;
           reset_position();
@@ -907,7 +1304,7 @@ FXint OutputThread::run(){
         {
           if (__likely(af.set())) {
             FXASSERT(plugin);
-            timers.append(new MetaTimer(event,plugin->delay()));
+            add_meta_timer(event,plugin->delay());
             continue;
             }
         } break;
@@ -929,7 +1326,7 @@ FXint OutputThread::run(){
             if (wait<=rate)
               engine->input->post(new Event(AP_EOS));
             else
-              timers.append(new EOSTimer(/*event->stream,*/wait-rate));
+              add_timer(new EOSTimer(/*event->stream,*/wait-rate));
 
             draining=true;
             }
@@ -960,6 +1357,7 @@ FXint OutputThread::run(){
           unload_plugin();
           Event::unref(event);
           clear_timers();
+          set_low_latency(false);
           return 0;
         } break;
 
@@ -1025,6 +1423,7 @@ FXint OutputThread::run(){
           GM_DEBUG_PRINT("[output] set output config");
           SetOutputConfig * out = static_cast<SetOutputConfig*>(event);
           output_config = out->config;
+          set_low_latency(output_config.flags&OutputConfig::LowLatency);
           if (plugin) {
             if (plugin->type()==output_config.device) {
               if (af.set()) {
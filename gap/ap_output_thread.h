@@ -22,6 +22,7 @@
 #include "ap_thread.h"
 #include "ap_event_private.h"
 #include "ap_buffer.h"
+#include "ap_resampler.h"
 #include "ap_output_plugin.h"
 
 
@@ -31,6 +32,7 @@ class AudioEngine;
 class Packet;
 class FrameTimer;
 class CrossFader;
+class TimeUpdatePool;
 
 struct ReplayGainConfig {
   ReplayGainMode  mode;
@@ -44,14 +46,20 @@ struct ReplayGainConfig {
 
 
 struct Samples {
+  enum {
+    ExpandS24    = 0x1,  // s24le3 to s32 while writing to the device
+    MonoToStereo = 0x2   // duplicate mono channel while writing to the device
+    };
   MemoryBuffer * buffer = nullptr;
   MemoryBuffer   remapped;
   MemoryBuffer   formatted;
+  MemoryBuffer   normalized;
   FXint          nframes;
   FXlong         position;
   FXlong         length;
   FXuint         stream;
   FXbool         crossfade;
+  FXuchar        deferred = 0;
   FXuchar * data() const { return buffer->data();}
 };
 
@@ -76,14 +84,13 @@ protected:
   Event * get_next_event();
 public:
   AudioFormat       af;
+  AudioFormat       stream_af;   // stream format while the device format is pinned
+  FXbool            pinned = false;
   OutputPlugin *    plugin;
   FXDLL             dll;
   Samples           samples;
-#ifdef HAVE_SAMPLERATE
-  MemoryBuffer      converted_samples;
-  MemoryBuffer      src_input;
-  MemoryBuffer      src_output;
-#endif
+  Resampler         resampler;
+  MemoryBuffer      resampled;
   ReplayGainConfig  replaygain;
   CrossFader * crossfader = nullptr;
 protected:
@@ -97,28 +104,44 @@ protected:
   FXlong    stream_position;
   FXint     timestamp;
 protected:
-  FXPtrListOf<FrameTimer> timers;
+  FrameTimer *     timers     = nullptr;
+  FrameTimer *     freetimers = nullptr;
+  TimeUpdatePool * timeupdates = nullptr;
+  FXbool           lowlatency = false;
+  FXThread::Policy   saved_policy   = FXThread::PolicyDefault;   // scheduling before low latency mode
+  FXThread::Priority saved_priority = FXThread::PriorityDefault;
+  void add_meta_timer(Event*,FXint nframes);
+  void add_timer(FrameTimer*);
   void update_timers(FXint delay,FXint nframes);
   void clear_timers();
+protected:
+  void set_low_latency(FXbool enable);
+  void preallocate();
 protected:
   void init_samples(Packet*);
   void init_crossfade_samples();
   void process_samples();
   void crossfade_samples();
+  void resample_samples();
+  void normalize_samples();
+  void format_samples();
   FXbool convert_samples();
   FXbool write_samples();
+  FXbool map_samples();
   void replay_gain();
 protected:
   void reset_crossfader();
   void drain_crossfader();
 protected:
   void configure(const AudioFormat&);
+  FXbool can_resample(const AudioFormat&) const;
+  FXbool can_pin(const AudioFormat&) const;
+  FXbool configure_pinned(const AudioFormat&);
+  void configure_resampler();
+  void drain_resampler();
   void load_plugin();
   void unload_plugin();
   void close_plugin();
-#ifdef HAVE_SAMPLERATE
-  void resample(Packet*,FXint & nframes);
-#endif
   void drain(FXbool flush=true);
   void update_position(FXint stream,FXlong position,FXint nframes,FXlong length);
   void notify_position();
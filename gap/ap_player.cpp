@@ -67,6 +67,11 @@ void AudioPlayer::open(const FXString & url,FXbool flush) {
   engine->input->post(new ControlEvent(flush ? Ctrl_Open_Flush : Ctrl_Open,url),EventQueue::Flush);
   }
 
+void AudioPlayer::prefetch(const FXString & url) {
+  FXASSERT(engine->input->running());
+  engine->input->post(new ControlEvent(Ctrl_Prefetch,url));
+  }
+
 void AudioPlayer::close() {
   FXASSERT(engine->input->running());
   /// EventQueue::Flush => pending commands should not be executed
@@ -100,6 +105,11 @@ void AudioPlayer::getOutputConfig(OutputConfig & config) const{
 
 void AudioPlayer::setOutputConfig(const OutputConfig & config) {
   FXASSERT(engine->output->running());
+
+  // Picked up by the decoder on the next configure. This isn't sent as an
+  // event, since any pending event interrupts the decoder mid stream.
+  atomicSet(&engine->decode_threads,(config.flags&OutputConfig::ParallelDecode) ? FXMIN(FXThread::processors(),8) : 0);
+
   engine->output->post(new SetOutputConfig(config),EventQueue::Front);
   }
 
@@ -24,29 +24,79 @@
 #else
 #if defined(__linux__)
 #define HAVE_PPOLL // On Linux we have ppoll
+#define HAVE_EPOLL // and epoll
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE
 #endif
 #include <signal.h>
+#include <sys/epoll.h>
 #endif
 #include <poll.h>
 #include <errno.h>
+#include <unistd.h>
 #endif
 
+/*
+  Notes:
+
+  - On Linux inputs are registered with epoll when they're added and only updated
+    when their mode changes (Input::setMode/enable/disable). Each iteration only
+    has to deal with the inputs that actually signalled. Native inputs (alsa mixer)
+    are still polled, together with the epoll handle.
+
+  - Epoll only allows one registration per handle. Each handle gets a Watch with
+    the inputs sharing it. The watch is registered with the union of their modes
+    and is passed back by epoll, so signalling doesn't need to search the inputs.
+
+  - Timers are kept in a binary heap so adding, removing and finding the next
+    timer are independent of the number of active timers.
+*/
+
 namespace ap {
 
-Reactor::Reactor() : pfds(nullptr),nfds(0),mfds(0), timers(nullptr) {
+#ifdef HAVE_EPOLL
+#define MAX_EPOLL_EVENTS 32
+
+struct Reactor::Watch {
+  FXInputHandle      handle;
+  FXuchar            registered = 0;  // events registered with epoll
+  FXPtrListOf<Input> inputs;          // inputs on this handle
+  Watch(FXInputHandle h) : handle(h) {}
+  };
+#endif
+
+Reactor::Reactor() : pfds(nullptr),nfds(0),mfds(0),
+#ifdef HAVE_EPOLL
+  epfd(BadHandle),events(nullptr),nevents(0),mevents(MAX_EPOLL_EVENTS),
+#endif
+  timers(nullptr),ntimers(0),mtimers(0) {
+#ifdef HAVE_EPOLL
+  epfd = epoll_create1(EPOLL_CLOEXEC);
+  allocElms(events,mevents);
+#endif
   }
 
 Reactor::~Reactor() {
   freeElms(pfds);
 
+#ifdef HAVE_EPOLL
+  freeElms(events);
+  if (epfd!=BadHandle) ::close(epfd);
+#endif
+
   /// Delete all inputs
   for (FXint i=0;i<inputs.no();i++){
     delete inputs[i];
     }
   inputs.clear();
 
+#ifdef HAVE_EPOLL
+  for (FXint i=0;i<watches.no();i++){
+    delete watches[i];
+    }
+  watches.clear();
+#endif
+
   /// Delete all deferred
   for (FXint i=0;i<deferred.no();i++){
     delete deferred[i];
@@ -54,24 +104,63 @@ Reactor::~Reactor() {
   deferred.clear();
 
   /// Delete all timers
-  while(timers) {
-    Timer * n = timers->next;
-    delete timers;
-    timers=n;
+  for (FXint i=0;i<ntimers;i++){
+    delete timers[i];
     }
-
+  freeElms(timers);
   }
 
 #ifdef DEBUG
 void Reactor::debug() {
-  int ntimers = 0;
-  for (Timer * t=timers;t;t=t->next) ntimers++;
   fxmessage("[reactor] timers=%d inputs=%ld deferred=%ld\n",ntimers,inputs.no(),deferred.no());
   }
 #endif
 
+
+void Reactor::heapUp(FXint i) {
+  Timer * t = timers[i];
+  while(i>0) {
+    FXint p = (i-1)>>1;
+    if (timers[p]->time<=t->time) break;
+    timers[i]=timers[p];
+    timers[i]->index=i;
+    i=p;
+    }
+  timers[i]=t;
+  t->index=i;
+  }
+
+
+void Reactor::heapDown(FXint i) {
+  Timer * t = timers[i];
+  FXint c;
+  while((c=(i<<1)+1)<ntimers) {
+    if (c+1<ntimers && timers[c+1]->time<timers[c]->time) c++;
+    if (t->time<=timers[c]->time) break;
+    timers[i]=timers[c];
+    timers[i]->index=i;
+    i=c;
+    }
+  timers[i]=t;
+  t->index=i;
+  }
+
+
+void Reactor::dispatchTimers() {
+  FXTime now = FXThread::time();
+
+  // Only run timers that expired before we started. Timers
+  // rescheduled from onExpired will run next iteration.
+  for (FXint n=ntimers;n>0 && ntimers && timers[0]->time<=now;n--) {
+    Timer * t = timers[0];
+    removeTimer(t);
+    t->onExpired();
+    }
+  }
+
+
 void Reactor::dispatch() {
-#ifdef _WIN32
+#if defined(_WIN32)
   if (result>=WAIT_OBJECT_0 && result<(WAIT_OBJECT_0+nfds)) {
     FXint obj = 0;
     for (FXint i=0;i<inputs.no();i++) {
@@ -87,6 +176,39 @@ void Reactor::dispatch() {
       obj++;
       }
     }
+#elif defined(HAVE_EPOLL)
+  FXint i,j;
+
+  for (i=0;i<nevents;i++) {
+    Watch * watch = static_cast<Watch*>(events[i].data.ptr);
+    if (watch==nullptr) continue;
+
+    // Signal every input on the handle
+    for (j=0;j<watch->inputs.no();j++) {
+      signalled.append(watch->inputs[j]);
+      }
+
+    // Inputs may get removed by onSignal. removeInput clears their slot.
+    for (j=0;j<signalled.no();j++) {
+      Input * input = signalled[j];
+      if (input && (input->mode&Input::Disabled)==0 && (input->mode&(Input::Readable|Input::Writable|Input::Exception))) {
+        const FXuchar signal = (((events[i].events&EPOLLIN)  && (input->mode&Input::Readable)) ? Input::IsReadable : 0) |
+                               (((events[i].events&EPOLLOUT) && (input->mode&Input::Writable)) ? Input::IsWritable : 0) |
+                               ((events[i].events&(EPOLLERR|EPOLLHUP))                         ? Input::IsException: 0);
+        if (signal) {
+          input->mode|=signal;
+          input->onSignal();
+          }
+        }
+      }
+    signalled.clear();
+    }
+
+  FXint offset=1;
+  for (i=0;i<native.no();i++){
+    native[i]->dispatch(pfds+offset);
+    offset+=native[i]->no();
+    }
 #else
   FXint i;
 
@@ -105,17 +227,55 @@ void Reactor::dispatch() {
     offset+=native[i]->no();
     }
 #endif
-  FXTime now = FXThread::time();
-  for (Timer * t = timers;t;t=t->next) {
-    if (t->time>0 && t->time<=now) {
-      t->time=0;
-      t->onExpired();
-      if (timers==nullptr) break;
-      t = timers; // so onExpired can remove itself from the list...
+  dispatchTimers();
+  }
+
+
+#ifdef HAVE_EPOLL
+
+void Reactor::wait(FXTime timeout) {
+  FXint n;
+
+  nevents=0;
+
+  // Wait directly on epoll
+  if (nfds==1) {
+    const int ms = (timeout>=0) ? (int)((timeout+NANOSECONDS_PER_MILLISECOND-1)/NANOSECONDS_PER_MILLISECOND) : -1;
+    do {
+      n = epoll_wait(epfd,events,mevents,ms);
       }
+    while(n==-1 && errno==EINTR);
+    if (n>0) nevents=n;
+    return;
+    }
+
+  // Native inputs need to be polled together with the epoll handle
+  if (timeout>=0) {
+    struct timespec ts;
+    ts.tv_sec  = timeout / NANOSECONDS_PER_SECOND;
+    ts.tv_nsec = timeout % NANOSECONDS_PER_SECOND;
+    do {
+      n = ppoll(pfds,nfds,&ts,nullptr);
+      }
+    while(n==-1 && errno==EINTR);
+    }
+  else {
+    do {
+      n = ppoll(pfds,nfds,nullptr,nullptr);
+      }
+    while(n==-1 && errno==EINTR);
+    }
+
+  if (n>0 && pfds[0].revents) {
+    do {
+      n = epoll_wait(epfd,events,mevents,0);
+      }
+    while(n==-1 && errno==EINTR);
+    if (n>0) nevents=n;
     }
   }
 
+#else
 
 void Reactor::wait(FXTime timeout) {
 #ifdef _WIN32
@@ -150,10 +310,13 @@ void Reactor::wait(FXTime timeout) {
 #endif
   }
 
+#endif
+
+
 FXTime Reactor::prepare() {
   FXTime timeout;
   FXint i;
-#ifdef _WIN32
+#if defined(_WIN32)
   nfds = inputs.no();
   if (nfds>mfds) {
     mfds=nfds;
@@ -170,6 +333,38 @@ FXTime Reactor::prepare() {
     pfds[i] = inputs[i]->handle;
     inputs[i]->mode&=~(Input::IsReadable|Input::IsWritable|Input::IsException);
     }
+#elif defined(HAVE_EPOLL)
+
+  // Reset the inputs that signalled last time
+  for (FXint e=0;e<nevents;e++) {
+    Watch * watch = static_cast<Watch*>(events[e].data.ptr);
+    if (watch) {
+      for (i=0;i<watch->inputs.no();i++)
+        watch->inputs[i]->mode&=~(Input::IsReadable|Input::IsWritable|Input::IsException);
+      }
+    }
+  nevents=0;
+
+  nfds = 1;
+  for (i=0;i<native.no();i++) nfds+=native[i]->no();
+
+  if (nfds>mfds) {
+    mfds=nfds;
+    if (pfds==nullptr)
+      allocElms(pfds,mfds);
+    else
+      resizeElms(pfds,mfds);
+    }
+
+  pfds[0].fd      = epfd;
+  pfds[0].events  = POLLIN;
+  pfds[0].revents = 0;
+
+  FXint offset = 1;
+  for (i=0;i<native.no();i++) {
+    native[i]->prepare(pfds+offset);
+    offset+=native[i]->no();
+    }
 #else
   nfds = inputs.no();
   for (i=0;i<native.no();i++) nfds+=native[i]->no();
@@ -205,14 +400,13 @@ FXTime Reactor::prepare() {
     offset+=native[i]->no();
     }
 #endif
-  FXTime now = FXThread::time();
-  Timer * t = timers;
-  while(t && t->time<now) t=t->next;
-  if (t)
-    timeout = t->time - now;
-  else
+  if (ntimers) {
+    FXTime now = FXThread::time();
+    timeout = FXMAX(timers[0]->time - now,0);
+    }
+  else {
     timeout = -1;
-
+    }
   return timeout;
   }
 
@@ -228,28 +422,126 @@ void Reactor::removeNative(Native*n){
 
 void Reactor::addInput(Input*w) {
   inputs.append(w);
+  w->reactor = this;
+#ifdef HAVE_EPOLL
+  // Share the watch with other inputs on the same handle
+  for (FXint i=0;i<watches.no();i++) {
+    if (watches[i]->handle==w->handle) {
+      w->watch = watches[i];
+      break;
+      }
+    }
+  if (w->watch==nullptr) {
+    w->watch = new Watch(w->handle);
+    watches.append(w->watch);
+    }
+  w->watch->inputs.append(w);
+#endif
+  updateInput(w);
   }
 
 void Reactor::removeInput(Input*w){
   inputs.remove(w);
+#ifdef HAVE_EPOLL
+  Watch * watch = w->watch;
+  if (watch) {
+    watch->inputs.remove(w);
+
+    // Leave the handle to any remaining inputs sharing it
+    updateWatch(watch);
+    if (watch->inputs.no()==0) {
+      for (FXint i=0;i<nevents;i++) {
+        if (events[i].data.ptr==watch) events[i].data.ptr=nullptr;
+        }
+      watches.remove(watch);
+      delete watch;
+      }
+    }
+
+  // Make sure we don't dispatch a removed input
+  for (FXint i=0;i<signalled.no();i++) {
+    if (signalled[i]==w) {
+      w->mode&=~(Input::IsReadable|Input::IsWritable|Input::IsException);
+      signalled[i]=nullptr;
+      }
+    }
+  w->watch = nullptr;
+#endif
+  w->reactor = nullptr;
+  }
+
+void Reactor::updateInput(Input*w) {
+#ifdef HAVE_EPOLL
+  if (w->watch) updateWatch(w->watch);
+#else
+  (void)w;
+#endif
   }
 
 
+#ifdef HAVE_EPOLL
+
+// Register the union of the modes of all inputs on the watch
+void Reactor::updateWatch(Watch * watch) {
+  FXuchar interest = 0;
+
+  for (FXint i=0;i<watch->inputs.no();i++) {
+    if ((watch->inputs[i]->mode&Input::Disabled)==0)
+      interest|=(watch->inputs[i]->mode&(Input::Readable|Input::Writable|Input::Exception));
+    }
+
+  if (interest!=watch->registered) {
+    struct epoll_event ev;
+    ev.data.ptr = watch;
+    ev.events   = ((interest&Input::Readable)  ? EPOLLIN : 0) |
+                  ((interest&Input::Writable)  ? EPOLLOUT : 0) |
+                  ((interest&Input::Exception) ? EPOLLERR|EPOLLHUP : 0);
+    if (interest==0) {
+      epoll_ctl(epfd,EPOLL_CTL_DEL,watch->handle,nullptr);
+      }
+    else if (watch->registered==0) {
+      if (epoll_ctl(epfd,EPOLL_CTL_ADD,watch->handle,&ev)==-1) {
+        GM_DEBUG_PRINT("[reactor] failed to add input %d (errno %d)\n",watch->handle,errno);
+        interest=0;
+        }
+      }
+    else if (epoll_ctl(epfd,EPOLL_CTL_MOD,watch->handle,&ev)==-1) {
+      GM_DEBUG_PRINT("[reactor] failed to update input %d (errno %d)\n",watch->handle,errno);
+      }
+    watch->registered = interest;
+    }
+  }
+
+#endif
+
+
 
 void Reactor::addTimer(Timer*t,FXTime time) {
+  if (t->index>=0) removeTimer(t);
   t->time = time;
-  Timer**tt;
-  for (tt=&timers;*tt &&((*tt)->time<t->time);tt=&(*tt)->next) {}
-  t->next=*tt;
-  *tt=t;
+  if (ntimers==mtimers) {
+    mtimers = FXMAX(mtimers<<1,16);
+    if (timers==nullptr)
+      allocElms(timers,mtimers);
+    else
+      resizeElms(timers,mtimers);
+    }
+  timers[ntimers]=t;
+  t->index=ntimers++;
+  heapUp(t->index);
   }
 
 void Reactor::removeTimer(Timer*timer) {
-  for (Timer**tt=&timers;*tt;tt=&(*tt)->next){
-    if ((*tt)==timer){
-      Timer * next = (*tt)->next;
-      *tt=next;
-      break;
+  const FXint i = timer->index;
+  if (i>=0 && i<ntimers && timers[i]==timer) {
+    timer->index=-1;
+    ntimers--;
+    if (i<ntimers) {
+      Timer * moved = timers[ntimers];
+      timers[i]=moved;
+      moved->index=i;
+      heapDown(i);
+      heapUp(moved->index);
       }
     }
   }
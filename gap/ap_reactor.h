@@ -23,15 +23,27 @@
 struct pollfd;
 #endif
 
+#if defined(__linux__)
+struct epoll_event;
+#endif
+
 namespace ap {
 
 class GMAPI Reactor {
 private:
-#ifdef _WIN32
+#if defined(_WIN32)
   FXInputHandle * pfds;
   FXint    nfds;
   FXint    mfds;
   FXuint   result;
+#elif defined(__linux__)
+  struct pollfd      * pfds;    // epoll handle + native inputs
+  FXint                nfds;
+  FXint                mfds;
+  FXInputHandle        epfd;    // epoll handle
+  struct epoll_event * events;  // events returned by last wait
+  FXint                nevents;
+  FXint                mevents;
 #else
   struct pollfd * pfds;
   FXint nfds;
@@ -57,7 +69,13 @@ public:
     };
 #endif
 
+  struct Watch;
+
   class Input {
+    friend class Reactor;
+    private:
+      Reactor *     reactor    = nullptr; // reactor we're registered with
+      Watch *       watch      = nullptr; // backend registration, shared by inputs on the same handle
     public:
       FXInputHandle handle;
       FXuchar       mode;
@@ -76,9 +94,12 @@ public:
     public:
       Input(FXInputHandle h,FXuchar m) : handle(h),mode(m) {}
 
-      void disable() { mode|=Disabled; }
+      void disable() { mode|=Disabled; if (reactor) reactor->updateInput(this); }
 
-      void enable()  { mode&=~Disabled; }
+      void enable()  { mode&=~Disabled; if (reactor) reactor->updateInput(this); }
+
+      // Change the events we're interested in
+      void setMode(FXuchar m) { mode=m; if (reactor) reactor->updateInput(this); }
 
       FXbool readable() const {  return (mode&IsReadable); }
 
@@ -88,11 +109,11 @@ public:
   class Timer {
     friend class Reactor;
     private:
-      Timer * next;
+      FXint   index;  // position in timer heap or -1
     protected:
       FXTime  time;
     public:
-      Timer() : time(0) {}
+      Timer() : index(-1),time(0) {}
       virtual void onExpired() {}
       virtual ~Timer() {}
     };
@@ -119,13 +140,28 @@ public:
 protected:
   FXPtrListOf<Deferred> deferred; // run once every iteration
   FXPtrListOf<Input>    inputs;
+#if defined(__linux__)
+  FXPtrListOf<Watch>    watches;   // epoll registrations, one per handle
+  FXPtrListOf<Input>    signalled; // inputs sharing the handle that is being dispatched
+#endif
   FXPtrListOf<Native>   native;
-  Timer *               timers;
+  Timer **              timers;   // binary heap ordered by expiry time
+  FXint                 ntimers;
+  FXint                 mtimers;
 protected:
   FXTime prepare();
+#if defined(__linux__)
+  void updateWatch(Watch*);
+#endif
   void dispatch();
+  void dispatchTimers();
   void wait(FXTime);
   FXbool dispatchDeferred();
+  void heapUp(FXint);
+  void heapDown(FXint);
+private:
+  Reactor(const Reactor&);
+  Reactor &operator=(const Reactor&);
 public:
   Reactor();
 
@@ -145,6 +181,9 @@ public:
   // Remove a watch
   void removeInput(Input*);
 
+  // Update watch after its mode changed
+  void updateInput(Input*);
+
   // Add a timer
   void addTimer(Timer*,FXTime);
 
@@ -0,0 +1,356 @@
+/*******************************************************************************
+*                         Goggles Audio Player Library                         *
+********************************************************************************
+*           Copyright (C) 2026 by Sander Jansen. All Rights Reserved           *
+*                               ---                                            *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License for more details.                                 *
+*                                                                              *
+* You should have received a copy of the GNU General Public License            *
+* along with this program.  If not, see http://www.gnu.org/licenses.           *
+********************************************************************************/
+#include "ap_defs.h"
+#include "ap_device.h"
+#include "ap_resampler.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+namespace ap {
+
+// Number of input frames converted per pass
+static const FXint resampler_block = 4096;
+
+
+/*
+  Filter layout per quality setting. The number of taps is for upsampling;
+  when downsampling the filter gets wider in proportion to the lower cutoff.
+*/
+struct ResamplerSetup {
+  FXint    ntaps;
+  FXint    nphases;
+  FXdouble rolloff;
+  FXdouble beta;
+  };
+
+static const ResamplerSetup resampler_setup[3]={
+  { 16,  64, 0.90,  6.0 },  // ResamplerFast
+  { 32, 128, 0.94,  8.0 },  // ResamplerMedium
+  { 64, 256, 0.97, 10.0 }   // ResamplerBest
+  };
+
+
+static FXuint gcd(FXuint a,FXuint b) {
+  while(b) {
+    FXuint t=a%b;
+    a=b;
+    b=t;
+    }
+  return a;
+  }
+
+
+// Zeroth order modified Bessel function for the Kaiser window
+static FXdouble bessel_i0(FXdouble x) {
+  FXdouble sum=1.0,term=1.0;
+  for (FXint k=1;k<32;k++) {
+    term*=(x/(2.0*k))*(x/(2.0*k));
+    sum+=term;
+    if (term<sum*1e-12) break;
+    }
+  return sum;
+  }
+
+
+// ntaps is always a multiple of 4
+static inline FXfloat dot_product(const FXfloat * x,const FXfloat * c,FXint ntaps) {
+#if defined(__SSE2__)
+  __m128 sum=_mm_setzero_ps();
+  for (FXint i=0;i<ntaps;i+=4)
+    sum=_mm_add_ps(sum,_mm_mul_ps(_mm_loadu_ps(x+i),_mm_loadu_ps(c+i)));
+  sum=_mm_add_ps(sum,_mm_movehl_ps(sum,sum));
+  sum=_mm_add_ss(sum,_mm_shuffle_ps(sum,sum,1));
+  return _mm_cvtss_f32(sum);
+#elif defined(HAVE_NEON)
+  float32x4_t sum=vdupq_n_f32(0.0f);
+  for (FXint i=0;i<ntaps;i+=4)
+    sum=vmlaq_f32(sum,vld1q_f32(x+i),vld1q_f32(c+i));
+  float32x2_t s=vadd_f32(vget_low_f32(sum),vget_high_f32(sum));
+  return vget_lane_f32(vpadd_f32(s,s),0);
+#else
+  FXfloat s0=0.0f,s1=0.0f,s2=0.0f,s3=0.0f;
+  for (FXint i=0;i<ntaps;i+=4) {
+    s0+=x[i+0]*c[i+0];
+    s1+=x[i+1]*c[i+1];
+    s2+=x[i+2]*c[i+2];
+    s3+=x[i+3]*c[i+3];
+    }
+  return (s0+s1)+(s2+s3);
+#endif
+  }
+
+
+static inline FXint clamp_s32(FXdouble v) {
+  if (v>=2147483647.0) return 2147483647;
+  if (v<=-2147483648.0) return (-2147483647-1);
+  return (FXint)lrint(v);
+  }
+
+
+Resampler::Resampler() {
+  }
+
+Resampler::~Resampler() {
+  clear();
+  }
+
+
+void Resampler::clear() {
+  freeElms(filter);
+  freeElms(history);
+  ntaps=nphases=capacity=nframes=index=0;
+  phase=L=M=rate=0;
+  quality=0;
+  af.reset();
+  }
+
+
+FXbool Resampler::supported(const AudioFormat & fmt) {
+  switch(fmt.format) {
+    case AP_FORMAT_S16  :
+    case AP_FORMAT_S24_3:
+    case AP_FORMAT_S32  :
+    case AP_FORMAT_FLOAT: return (fmt.rate>0 && fmt.channels>0); break;
+    default             : break;
+    }
+  return false;
+  }
+
+
+FXbool Resampler::init(const AudioFormat & fmt,FXuint r,FXuchar q) {
+  clear();
+
+  if (q<ResamplerFast || q>ResamplerBest || r==0 || !supported(fmt))
+    return false;
+
+  const ResamplerSetup & setup = resampler_setup[q-ResamplerFast];
+  const FXuint g = gcd(fmt.rate,r);
+
+  af      = fmt;
+  rate    = r;
+  quality = q;
+  L       = r / g;
+  M       = fmt.rate / g;
+
+  // Widen the filter when downsampling. Keep ntaps a multiple of 4 for the dot product.
+  ntaps   = (FXint)ceil(setup.ntaps * FXMAX(1.0,(FXdouble)M/(FXdouble)L));
+  ntaps   = (ntaps+3)&~3;
+  nphases = setup.nphases;
+
+  design_filter();
+
+  capacity = ntaps + resampler_block;
+  allocElms(history,capacity*af.channels);
+  reset();
+
+  GM_DEBUG_PRINT("[resampler] %u -> %u Hz with %d taps and %d phases\n",af.rate,rate,ntaps,nphases);
+  return true;
+  }
+
+
+/*
+  Row p holds the windowed sinc for an output that lies p/nphases between
+  two input frames. The extra row at p=nphases lets us interpolate
+  between phases without wrapping. Each row is normalized for unity gain.
+*/
+void Resampler::design_filter() {
+  const ResamplerSetup & setup = resampler_setup[quality-ResamplerFast];
+  const FXdouble cutoff = FXMIN(1.0,(FXdouble)L/(FXdouble)M) * setup.rolloff;
+  const FXdouble half   = ntaps / 2;
+  const FXdouble norm   = bessel_i0(setup.beta);
+
+  allocElms(filter,(nphases+1)*ntaps);
+
+  for (FXint p=0;p<=nphases;p++) {
+    FXfloat * row = filter + p*ntaps;
+    FXdouble sum = 0.0;
+    for (FXint j=0;j<ntaps;j++) {
+      const FXdouble x = (FXdouble)p/(FXdouble)nphases + half - 1.0 - j;
+      const FXdouble w = (fabs(x)<half) ? bessel_i0(setup.beta*sqrt(1.0-(x/half)*(x/half))) / norm : 0.0;
+      const FXdouble t = PI * cutoff * x;
+      const FXdouble h = (fabs(t)<1e-9) ? cutoff : cutoff * sin(t) / t;
+      row[j] = (FXfloat)(h*w);
+      sum += row[j];
+      }
+    if (sum!=0.0) {
+      for (FXint j=0;j<ntaps;j++) row[j]/=sum;
+      }
+    }
+  }
+
+
+// Prime the history with zeros so the first output is centered on the first input frame
+void Resampler::reset() {
+  if (history) {
+    nframes = ntaps/2 - 1;
+    for (FXuint c=0;c<af.channels;c++)
+      memset(history+c*capacity,0,sizeof(FXfloat)*nframes);
+    }
+  index = 0;
+  phase = 0;
+  }
+
+
+// Deinterleave n frames into history
+void Resampler::append(const FXuchar * in,FXint n) {
+  const FXuint nchannels = af.channels;
+  FXASSERT(nframes+n<=capacity);
+  for (FXuint c=0;c<nchannels;c++) {
+    FXfloat * out = history + c*capacity + nframes;
+    switch(af.format) {
+      case AP_FORMAT_S16:
+        {
+          const FXshort * s = reinterpret_cast<const FXshort*>(in) + c;
+          for (FXint i=0;i<n;i++,s+=nchannels) out[i]=(*s)*(1.0f/32768.0f);
+        } break;
+      case AP_FORMAT_S24_3:
+        {
+          const FXuchar * s = in + 3*c;
+          for (FXint i=0;i<n;i++,s+=3*nchannels) {
+            const FXint v = ((FXint)(((FXuint)s[0]<<8)|((FXuint)s[1]<<16)|((FXuint)s[2]<<24)))>>8;
+            out[i]=v*(1.0f/8388608.0f);
+            }
+        } break;
+      case AP_FORMAT_S32:
+        {
+          const FXint * s = reinterpret_cast<const FXint*>(in) + c;
+          for (FXint i=0;i<n;i++,s+=nchannels) out[i]=(FXfloat)((*s)*(1.0/2147483648.0));
+        } break;
+      case AP_FORMAT_FLOAT:
+        {
+          const FXfloat * s = reinterpret_cast<const FXfloat*>(in) + c;
+          for (FXint i=0;i<n;i++,s+=nchannels) out[i]=*s;
+        } break;
+      }
+    }
+  nframes+=n;
+  }
+
+
+/*
+  Produce as many output frames as the history allows. The read position is
+  kept as an integer frame plus a phase in units of 1/L, so it never drifts.
+  Consumed frames are dropped from the history afterwards.
+*/
+FXint Resampler::generate(FXuchar * out,FXint maxframes) {
+  const FXuint nchannels = af.channels;
+  FXint n=0;
+
+  while(n<maxframes && index+ntaps<=nframes) {
+    const FXulong  pos  = (FXulong)phase*nphases;
+    const FXint    p    = (FXint)(pos/L);
+    const FXfloat  frac = (FXfloat)(pos%L)/(FXfloat)L;
+    const FXfloat * c0  = filter + p*ntaps;
+    const FXfloat * c1  = c0 + ntaps;
+
+    for (FXuint c=0;c<nchannels;c++) {
+      const FXfloat * x = history + c*capacity + index;
+      const FXfloat s0 = dot_product(x,c0,ntaps);
+      const FXfloat s1 = dot_product(x,c1,ntaps);
+      const FXfloat v  = s0 + frac*(s1-s0);
+      switch(af.format) {
+        case AP_FORMAT_S16:
+          {
+            const FXint s = lrintf(v*32768.0f);
+            reinterpret_cast<FXshort*>(out)[n*nchannels+c] = (FXshort)FXCLAMP(-32768,s,32767);
+          } break;
+        case AP_FORMAT_S24_3:
+          {
+            const FXint s = FXCLAMP(-8388608,(FXint)lrintf(v*8388608.0f),8388607);
+            FXuchar * o = out + 3*(n*nchannels+c);
+            o[0] = s&0xff;
+            o[1] = (s>>8)&0xff;
+            o[2] = (s>>16)&0xff;
+          } break;
+        case AP_FORMAT_S32:
+          reinterpret_cast<FXint*>(out)[n*nchannels+c] = clamp_s32(v*2147483648.0);
+          break;
+        case AP_FORMAT_FLOAT:
+          reinterpret_cast<FXfloat*>(out)[n*nchannels+c] = v;
+          break;
+        }
+      }
+    n++;
+
+    phase += M;
+    index += phase / L;
+    phase %= L;
+    }
+
+  // Drop consumed frames
+  if (index>0) {
+    const FXint keep = FXMAX(0,nframes-index);
+    for (FXuint c=0;c<nchannels;c++) {
+      FXfloat * row = history + c*capacity;
+      memmove(row,row+FXMIN(index,nframes),sizeof(FXfloat)*keep);
+      }
+    index   -= nframes-keep;
+    nframes  = keep;
+    }
+  return n;
+  }
+
+
+FXint Resampler::process(const FXuchar * in,FXint n,MemoryBuffer & out) {
+  const FXint framesize = af.framesize();
+  FXint total=0;
+
+  out.clear();
+  while(n>0) {
+    const FXint count = FXMIN(n,capacity-nframes);
+    append(in,count);
+    in+=count*framesize;
+    n-=count;
+
+    out.reserve((((FXlong)(nframes-index)*L)/M+2)*framesize);
+    const FXint ngen = generate(out.ptr(),out.space()/framesize);
+    out.wroteBytes(ngen*framesize);
+    total+=ngen;
+    }
+  return total;
+  }
+
+
+// Pad with silence to push out the frames still held back by the filter delay
+FXint Resampler::drain(MemoryBuffer & out) {
+  const FXint framesize = af.framesize();
+  const FXint npad = ntaps/2;
+
+  out.clear();
+  if (!active() || nframes+npad>capacity)
+    return 0;
+
+  for (FXuint c=0;c<af.channels;c++)
+    memset(history+c*capacity+nframes,0,sizeof(FXfloat)*npad);
+  nframes+=npad;
+
+  // Every window that fits now is centered on a real input frame
+  out.reserve((((FXlong)(nframes-index)*L)/M+2)*framesize);
+  const FXint ngen = generate(out.ptr(),out.space()/framesize);
+  out.wroteBytes(ngen*framesize);
+  reset();
+  return ngen;
+  }
+
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+*                         Goggles Audio Player Library                         *
+********************************************************************************
+*           Copyright (C) 2026 by Sander Jansen. All Rights Reserved           *
+*                               ---                                            *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License for more details.                                 *
+*                                                                              *
+* You should have received a copy of the GNU General Public License            *
+* along with this program.  If not, see http://www.gnu.org/licenses.           *
+********************************************************************************/
+#ifndef AP_RESAMPLER_H
+#define AP_RESAMPLER_H
+
+#include "ap_buffer.h"
+#include "ap_format.h"
+
+namespace ap {
+
+/*
+  Polyphase windowed sinc sample rate converter. Works on interleaved
+  s16, s24le3, s32 and float samples and produces the same format.
+*/
+class Resampler {
+protected:
+  FXfloat *   filter   = nullptr;  // (nphases+1) rows of ntaps coefficients
+  FXfloat *   history  = nullptr;  // planar input, one row of capacity frames per channel
+  FXint       ntaps    = 0;
+  FXint       nphases  = 0;
+  FXint       capacity = 0;
+  FXint       nframes  = 0;        // frames in history
+  FXint       index    = 0;        // history frame where the next output starts
+  FXuint      phase    = 0;        // fractional input position in units of 1/L
+  FXuint      L        = 0;        // output rate / gcd
+  FXuint      M        = 0;        // input rate / gcd
+  FXuchar     quality  = 0;
+  AudioFormat af;
+  FXuint      rate     = 0;
+protected:
+  void design_filter();
+  void append(const FXuchar * in,FXint n);
+  FXint generate(FXuchar * out,FXint maxframes);
+private:
+  Resampler(const Resampler&);
+  Resampler& operator=(const Resampler&);
+public:
+  Resampler();
+
+  /// Check if the sample format can be resampled
+  static FXbool supported(const AudioFormat & fmt);
+
+  /// Setup to convert af into rate. Returns false if unsupported.
+  FXbool init(const AudioFormat & af,FXuint rate,FXuchar quality);
+
+  /// Check if the resampler is already setup for this conversion
+  FXbool match(const AudioFormat & fmt,FXuint r,FXuchar q) const { return active() && fmt==af && r==rate && q==quality; }
+
+  /// Returns true if setup
+  FXbool active() const { return L!=0; }
+
+  /// Clear history, for example after a seek
+  void reset();
+
+  /// Release everything
+  void clear();
+
+  /// Convert position in input frames into output frames
+  FXlong position(FXlong pos) const { return (pos>0) ? (pos*L)/M : pos; }
+
+  /// Resample nframes from in and replace the contents of out. Returns the number of output frames.
+  FXint process(const FXuchar * in,FXint nframes,MemoryBuffer & out);
+
+  /// Flush the remaining frames into out. Returns the number of output frames.
+  FXint drain(MemoryBuffer & out);
+
+  ~Resampler();
+  };
+
+}
+#endif
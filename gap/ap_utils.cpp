@@ -78,6 +78,13 @@
 // for prctl
 #ifdef __linux__
 #include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+// for setpriority / mlockall
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/mman.h>
 #endif
 
 // for fcntl
@@ -120,6 +127,39 @@ void ap_set_thread_name(const FXchar * name) {
 #endif
   }
 
+FXbool ap_set_thread_nice(FXint value) {
+#ifdef __linux__
+  // On Linux the nice value is a per thread attribute
+  if (setpriority(PRIO_PROCESS,syscall(SYS_gettid),value)==0)
+    return true;
+  GM_DEBUG_PRINT("[utils] setpriority failed: %d\n",errno);
+#else
+  (void)value;
+#endif
+  return false;
+  }
+
+FXbool ap_lock_memory(FXbool lock) {
+#ifndef _WIN32
+  if (lock) {
+    // Only lock future mappings if the limit allows for it, otherwise later allocations start failing
+    struct rlimit limit;
+    FXint flags=MCL_CURRENT;
+    if (getrlimit(RLIMIT_MEMLOCK,&limit)==0 && limit.rlim_cur==RLIM_INFINITY)
+      flags|=MCL_FUTURE;
+    if (mlockall(flags)==0)
+      return true;
+    GM_DEBUG_PRINT("[utils] mlockall failed: %d\n",errno);
+    }
+  else {
+    return munlockall()==0;
+    }
+#else
+  (void)lock;
+#endif
+  return false;
+  }
+
 FXString ap_get_environment(const FXchar * key,const FXchar * def) {
   FXString value = FXSystem::getEnvironment(key);
   if (value.empty())
@@ -129,6 +169,14 @@ FXString ap_get_environment(const FXchar * key,const FXchar * def) {
   }
 
 
+FXString ap_get_cache_directory() {
+  FXString xdg_cache_home = FXSystem::getEnvironment("XDG_CACHE_HOME");
+  if (xdg_cache_home.empty())
+    xdg_cache_home=FXSystem::getHomeDirectory()+PATHSEPSTRING ".cache" ;
+  return xdg_cache_home+PATHSEPSTRING "gogglesmm";
+  }
+
+
 FXbool ap_set_nonblocking(FXInputHandle fd) {
 #ifndef _WIN32
   FXint flags = fcntl(fd,F_GETFL);
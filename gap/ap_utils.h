@@ -29,8 +29,17 @@ extern const FXTextCodec * ap_get_textcodec(const FXString &);
 
 extern FXString ap_get_environment(const FXchar * key,const FXchar * def=nullptr);
 
+// Cache directory shared with the application
+extern FXString ap_get_cache_directory();
+
 extern FXbool ap_set_closeonexec(FXInputHandle fd);
 
+// Change the nice value of the calling thread
+extern FXbool ap_set_thread_nice(FXint value);
+
+// Lock (or unlock) all current and future pages of the process into memory
+extern FXbool ap_lock_memory(FXbool lock);
+
 }
 #endif
 
@@ -18,6 +18,9 @@
 ********************************************************************************/
 #include "ap_defs.h"
 #include "ap_utils.h"
+#include "ap_buffer_base.h"
+#include "ap_buffer_io.h"
+#include "ap_http_response.h"
 #include "ap_xml_parser.h"
 
 #include <expat.h>
@@ -26,12 +29,13 @@ namespace ap {
 
 #define NUM_NODES 32
 
-XmlParser::XmlParser() : nnodes(NUM_NODES),level(0) {
+XmlParser::XmlParser() : nnodes(NUM_NODES),level(0),parser(nullptr) {
   allocElms(nodes,nnodes);
   nodes[0]=Elem_None;
   }
 
 XmlParser::~XmlParser() {
+  if (parser) XML_ParserFree((XML_Parser)parser);
   freeElms(nodes);
   }
 
@@ -93,29 +97,92 @@ static int unknown_encoding(void*,const XML_Char * name,XML_Encoding * info){
   }
 
 
-FXbool XmlParser::parse(const FXString & buffer,const FXString & encoding) {
+FXbool XmlParser::open(const FXString & encoding) {
   if (!encoding.empty())
     GM_DEBUG_PRINT("[xml] parse with encoding %s\n",encoding.text());
 
-  XML_Parser parser;
+  if (parser) XML_ParserFree((XML_Parser)parser);
 
   if (encoding.empty())
     parser = XML_ParserCreate(nullptr);
   else
     parser = XML_ParserCreate(encoding.text());
 
+  if (parser==nullptr)
+    return false;
+
+  level=0;
+  nodes[0]=Elem_None;
+
   XML_SetUserData((XML_Parser)parser,this);
   XML_SetElementHandler((XML_Parser)parser,ap::element_start,ap::element_end);
   XML_SetCharacterDataHandler((XML_Parser)parser,ap::element_data);
   XML_SetUnknownEncodingHandler((XML_Parser)parser,unknown_encoding,this);
+  return true;
+  }
 
-  XML_Status code = XML_Parse((XML_Parser)parser,buffer.text(),buffer.length(),1);
-  if (code==XML_STATUS_ERROR) {
-    XML_ParserFree(parser);
-    return false;
+
+FXbool XmlParser::write(const FXchar * data,FXival len) {
+  FXASSERT(parser);
+  while(len>0) {
+    const int n = (int)FXMIN(len,0x10000000);
+    if (XML_Parse((XML_Parser)parser,data,n,0)==XML_STATUS_ERROR)
+      return false;
+    data+=n;
+    len-=n;
     }
-  XML_ParserFree(parser);
   return true;
   }
 
+
+FXbool XmlParser::close() {
+  FXbool result = false;
+  if (parser) {
+    result = (XML_Parse((XML_Parser)parser,nullptr,0,1)!=XML_STATUS_ERROR);
+    XML_ParserFree((XML_Parser)parser);
+    parser=nullptr;
+    }
+  return result;
+  }
+
+
+FXbool XmlParser::parse(const FXString & buffer,const FXString & encoding) {
+  if (!open(encoding))
+    return false;
+
+  if (!write(buffer.text(),buffer.length())) {
+    XML_ParserFree((XML_Parser)parser);
+    parser=nullptr;
+    return false;
+    }
+  return close();
+  }
+
+
+/* Feeds the http message body straight into the parser */
+class XmlParserSink : public HttpSink {
+protected:
+  XmlParser & parser;
+public:
+  XmlParserSink(XmlParser & p) : parser(p) {}
+  FXbool write(const FXchar * data,FXival len) override { return parser.write(data,len); }
+  };
+
+
+FXbool XmlParser::parse(HttpResponse & response,const FXString & encoding) {
+  XmlParserSink sink(*this);
+
+  if (!open(encoding)) {
+    response.discard();
+    return false;
+    }
+
+  if (!response.body(sink)) {
+    XML_ParserFree((XML_Parser)parser);
+    parser=nullptr;
+    return false;
+    }
+  return close();
+  }
+
 }
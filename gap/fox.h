@@ -53,6 +53,7 @@
 #include <FXString.h>
 
 // Threading
+#include <FXAtomic.h>
 #include <FXMutex.h>
 #include <FXCondition.h>
 #include <FXAutoThreadStorageKey.h>
@@ -78,6 +79,7 @@
 #include <FXPath.h>
 #include <FXSystem.h>
 #include <FXStat.h>
+#include <FXDir.h>
 #include <FXURL.h>
 #include <FXDLL.h>
 
@@ -23,6 +23,7 @@ set(HEADERS
     ap_packet.h
     ap_reactor.h
     ap_reader_plugin.h
+    ap_resampler.h
     ap_signal.h
     ap_socket.h
     ap_thread.h
@@ -32,6 +32,21 @@ enum {
   DeviceLast,
   };
 
+/// Sample rate conversion in the output thread
+enum {
+  ResamplerOff    = 0,
+  ResamplerFast   = 1,
+  ResamplerMedium = 2,
+  ResamplerBest   = 3
+  };
+
+/// Device sample format when the output rate is fixed
+enum {
+  FixedFormatS16   = 0,
+  FixedFormatS32   = 1,
+  FixedFormatFloat = 2
+  };
+
 class GMAPI DeviceConfig {
 public:
   DeviceConfig();
@@ -100,11 +115,21 @@ public:
 
 
 class GMAPI OutputConfig {
+public:
+  enum {
+    LowLatency     = 0x1, /// Real-time priority, locked memory and no allocations in the output thread
+    ParallelDecode = 0x2  /// Decode seekable flac files on multiple threads
+    };
 public:
   AlsaConfig  alsa;
   OSSConfig   oss;
   SndioConfig sndio;
   FXuchar     device;
+  FXuchar     resampler;
+  FXuint      flags;
+  FXuint      fixed_rate;      /// Keep the device at this rate. 0 follows the stream.
+  FXuchar     fixed_format;    /// Device sample format when the rate is fixed
+  FXuchar     fixed_channels;  /// Device channels when the rate is fixed
 public:
   OutputConfig();
 
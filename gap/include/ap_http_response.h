@@ -171,6 +171,16 @@ public:
   FXbool parse(const FXString & str,FXuint opts=0);
   };
 
+/* Receives the (decoded) message body while it is being read */
+class GMAPI HttpSink {
+public:
+  // Consume len bytes. Return false to abort.
+  virtual FXbool write(const FXchar * data,FXival len) = 0;
+
+  virtual ~HttpSink() {}
+  };
+
+
 /* Http Response Parser */
 class GMAPI HttpResponse {
 protected:
@@ -249,6 +259,9 @@ public:
   // Return the complete message body as string.
   FXString textBody();
 
+  // Stream the de-chunked and inflated message body into sink
+  FXbool body(HttpSink & sink);
+
   /// Read partial body
   FXival readBody(void*ptr,FXival len);
 
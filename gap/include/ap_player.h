@@ -50,6 +50,9 @@ public:
   /// Open url and flush existing stream if true
   void open(const FXString & url,FXbool flush=true);
 
+  /// Cache the start of url so it opens quickly later on
+  void prefetch(const FXString & url);
+
   /// Pause Stream
   void pause();
 
@@ -21,11 +21,17 @@
 
 namespace ap {
 
+class HttpResponse;
+
 class GMAPI XmlParser {
 private:
   FXint* nodes;
   FXint  nnodes;
   FXint  level;
+  void*  parser;
+private:
+  XmlParser(const XmlParser&);
+  XmlParser &operator=(const XmlParser&);
 public:
   void element_start(const FXchar*,const FXchar**);
   void element_end(const FXchar * element);
@@ -47,6 +53,18 @@ public:
   // Parse buffer with optional encoding
   FXbool parse(const FXString & text,const FXString & encoding=FXString::null);
 
+  // Parse http message body while it is being received
+  FXbool parse(HttpResponse & response,const FXString & encoding=FXString::null);
+
+  // Start incremental parsing with optional encoding
+  FXbool open(const FXString & encoding=FXString::null);
+
+  // Parse next len bytes of the document
+  FXbool write(const FXchar * data,FXival len);
+
+  // Finish incremental parsing. Returns true if document was well formed.
+  FXbool close();
+
   virtual ~XmlParser();
   };
 }
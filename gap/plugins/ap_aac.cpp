@@ -333,7 +333,7 @@ protected:
   FXbool process_frames(Packet*);
   FXbool process_raw(Packet*);
   FXbool create();
-  FXint  process_output(FXuint streamid,FXlong stream_length,void * outsamples,FXint nsamples);
+  FXint  process_output(FXuint streamid,FXlong stream_length,void * outsamples,FXint nsamples,FXbool internal);
 public:
   AacDecoder(DecoderContext*);
   FXuchar codec() const override { return Codec::AAC; }
@@ -492,7 +492,7 @@ FXbool AacDecoder::getNextFrame(Packet *& packet,FXuchar *& ptr,FXuint & framesi
   }
 
 
-FXint AacDecoder::process_output(FXuint stream_id,FXlong stream_length,void * outsamples,FXint nsamples) {
+FXint AacDecoder::process_output(FXuint stream_id,FXlong stream_length,void * outsamples,FXint nsamples,FXbool internal) {
   const FXlong stream_begin = FXMAX(stream_offset_start,stream_decode_offset);
 
   FXint nframes = nsamples / af.channels;
@@ -509,7 +509,7 @@ FXint AacDecoder::process_output(FXuint stream_id,FXlong stream_length,void * ou
     nframes = FXMIN(nframes,stream_length-stream_position);
     }
 
-  if (use_internal_buffer) {
+  if (internal) {
     FXuchar * in = reinterpret_cast<FXuchar*>(outsamples);
     if (stream_position<stream_begin) {
       FXint skip_frames = FXMIN(nframes,(stream_begin-stream_position));
@@ -531,6 +531,9 @@ FXint AacDecoder::process_output(FXuint stream_id,FXlong stream_length,void * ou
       if (out->availableFrames()==0)
         context->post_output_packet(out);
       }
+    // Make room so the next frame can be decoded in place again
+    if (!use_internal_buffer && out && out->availableFrames() < (nsamples / af.channels))
+      context->post_output_packet(out);
     }
   else {
     stream_position+=nframes;
@@ -610,15 +613,20 @@ FXbool AacDecoder::process_raw(Packet*packet) {
       }
 
     // Looks like the decoder already takes care of stripping any encoder delay. So first call will return 0 samples.
-    if (use_internal_buffer) {
+    FXbool internal = use_internal_buffer;
+    if (internal) {
       outsamples = NeAACDecDecode(handle,&frame,buffer.data(),buffer.size());
       }
     else {
       void * outbuffer = out->ptr();
       NeAACDecDecode2(handle,&frame,buffer.data(),buffer.size(),&outbuffer,out->availableFrames()*out->af.framesize());
       if (frame.error == 27) {
-        GM_DEBUG_PRINT("[aac] using faad internal buffer (%d)\n",out->availableFrames()*out->af.framesize());
-        use_internal_buffer=true;
+        // Only give up on decoding into packets if the frame doesn't even fit in an empty one
+        if (out->numFrames()==0) {
+          GM_DEBUG_PRINT("[aac] using faad internal buffer (%d)\n",out->availableFrames()*out->af.framesize());
+          use_internal_buffer=true;
+          }
+        internal=true;
         outsamples = NeAACDecDecode(handle,&frame,buffer.data(),buffer.size());
         }
       }
@@ -636,7 +644,7 @@ FXbool AacDecoder::process_raw(Packet*packet) {
     if (frame.samples==0)
       continue;
 
-    if (process_output(stream_id, stream_length, outsamples, frame.samples))
+    if (process_output(stream_id, stream_length, outsamples, frame.samples, internal))
       return true;
     }
   while( buffer.size() && frame.bytesconsumed );
@@ -682,15 +690,20 @@ FXbool AacDecoder::process_frames(Packet*packet) {
       }
 
     // Looks like the decoder already takes care of stripping any encoder delay. So first call will return 0 samples.
-    if (use_internal_buffer) {
+    FXbool internal = use_internal_buffer;
+    if (internal) {
       outsamples = NeAACDecDecode(handle,&frame,framedata,framesize);
       }
     else {
       void * outbuffer = out->ptr();
       NeAACDecDecode2(handle,&frame,framedata,framesize,&outbuffer,out->availableFrames()*out->af.framesize());
       if (frame.error == 27) {
-        GM_DEBUG_PRINT("[aac] using faad internal buffer (%d)\n",out->availableFrames()*out->af.framesize());
-        use_internal_buffer=true;
+        // Only give up on decoding into packets if the frame doesn't even fit in an empty one
+        if (out->numFrames()==0) {
+          GM_DEBUG_PRINT("[aac] using faad internal buffer (%d)\n",out->availableFrames()*out->af.framesize());
+          use_internal_buffer=true;
+          }
+        internal=true;
         outsamples = NeAACDecDecode(handle,&frame,framedata,framesize);
         }
       }
@@ -714,7 +727,7 @@ FXbool AacDecoder::process_frames(Packet*packet) {
     if (frame.samples==0)
       continue;
 
-    if (process_output(stream_id, stream_length, outsamples, frame.samples)){
+    if (process_output(stream_id, stream_length, outsamples, frame.samples, internal)){
       if (packet) packet->unref();
       return true;
       }
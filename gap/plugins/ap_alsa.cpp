@@ -38,6 +38,7 @@ protected:
   snd_pcm_t*        handle;
   snd_pcm_uframes_t period_size;
   snd_pcm_uframes_t period_written;
+  snd_pcm_uframes_t map_offset;
   FXuchar*          silence;
 
 
@@ -48,6 +49,7 @@ protected:
   FXbool   can_resume;
 protected:
   FXbool open();
+  snd_pcm_sframes_t wait_writable(snd_pcm_uframes_t nframes);
 public:
   AlsaOutput(OutputContext*);
 
@@ -57,6 +59,15 @@ public:
   /// Write frames to playback buffer
   FXbool write(const void*, FXuint);
 
+  /// Map the playback buffer
+  FXuchar * map(FXuint & nframes);
+
+  /// Commit frames written to the mapped buffer
+  FXbool commit(FXuint nframes);
+
+  /// Whether map and commit can be used
+  FXbool mappable() const { return handle && (config.flags&AlsaConfig::DeviceMMap); }
+
   /// Return delay in no. of frames
   FXint delay();
 
@@ -837,7 +848,7 @@ fail:
 
 
 
-AlsaOutput::AlsaOutput(OutputContext * ctx) : OutputPlugin(ctx), handle(nullptr),period_size(0),period_written(0),silence(nullptr),mixer(nullptr),can_pause(false),can_resume(false) {
+AlsaOutput::AlsaOutput(OutputContext * ctx) : OutputPlugin(ctx), handle(nullptr),period_size(0),period_written(0),map_offset(0),silence(nullptr),mixer(nullptr),can_pause(false),can_resume(false) {
   }
 
 AlsaOutput::~AlsaOutput() {
@@ -923,6 +934,11 @@ void AlsaOutput::drop() {
 void AlsaOutput::drain() {
   if (__likely(handle)) {
     int result;
+
+    // Frames committed through map() don't start the device by themselves
+    if (snd_pcm_state(handle)==SND_PCM_STATE_PREPARED && period_written)
+      snd_pcm_start(handle);
+
     if (snd_pcm_state(handle)==SND_PCM_STATE_RUNNING) {
 
       // snd_pcm_drain works with periods, not samples. So
@@ -1010,28 +1026,28 @@ FXbool AlsaOutput::configure(const AudioFormat & fmt){
   }
 
 
-FXbool AlsaOutput::write(const void * buffer,FXuint nframes){
+/*
+  Wait until the device is ready to accept frames, recovering from xruns and
+  suspends on the way. Returns the number of frames available or -1 if the
+  device failed.
+*/
+snd_pcm_sframes_t AlsaOutput::wait_writable(snd_pcm_uframes_t nframes) {
   int result;
   snd_pcm_sframes_t navailable;
-  snd_pcm_sframes_t nwritten;
   snd_pcm_state_t   state;
-  const FXchar * buf = (const FXchar*)buffer;
 
-  if (__unlikely(handle==nullptr))
-    return false;
-
-  while(nframes>0) {
+  for (;;) {
     state=snd_pcm_state(handle);
     switch(state) {
       /// Failed States
       case SND_PCM_STATE_DRAINING     :
       case SND_PCM_STATE_DISCONNECTED :
       case SND_PCM_STATE_OPEN         : GM_DEBUG_PRINT("[alsa] state is open, draining or disconnected\n");
-                                        return false;
+                                        return -1;
                                         break;
 
       case SND_PCM_STATE_PAUSED       : GM_DEBUG_PRINT("[alsa] state is paused while write is called\n");
-                                        return false;
+                                        return -1;
                                         break;
 
       /// Recoverable States
@@ -1041,7 +1057,7 @@ FXbool AlsaOutput::write(const void * buffer,FXuint nframes){
           result = snd_pcm_prepare(handle);
           if (result<0) {
             GM_DEBUG_PRINT("[alsa] %s",snd_strerror(result));
-            return false;
+            return -1;
             }
         } break;
 
@@ -1050,7 +1066,7 @@ FXbool AlsaOutput::write(const void * buffer,FXuint nframes){
           result = snd_pcm_prepare(handle);
           if (result<0) {
             GM_DEBUG_PRINT("[alsa] %s",snd_strerror(result));
-            return false;
+            return -1;
             }
 
         } break;
@@ -1071,7 +1087,7 @@ FXbool AlsaOutput::write(const void * buffer,FXuint nframes){
 
           if (result!=0) {
             GM_DEBUG_PRINT("[alsa] %s",snd_strerror(result));
-            return false;
+            return -1;
             }
 
         } break;
@@ -1080,7 +1096,7 @@ FXbool AlsaOutput::write(const void * buffer,FXuint nframes){
       case SND_PCM_STATE_RUNNING      :
         {
           navailable = snd_pcm_avail_update(handle);
-          if (navailable<nframes /*&& navailable<(snd_pcm_sframes_t)periodsize*/) {
+          if (navailable>=0 && navailable<(snd_pcm_sframes_t)nframes /*&& navailable<(snd_pcm_sframes_t)periodsize*/) {
             result = snd_pcm_wait(handle,500);
             if (result<0) {
               /// Underrun / Suspended
@@ -1088,40 +1104,126 @@ FXbool AlsaOutput::write(const void * buffer,FXuint nframes){
                 GM_DEBUG_PRINT("[alsa] %s\n",snd_strerror(result));
                 continue;
                 }
-              return false;
+              return -1;
               }
             navailable = snd_pcm_avail_update(handle);
             }
-
-        } // fallthrough - intentionally no break
-      default                         :
-        {
-          if ((config.flags&AlsaConfig::DeviceMMap))
-            nwritten = snd_pcm_mmap_writei(handle,buf,nframes);
-          else
-            nwritten = snd_pcm_writei(handle,buf,nframes);
-
-          if (nwritten==-EAGAIN || nwritten==-EINTR)
+          if (navailable<0) {
+            GM_DEBUG_PRINT("[alsa] xrun or suspend: %s\n",snd_strerror(navailable));
+            if (snd_pcm_recover(handle,navailable,1)<0)
+              return -1;
             continue;
-
-          if (nwritten<0) {
-            GM_DEBUG_PRINT("[alsa] xrun or suspend: %s\n",snd_strerror(nwritten));
-            nwritten = snd_pcm_recover(handle,nwritten,1);
-            if (nwritten<0) {
-              if (nwritten!=-EAGAIN) {
-                GM_DEBUG_PRINT("[alsa] fatal write error %ld:  %s\n",nwritten,snd_strerror(nwritten));
-                return false;
-                }
-              }
-            }
-          if (nwritten>0) {
-            period_written = (period_written + nwritten) % period_size;
-            buf+=(nwritten*af.framesize());
-            nframes-=nwritten;
             }
+          return navailable;
         } break;
+
+      default                         : return nframes;
+                                        break;
       }
     }
+  return -1;
+  }
+
+
+FXbool AlsaOutput::write(const void * buffer,FXuint nframes){
+  snd_pcm_sframes_t nwritten;
+  const FXchar * buf = (const FXchar*)buffer;
+
+  if (__unlikely(handle==nullptr))
+    return false;
+
+  while(nframes>0) {
+
+    if (wait_writable(nframes)<0)
+      return false;
+
+    if ((config.flags&AlsaConfig::DeviceMMap))
+      nwritten = snd_pcm_mmap_writei(handle,buf,nframes);
+    else
+      nwritten = snd_pcm_writei(handle,buf,nframes);
+
+    if (nwritten==-EAGAIN || nwritten==-EINTR)
+      continue;
+
+    if (nwritten<0) {
+      GM_DEBUG_PRINT("[alsa] xrun or suspend: %s\n",snd_strerror(nwritten));
+      nwritten = snd_pcm_recover(handle,nwritten,1);
+      if (nwritten<0) {
+        if (nwritten!=-EAGAIN) {
+          GM_DEBUG_PRINT("[alsa] fatal write error %ld:  %s\n",nwritten,snd_strerror(nwritten));
+          return false;
+          }
+        }
+      }
+    if (nwritten>0) {
+      period_written = (period_written + nwritten) % period_size;
+      buf+=(nwritten*af.framesize());
+      nframes-=nwritten;
+      }
+    }
+  return true;
+  }
+
+
+/*
+  Give the output thread direct access to the ring buffer of the device. The
+  returned area is contiguous, so nframes may be less than requested when the
+  ring buffer wraps around.
+*/
+FXuchar * AlsaOutput::map(FXuint & nframes) {
+  const snd_pcm_channel_area_t * areas;
+  snd_pcm_uframes_t offset;
+  snd_pcm_uframes_t frames;
+  snd_pcm_sframes_t navailable;
+  int result;
+
+  if (__unlikely(handle==nullptr))
+    return nullptr;
+
+  do {
+    navailable = wait_writable(FXMIN((snd_pcm_uframes_t)nframes,period_size));
+    if (navailable<0)
+      return nullptr;
+    }
+  while(navailable==0);
+
+  frames = FXMIN((snd_pcm_uframes_t)navailable,(snd_pcm_uframes_t)nframes);
+  if ((result=snd_pcm_mmap_begin(handle,&areas,&offset,&frames))<0) {
+    GM_DEBUG_PRINT("[alsa] mmap begin failed: %s\n",snd_strerror(result));
+    return nullptr;
+    }
+
+  map_offset = offset;
+  nframes    = frames;
+  return static_cast<FXuchar*>(areas[0].addr) + (areas[0].first>>3) + (offset*(areas[0].step>>3));
+  }
+
+
+FXbool AlsaOutput::commit(FXuint nframes) {
+  snd_pcm_sframes_t ncommitted;
+  snd_pcm_sframes_t ndelay;
+
+  if (__unlikely(handle==nullptr))
+    return false;
+
+  ncommitted = snd_pcm_mmap_commit(handle,map_offset,nframes);
+  if (ncommitted<0) {
+    // The mapped frames are lost, recover so the next map succeeds again
+    GM_DEBUG_PRINT("[alsa] xrun or suspend: %s\n",snd_strerror(ncommitted));
+    if (snd_pcm_recover(handle,ncommitted,1)<0) {
+      GM_DEBUG_PRINT("[alsa] fatal commit error %ld:  %s\n",ncommitted,snd_strerror(ncommitted));
+      return false;
+      }
+    return true;
+    }
+
+  period_written = (period_written + ncommitted) % period_size;
+
+  // Unlike snd_pcm_mmap_writei, commit doesn't start the device for us.
+  if (snd_pcm_state(handle)==SND_PCM_STATE_PREPARED) {
+    if (snd_pcm_delay(handle,&ndelay)==0 && ndelay>=(snd_pcm_sframes_t)period_size)
+      snd_pcm_start(handle);
+    }
   return true;
   }
 
@@ -17,17 +17,93 @@
 * along with this program.  If not, see http://www.gnu.org/licenses.           *
 ********************************************************************************/
 #include "ap_defs.h"
+#include "ap_utils.h"
 #include "ap_input_plugin.h"
 
 using namespace ap;
 
 namespace ap {
 
+// Number of bytes kept in the head cache per file, and the total size of the cache
+static const FXlong head_cache_bytes = 1048576;
+static const FXlong head_cache_limit = 128*1048576;
+
+
+/*
+  Head Cache
+
+  Keeps the first megabyte of recently played and queued local files in the
+  cache directory, so opening them, parsing the headers and decoding the first
+  few seconds doesn't have to wait for slow storage to spin up. The cached bytes
+  are identical to the file, so the reader continues from the file itself
+  without noticing the switch. Least recently used entries are removed once the
+  cache grows too large.
+*/
+static FXString head_cache_filename(const FXStat & info) {
+  return ap_get_cache_directory() + PATHSEPSTRING "head" PATHSEPSTRING + FXString::value("%x-%lx-%lx-%lx.head",info.volume(),info.index(),info.size(),info.modified());
+  }
+
+static void head_cache_touch(const FXString & path) {
+  FXStat::modified(path,FXThread::time());
+  }
+
+static void head_cache_trim() {
+  FXString   directory = ap_get_cache_directory() + PATHSEPSTRING "head";
+  FXString * files     = nullptr;
+  FXlong     total     = 0;
+
+  FXint nfiles = FXDir::listFiles(files,directory,"*.head",FXDir::NoDirs|FXDir::NoParent);
+  if (nfiles<=0)
+    return;
+
+  FXArray<FXTime> times;
+  FXArray<FXlong> sizes;
+  times.no(nfiles);
+  sizes.no(nfiles);
+  for (FXint i=0;i<nfiles;i++) {
+    FXStat info;
+    files[i]=directory+PATHSEPSTRING+files[i];
+    if (FXStat::statFile(files[i],info)) {
+      times[i]=info.modified();
+      sizes[i]=info.size();
+      total+=info.size();
+      }
+    else {
+      sizes[i]=-1;
+      }
+    }
+
+  // Remove least recently used until we're within the limit
+  while(total>head_cache_limit) {
+    FXint oldest=-1;
+    for (FXint i=0;i<nfiles;i++) {
+      if (sizes[i]>=0 && (oldest==-1 || times[i]<times[oldest]))
+        oldest=i;
+      }
+    if (oldest==-1) break;
+    GM_DEBUG_PRINT("[file] head cache remove %s\n",files[oldest].text());
+    FXFile::remove(files[oldest]);
+    total-=sizes[oldest];
+    sizes[oldest]=-1;
+    }
+  delete [] files;
+  }
+
 
 class FileInput : public InputPlugin {
 protected:
   FXFile   file;
   FXString filename;
+  FXFile   head;         // cached head of file
+  FXlong   head_size;    // number of bytes available in head
+  FXFile   fill;         // head cache being written
+  FXlong   fill_size;    // number of bytes written to fill
+  FXlong   fill_limit;   // number of bytes to store in fill
+  FXString fill_name;    // final name of the head cache
+  FXlong   offset;       // current position
+protected:
+  void fill_head(const FXuchar*,FXlong pos,FXival n);
+  void fill_abort();
 private:
   FileInput(const FileInput&);
   FileInput &operator=(const FileInput&);
@@ -55,6 +131,9 @@ public:
   /// End of Input
   FXbool eof() override;
 
+  /// File information
+  FXbool stat(FXStat &) override;
+
   /// Serial
   FXbool serial() const override;
 
@@ -66,13 +145,15 @@ public:
   };
 
 
-FileInput::FileInput(IOContext * ctx) : InputPlugin(ctx) {
+FileInput::FileInput(IOContext * ctx) : InputPlugin(ctx), head_size(0), fill_size(0), fill_limit(0), offset(0) {
   }
 
 FileInput::~FileInput() {
+  fill_abort();
   }
 
 FXbool FileInput::open(const FXString & url) {
+  FXStat info;
 
   // Get filename
   filename=FXURL::fileFromURL(url);
@@ -84,26 +165,119 @@ FXbool FileInput::open(const FXString & url) {
     return false;
     }
 
+  // Use the head cache if available, otherwise fill it while reading
+  if (!file.isSerial() && FXStat::stat(file,info) && info.size()>0) {
+    FXString path = head_cache_filename(info);
+    if (head.open(path,FXIO::Reading)) {
+      if (head.size()==FXMIN(info.size(),head_cache_bytes)) {
+        GM_DEBUG_PRINT("[file] using head cache %s\n",path.text());
+        head_size=head.size();
+        head_cache_touch(path);
+        return true;
+        }
+      head.close();
+      }
+    if (FXDir::createDirectories(FXPath::directory(path)) && fill.open(path+".part",FXIO::Writing)) {
+      fill_name=path;
+      fill_limit=FXMIN(info.size(),head_cache_bytes);
+      }
+    }
   return true;
   }
 
+
+void FileInput::fill_abort() {
+  if (fill.isOpen()) {
+    fill.close();
+    FXFile::remove(fill_name+".part");
+    fill_name.clear();
+    }
+  }
+
+
+void FileInput::fill_head(const FXuchar * data,FXlong pos,FXival n) {
+  // Only sequential reads from the start fill the cache
+  if (pos>fill_size) {
+    fill_abort();
+    return;
+    }
+
+  // Skip what we already have
+  if (pos+n<=fill_size)
+    return;
+
+  data+=(fill_size-pos);
+  n-=(fill_size-pos);
+  n=FXMIN(n,fill_limit-fill_size);
+
+  if (fill.writeBlock(data,n)!=n) {
+    fill_abort();
+    return;
+    }
+
+  fill_size+=n;
+  if (fill_size==fill_limit) {
+    fill.close();
+    if (FXFile::rename(fill_name+".part",fill_name)) {
+      GM_DEBUG_PRINT("[file] stored head cache %s\n",fill_name.text());
+      head_cache_trim();
+      }
+    else {
+      FXFile::remove(fill_name+".part");
+      }
+    fill_name.clear();
+    }
+  }
+
+
 FXival FileInput::preview(void*data,FXival count) {
-	FXlong pos = file.position();
-	FXival n = file.readBlock(data,count);
-	file.position(pos,FXIO::Begin);
-	return n;
+  FXlong pos = offset;
+  FXival n = read(data,count);
+  position(pos,FXIO::Begin);
+  return n;
   }
 
-FXival FileInput::read(void*data,FXival ncount) {
-  return file.readBlock(data,ncount);
+FXival FileInput::read(void*data,FXival count) {
+  FXuchar * buffer = static_cast<FXuchar*>(data);
+  FXival nread = 0;
+  FXival n;
+
+  // Serve from the head cache first
+  if (offset<head_size) {
+    n = head.readBlock(buffer,FXMIN(count,head_size-offset));
+    if (n<=0) return n;
+    offset+=n;
+    nread+=n;
+    if (offset>=head_size) file.position(offset,FXIO::Begin);
+    if (nread==count || offset<head_size) return nread;
+    }
+
+  n = file.readBlock(buffer+nread,count-nread);
+  if (n<=0) return (nread>0) ? nread : n;
+
+  if (fill.isOpen())
+    fill_head(buffer+nread,offset,n);
+
+  offset+=n;
+  return nread+n;
   }
 
-FXlong FileInput::position(FXlong offset,FXuint from) {
-  return file.position(offset,from);
+FXlong FileInput::position(FXlong pos,FXuint from) {
+  switch(from) {
+    case FXIO::Current: pos+=offset;      break;
+    case FXIO::End    : pos+=file.size(); break;
+    default           : break;
+    }
+  if (pos<0 || file.position(pos,FXIO::Begin)!=pos)
+    return -1;
+  if (pos<head_size)
+    head.position(pos,FXIO::Begin);
+  offset=pos;
+  return offset;
   }
 
 FXlong FileInput::position() const {
-  return file.position();
+  return offset;
   }
 
 FXlong FileInput::size() {
@@ -111,7 +285,11 @@ FXlong FileInput::size() {
   }
 
 FXbool FileInput::eof()  {
-  return file.eof();
+  return offset>=file.size();
+  }
+
+FXbool FileInput::stat(FXStat & info) {
+  return FXStat::stat(file,info);
   }
 
 FXbool FileInput::serial() const {
@@ -129,4 +307,37 @@ InputPlugin * ap_file_plugin(IOContext * context) {
   }
 
 
+void ap_file_prefetch(const FXString & url) {
+  FXString filename=FXURL::fileFromURL(url);
+  if (filename.empty()) filename=url;
+
+  FXFile file;
+  FXStat info;
+  if (!file.open(filename,FXIO::Reading) || file.isSerial() || !FXStat::stat(file,info) || info.size()<=0)
+    return;
+
+  FXString path = head_cache_filename(info);
+  if (FXStat::exists(path)) {
+    head_cache_touch(path);
+    return;
+    }
+
+  GM_DEBUG_PRINT("[file] prefetch %s\n",filename.text());
+  FXArray<FXuchar> buffer;
+  buffer.no(FXMIN(info.size(),head_cache_bytes));
+  if (file.readBlock(buffer.data(),buffer.no())!=buffer.no() || !FXDir::createDirectories(FXPath::directory(path)))
+    return;
+
+  FXFile cache;
+  if (cache.open(path+".part",FXIO::Writing)) {
+    FXbool ok = (cache.writeBlock(buffer.data(),buffer.no())==buffer.no());
+    cache.close();
+    if (ok && FXFile::rename(path+".part",path))
+      head_cache_trim();
+    else
+      FXFile::remove(path+".part");
+    }
+  }
+
+
 }
@@ -17,12 +17,14 @@
 * along with this program.  If not, see http://www.gnu.org/licenses.           *
 ********************************************************************************/
 #include "ap_defs.h"
+#include "ap_utils.h"
 #include "ap_event_private.h"
 #include "ap_packet.h"
 #include "ap_id3v2.h"
 #include "ap_input_plugin.h"
 #include "ap_reader_plugin.h"
 #include "ap_decoder_plugin.h"
+#include "ap_convert.h"
 
 #include <FLAC/stream_decoder.h>
 
@@ -54,6 +56,124 @@ static const FXuchar crc8_lookup[256] = {
   0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
 };
 
+static const FXushort crc16_lookup[256] = {
+  0x0000, 0x8005, 0x800f, 0x000a, 0x801b, 0x001e, 0x0014, 0x8011,
+  0x8033, 0x0036, 0x003c, 0x8039, 0x0028, 0x802d, 0x8027, 0x0022,
+  0x8063, 0x0066, 0x006c, 0x8069, 0x0078, 0x807d, 0x8077, 0x0072,
+  0x0050, 0x8055, 0x805f, 0x005a, 0x804b, 0x004e, 0x0044, 0x8041,
+  0x80c3, 0x00c6, 0x00cc, 0x80c9, 0x00d8, 0x80dd, 0x80d7, 0x00d2,
+  0x00f0, 0x80f5, 0x80ff, 0x00fa, 0x80eb, 0x00ee, 0x00e4, 0x80e1,
+  0x00a0, 0x80a5, 0x80af, 0x00aa, 0x80bb, 0x00be, 0x00b4, 0x80b1,
+  0x8093, 0x0096, 0x009c, 0x8099, 0x0088, 0x808d, 0x8087, 0x0082,
+  0x8183, 0x0186, 0x018c, 0x8189, 0x0198, 0x819d, 0x8197, 0x0192,
+  0x01b0, 0x81b5, 0x81bf, 0x01ba, 0x81ab, 0x01ae, 0x01a4, 0x81a1,
+  0x01e0, 0x81e5, 0x81ef, 0x01ea, 0x81fb, 0x01fe, 0x01f4, 0x81f1,
+  0x81d3, 0x01d6, 0x01dc, 0x81d9, 0x01c8, 0x81cd, 0x81c7, 0x01c2,
+  0x0140, 0x8145, 0x814f, 0x014a, 0x815b, 0x015e, 0x0154, 0x8151,
+  0x8173, 0x0176, 0x017c, 0x8179, 0x0168, 0x816d, 0x8167, 0x0162,
+  0x8123, 0x0126, 0x012c, 0x8129, 0x0138, 0x813d, 0x8137, 0x0132,
+  0x0110, 0x8115, 0x811f, 0x011a, 0x810b, 0x010e, 0x0104, 0x8101,
+  0x8303, 0x0306, 0x030c, 0x8309, 0x0318, 0x831d, 0x8317, 0x0312,
+  0x0330, 0x8335, 0x833f, 0x033a, 0x832b, 0x032e, 0x0324, 0x8321,
+  0x0360, 0x8365, 0x836f, 0x036a, 0x837b, 0x037e, 0x0374, 0x8371,
+  0x8353, 0x0356, 0x035c, 0x8359, 0x0348, 0x834d, 0x8347, 0x0342,
+  0x03c0, 0x83c5, 0x83cf, 0x03ca, 0x83db, 0x03de, 0x03d4, 0x83d1,
+  0x83f3, 0x03f6, 0x03fc, 0x83f9, 0x03e8, 0x83ed, 0x83e7, 0x03e2,
+  0x83a3, 0x03a6, 0x03ac, 0x83a9, 0x03b8, 0x83bd, 0x83b7, 0x03b2,
+  0x0390, 0x8395, 0x839f, 0x039a, 0x838b, 0x038e, 0x0384, 0x8381,
+  0x0280, 0x8285, 0x828f, 0x028a, 0x829b, 0x029e, 0x0294, 0x8291,
+  0x82b3, 0x02b6, 0x02bc, 0x82b9, 0x02a8, 0x82ad, 0x82a7, 0x02a2,
+  0x82e3, 0x02e6, 0x02ec, 0x82e9, 0x02f8, 0x82fd, 0x82f7, 0x02f2,
+  0x02d0, 0x82d5, 0x82df, 0x02da, 0x82cb, 0x02ce, 0x02c4, 0x82c1,
+  0x8243, 0x0246, 0x024c, 0x8249, 0x0258, 0x825d, 0x8257, 0x0252,
+  0x0270, 0x8275, 0x827f, 0x027a, 0x826b, 0x026e, 0x0264, 0x8261,
+  0x0220, 0x8225, 0x822f, 0x022a, 0x823b, 0x023e, 0x0234, 0x8231,
+  0x8213, 0x0216, 0x021c, 0x8219, 0x0208, 0x820d, 0x8207, 0x0202
+};
+
+static inline FXushort flac_crc16(FXushort crc,FXuchar byte) {
+  return static_cast<FXushort>((crc<<8) ^ crc16_lookup[(crc>>8) ^ byte]);
+  }
+
+/// Largest possible frame header, including the crc
+#define FLAC_MAX_FRAME_HEADER 16
+
+
+/* Decoder Configuration for seekable streams */
+class FlacConfig : public DecoderConfig {
+public:
+  FXushort minblocksize = 0;
+  FXushort maxblocksize = 0;
+  FXuchar  streaminfo[34];            // Raw STREAMINFO block for the frame decoders
+  };
+
+
+/*
+  Splits a flac stream into frames. Since frame headers may appear inside the
+  encoded data, a boundary is only accepted if the crc16 in the frame footer
+  matches and it's followed by a valid frame header.
+*/
+class FlacFrameParser {
+public:
+  MemoryBuffer buffer;                // Data not yet split into frames
+  AudioFormat  af;
+  FXlong       offset       = 0;      // Stream offset of buffer
+  FXlong       sample       = 0;      // First sample of the frame at the start of buffer
+  FXushort     minblocksize = 0;
+  FXushort     maxblocksize = 0;
+protected:
+  FXival       scan         = 2;      // Scan position for the next frame header
+  FXushort     scan_crc     = 0;      // Crc16 of buffer up to scan-2
+  FXbool       synced       = false;  // Buffer starts at a frame header
+public:
+  /// Reset parser at stream offset
+  void reset(FXlong offset=0);
+
+  /// Find length of the frame at the start of buffer
+  FXbool find(FXbool eos,FXival & length);
+
+  /// Remove frame from buffer
+  void consume(FXival length);
+  };
+
+
+/*
+  Offset of each frame, stored in the cache directory. Only written
+  for streams that were read from start to end without seeking.
+*/
+class FlacFrameIndex {
+protected:
+  FXArray<FXuint> offsets;            // Offset of each frame relative to the stream start
+  FXArray<FXlong> samples;            // First sample of each frame for variable blocksize streams
+  FXString        filename;
+  FXlong          stream_start = 0;
+  FXlong          stream_length = 0;
+  FXushort        blocksize = 0;      // Fixed blocksize or 0
+protected:
+  FXbool building = false;
+public:
+  /// Try to load the index for the stream, otherwise start building it
+  void init(InputPlugin * input,FXlong start,FXlong length,FXushort minblocksize,FXushort maxblocksize);
+
+  /// Add next frame while building
+  void add(FXlong offset,FXlong sample);
+
+  /// Stop building the index
+  void abort() { building=false; offsets.clear(); samples.clear(); }
+
+  /// Store the index
+  void save();
+
+  /// Returns true if index is being build
+  FXbool build() const { return building; }
+
+  /// Find offset of the frame containing sample
+  FXbool find(FXlong sample,FXlong & offset) const;
+
+  /// Clear
+  void clear();
+  };
+
 
 
 class FlacReader : public ReaderPlugin {
@@ -63,12 +183,16 @@ protected:
   FXushort maxblocksize;
   FXuint   minframesize;
   FXuint   maxframesize;
+  FXuchar  streaminfo[34];
   struct SeekPoint {
     FXulong   sample;
     FXlong    offset;
     FXushort nsamples;
     };
   FXArray<SeekPoint> seektable;
+protected:
+  FlacFrameIndex  frameindex;
+  FlacFrameParser indexer;
 protected:
   ReplayGain gain;
   MetaInfo*  meta;
@@ -77,11 +201,16 @@ protected:
   FXbool parse_streaminfo();
   FXbool parse_seektable(FXuint blocksize);
   FXbool parse_vorbiscomment(FXuint blocksize);
-  FXint  parse_utf_value(const FXuchar * buffer,FXuint & value);
-  FXint  parse_utf_value(const FXuchar * buffer,FXlong & value);
   FXbool sync(FXlong & offset,FXlong & sample,FXuint & blocksize);
+  void   index_frames(const FXuchar * data,FXival nbytes);
+protected:
+  static FXint parse_utf_value(const FXuchar * buffer,FXuint & value);
+  static FXint parse_utf_value(const FXuchar * buffer,FXlong & value);
 protected:
   ReadStatus parse();
+public:
+  /// Parse frame header of at least FLAC_MAX_FRAME_HEADER bytes. Returns header size or 0 if invalid.
+  static FXint parse_frame_header(const FXuchar * bytes,const AudioFormat & af,FXushort minblocksize,FXushort maxblocksize,FXlong & sample,FXuint & blocksize);
 public:
   FlacReader(InputContext*);
   FXuchar format() const { return Format::FLAC; };
@@ -93,6 +222,88 @@ public:
   };
 
 
+/*
+  A single frame (or the tail of the stream) handed to a FlacFrameWorker.
+*/
+struct FlacFrame {
+  FXArray<FXuchar> data;          // Encoded frame
+  FXArray<FXuchar> pcm;           // Decoded interleaved samples
+  FXlong           sample  = 0;   // First sample of the frame
+  FXint            nframes = 0;   // Number of decoded frames
+  FXbool           done    = false;
+  };
+
+
+class FlacFrameWorker;
+
+/*
+  Ring of frames in decode order. The decoder thread submits and collects
+  frames in order, workers pick them up and finish them in any order.
+*/
+class FlacFrameQueue {
+protected:
+  FXMutex                   mutex;
+  FXCondition               condition_work;
+  FXCondition               condition_done;
+  FXArray<FlacFrame>        frames;
+  FXArray<FlacFrameWorker*> workers;
+  FXuint                    nsubmitted = 0;
+  FXuint                    ntaken     = 0;
+  FXuint                    ncollected = 0;
+  FXbool                    quit       = false;
+public:
+  FXint   framesize = 0;
+  FXuchar header[42];                 // Stream marker and STREAMINFO block, replayed by each worker
+public:
+  FlacFrameQueue();
+
+  /// Start nthreads workers
+  FXbool start(FXint nthreads);
+
+  /// Number of workers
+  FXint threads() const { return workers.no(); }
+
+  /// Next free frame or nullptr if all are in flight
+  FlacFrame * reserve();
+
+  /// Submit the reserved frame
+  void submit();
+
+  /// Wait for the oldest frame to be decoded. Returns nullptr if nothing was submitted.
+  FlacFrame * wait();
+
+  /// Release the oldest frame
+  void release();
+
+  /// Wait for all frames in flight and drop them
+  void clear();
+
+  /// Called by workers
+  FlacFrame * take();
+  void finish(FlacFrame*);
+
+  ~FlacFrameQueue();
+  };
+
+
+class FlacFrameWorker : public FXThread {
+protected:
+  FlacFrameQueue      * queue;
+  FLAC__StreamDecoder * flac     = nullptr;
+  FlacFrame           * frame    = nullptr;
+  FXival                position = 0;   // Read position in header followed by frame data
+protected:
+  static FLAC__StreamDecoderWriteStatus   flac_decoder_write(const FLAC__StreamDecoder*,const FLAC__Frame*,const FLAC__int32*const[],void*);
+  static FLAC__StreamDecoderReadStatus    flac_decoder_read(const FLAC__StreamDecoder*,FLAC__byte buffer[],size_t*,void*);
+  static void                             flac_decoder_error(const FLAC__StreamDecoder *, FLAC__StreamDecoderErrorStatus, void *);
+public:
+  FlacFrameWorker(FlacFrameQueue*);
+  FXbool init();
+  FXint run() override;
+  ~FlacFrameWorker();
+  };
+
+
 class FlacDecoder : public DecoderPlugin {
 protected:
   FLAC__StreamDecoder * flac;
@@ -100,6 +311,13 @@ protected:
 protected:
   Packet * in;
   Packet * out;
+protected:
+  FlacFrameQueue * queue = nullptr;      // Parallel decoding of seekable streams
+  FlacFrameParser  parser;
+protected:
+  FXbool write_frame();
+  FXbool process_frames(Packet*);
+  void   reset_frames();
 protected:
   static FLAC__StreamDecoderWriteStatus   flac_decoder_write(const FLAC__StreamDecoder*,const FLAC__Frame*,const FLAC__int32*const[],void*);
   static FLAC__StreamDecoderReadStatus    flac_decoder_read(const FLAC__StreamDecoder*,FLAC__byte buffer[],size_t*,void*);
@@ -135,6 +353,215 @@ void flac_parse_vorbiscomment(const FXuchar * buffer,FXint len,ReplayGain & gain
 
 
 
+void FlacFrameParser::reset(FXlong o) {
+  buffer.clear();
+  offset=o;
+  sample=0;
+  synced=false;
+  scan=2;
+  scan_crc=0;
+  }
+
+FXbool FlacFrameParser::find(FXbool eos,FXival & length) {
+  FXlong next;
+  FXuint blocksize;
+
+  // Skip to the first frame header
+  if (!synced) {
+    FXival i;
+    for (i=0;i+FLAC_MAX_FRAME_HEADER<=buffer.size();i++) {
+      if (FlacReader::parse_frame_header(buffer.data()+i,af,minblocksize,maxblocksize,sample,blocksize))
+        break;
+      }
+    buffer.readBytes(i);
+    offset+=i;
+    if (buffer.size()<FLAC_MAX_FRAME_HEADER) {
+      if (eos) {
+        offset+=buffer.size();
+        buffer.clear();
+        }
+      return false;
+      }
+    synced=true;
+    scan=2;
+    scan_crc=0;
+    }
+
+  const FXuchar * data = buffer.data();
+  const FXival    size = buffer.size();
+
+  for (;scan+FLAC_MAX_FRAME_HEADER<=size;scan++) {
+    if (data[scan]==0xff &&
+        scan_crc==((static_cast<FXushort>(data[scan-2])<<8)|data[scan-1]) &&
+        FlacReader::parse_frame_header(data+scan,af,minblocksize,maxblocksize,next,blocksize)) {
+      length=scan;
+      return true;
+      }
+    scan_crc=flac_crc16(scan_crc,data[scan-2]);
+    }
+
+  // Remainder of the stream
+  if (eos && size) {
+    length=size;
+    return true;
+    }
+  return false;
+  }
+
+void FlacFrameParser::consume(FXival length) {
+  FXuint blocksize;
+  if (length<buffer.size())
+    FlacReader::parse_frame_header(buffer.data()+length,af,minblocksize,maxblocksize,sample,blocksize);
+  buffer.readBytes(length);
+  offset+=length;
+  scan=2;
+  scan_crc=0;
+  }
+
+
+
+/* Frame Index File Header */
+struct FlacFrameIndexHeader {
+  FXuint  magic;
+  FXuint  version;
+  FXlong  stream_start;
+  FXlong  stream_length;
+  FXuint  nframes;
+  FXushort blocksize;
+  FXushort reserved;
+  };
+
+static const FXuint FLAC_INDEX_MAGIC   = 0x78646966;  // "fidx"
+static const FXuint FLAC_INDEX_VERSION = 1;
+
+
+void FlacFrameIndex::clear() {
+  offsets.clear();
+  samples.clear();
+  filename.clear();
+  building=false;
+  }
+
+void FlacFrameIndex::init(InputPlugin * input,FXlong start,FXlong length,FXushort minblocksize,FXushort maxblocksize) {
+  FXStat info;
+
+  clear();
+
+  // Only index local files that fit in 32 bit offsets
+  if (input->serial() || !input->stat(info) || info.size()-start>0xFFFFFFFF)
+    return;
+
+  stream_start  = start;
+  stream_length = length;
+  blocksize     = (minblocksize==maxblocksize) ? minblocksize : 0;
+  filename      = ap_get_cache_directory() + PATHSEPSTRING "flac" PATHSEPSTRING + FXString::value("%x-%lx-%lx-%lx.idx",info.volume(),info.index(),info.size(),info.modified());
+
+  FXFile file;
+  if (file.open(filename,FXIO::Reading)) {
+    FlacFrameIndexHeader header;
+    if (file.readBlock(&header,sizeof(header))==sizeof(header) &&
+        header.magic==FLAC_INDEX_MAGIC &&
+        header.version==FLAC_INDEX_VERSION &&
+        header.stream_start==stream_start &&
+        header.stream_length==stream_length &&
+        header.blocksize==blocksize &&
+        header.nframes>0) {
+
+      offsets.no(header.nframes);
+      if (file.readBlock(offsets.data(),sizeof(FXuint)*header.nframes)==(FXival)(sizeof(FXuint)*header.nframes)) {
+        if (blocksize)
+          return;
+        samples.no(header.nframes);
+        if (file.readBlock(samples.data(),sizeof(FXlong)*header.nframes)==(FXival)(sizeof(FXlong)*header.nframes))
+          return;
+        }
+      }
+    GM_DEBUG_PRINT("[flac] invalid frame index %s\n",filename.text());
+    offsets.clear();
+    samples.clear();
+    }
+  building=true;
+  }
+
+void FlacFrameIndex::add(FXlong offset,FXlong sample) {
+  // Frames of fixed blocksize streams are looked up by number, so don't allow gaps
+  if (blocksize && sample!=static_cast<FXlong>(offsets.no())*blocksize) {
+    GM_DEBUG_PRINT("[flac] unexpected frame at sample %ld. Not indexing stream\n",sample);
+    abort();
+    return;
+    }
+  offsets.append(static_cast<FXuint>(offset-stream_start));
+  if (blocksize==0)
+    samples.append(sample);
+  }
+
+void FlacFrameIndex::save() {
+  building=false;
+  if (offsets.no()==0 || filename.empty())
+    return;
+
+  // Should have seen all frames
+  if (blocksize && offsets.no()!=(stream_length+blocksize-1)/blocksize) {
+    GM_DEBUG_PRINT("[flac] frame index incomplete. Not saving\n");
+    return;
+    }
+
+  FXDir::createDirectories(FXPath::directory(filename));
+
+  FlacFrameIndexHeader header;
+  header.magic         = FLAC_INDEX_MAGIC;
+  header.version       = FLAC_INDEX_VERSION;
+  header.stream_start  = stream_start;
+  header.stream_length = stream_length;
+  header.nframes       = offsets.no();
+  header.blocksize     = blocksize;
+  header.reserved      = 0;
+
+  // Write a temporary file first, so readers never see a partial index
+  const FXString partial = filename + ".part";
+
+  FXFile file;
+  if (file.open(partial,FXIO::Writing)) {
+    if (file.writeBlock(&header,sizeof(header))!=sizeof(header) ||
+        file.writeBlock(offsets.data(),sizeof(FXuint)*offsets.no())!=(FXival)(sizeof(FXuint)*offsets.no()) ||
+        (blocksize==0 && file.writeBlock(samples.data(),sizeof(FXlong)*samples.no())!=(FXival)(sizeof(FXlong)*samples.no())) ||
+        !file.close() ||
+        !FXFile::rename(partial,filename)) {
+      file.close();
+      FXFile::remove(partial);
+      return;
+      }
+    GM_DEBUG_PRINT("[flac] saved frame index with %d frames\n",offsets.no());
+    }
+  }
+
+FXbool FlacFrameIndex::find(FXlong sample,FXlong & offset) const {
+  FXint frame;
+
+  if (building || offsets.no()==0)
+    return false;
+
+  if (blocksize) {
+    frame = sample / blocksize;
+    if (frame>=offsets.no())
+      return false;
+    }
+  else {
+    FXint l=0,h=samples.no();
+    while(l<h) {
+      const FXint m=(l+h)>>1;
+      if (samples[m]<=sample) l=m+1; else h=m;
+      }
+    if (l==0)
+      return false;
+    frame = l-1;
+    }
+  offset = stream_start + offsets[frame];
+  return true;
+  }
+
+
+
 FlacReader::FlacReader(InputContext* ctx) : ReaderPlugin(ctx), meta(nullptr) {
   }
 
@@ -145,6 +572,8 @@ FXbool FlacReader::init(InputPlugin*plugin) {
   ReaderPlugin::init(plugin);
   gain.reset();
   seektable.clear();
+  frameindex.clear();
+  indexer.reset();
   if (meta) {
     meta->unref();
     meta=nullptr;
@@ -191,14 +620,126 @@ FXint FlacReader::parse_utf_value(const FXuchar * buffer,FXuint & value) {
                                          ((ptr)[3]&0x1)==0 &&\
                                          ((ptr)[3]&0xe)!=0x6
 
-FXbool FlacReader::sync(FXlong & offset,FXlong & sample,FXuint & blocksize) {
+FXint FlacReader::parse_frame_header(const FXuchar * bytes,const AudioFormat & af,FXushort minblocksize,FXushort maxblocksize,FXlong & sample,FXuint & blocksize) {
   const FXuchar blocking_strategy = (minblocksize==maxblocksize) ? 0xf8 : 0xf9;
   FXuchar samplesize;
   FXuint  samplerate;
   FXuint  framenumber;
   FXuchar crc;
+  FXint   h=4;
+
+  // Match frame header start
+  if (!(match_frame_header(bytes,blocking_strategy)))
+    return 0;
+
+  // Match samplesize (invalid values were already filtered out)
+  switch(bytes[3]&0xf){
+    case  2: samplesize =  8; break;
+    case  4: samplesize = 12; break;
+    case  8: samplesize = 16; break;
+    case 10: samplesize = 20; break;
+    case 12: samplesize = 24; break;
+    case 14: samplesize = 32; break;
+    default: samplesize = af.bps(); break;
+    }
+  if (samplesize!=af.bps()) return 0;
+
+  // Match samplerate
+  const FXuchar sr = bytes[2]&0xf;
+  switch(sr){
+    case  0: samplerate=af.rate; break;
+    case  1: samplerate=88200;   break;
+    case  2: samplerate=176400;  break;
+    case  3: samplerate=192000;  break;
+    case  4: samplerate=8000;    break;
+    case  5: samplerate=16000;   break;
+    case  6: samplerate=22050;   break;
+    case  7: samplerate=24000;   break;
+    case  8: samplerate=32000;   break;
+    case  9: samplerate=44100;   break;
+    case 10: samplerate=48000;   break;
+    case 11: samplerate=96000;   break;
+    default: samplerate=0;       break;
+    }
+  if (samplerate && samplerate!=af.rate) return 0;
+
+  // Match blocksize [for fixed blocksize streams]
+  const FXuchar bs = bytes[2]>>4;
+  if (bs==0) return 0;
+  if (minblocksize==maxblocksize && bs!=6 && bs!=7) {
+    if (bs==1)
+      blocksize=192;
+    else if (bs>=8)
+      blocksize=256<<(bs-8);
+    else
+      blocksize=576<<(bs-2);
+    if (blocksize!=minblocksize) return 0;
+    }
+
+  // Match Channel Count
+  const FXuchar ch = bytes[3]>>4;
+  if (ch<0x7) {
+    if (af.channels!=(ch+1)) return 0;
+    }
+  else if (af.channels!=2) return 0;
+
+  // read frame or sample
+  if (minblocksize==maxblocksize) {
+    const FXint n = parse_utf_value(bytes+h,framenumber);
+    if (n==0) return 0;
+    h+=n;
+    sample=static_cast<FXlong>(minblocksize)*framenumber;
+    }
+  else {
+    const FXint n = parse_utf_value(bytes+h,sample);
+    if (n==0) return 0;
+    h+=n;
+    }
+
+  if (bs==6) { // read 8-bit blocksize
+    blocksize = 1 + bytes[h++];
+    if (minblocksize==maxblocksize && blocksize!=minblocksize) return 0;
+    }
+  else if (bs==7) { // read 16-bit blocksize
+    blocksize = 1 + (static_cast<FXuint>(bytes[h]) << 8 | static_cast<FXuint>(bytes[h+1]));
+    h+=2;
+    if (minblocksize==maxblocksize && blocksize!=minblocksize) return 0;
+    }
+  else if (minblocksize!=maxblocksize) {
+    if (bs==1)
+      blocksize=192;
+    else if (bs>=8)
+      blocksize=256<<(bs-8);
+    else
+      blocksize=576<<(bs-2);
+    }
+
+  if (sr==12) { // read 8-bit samplerate
+    samplerate = bytes[h++]*1000;
+    if (samplerate!=af.rate) return 0;
+    }
+  else if (sr>=13) { // read 16-bit samplerate
+    samplerate = (static_cast<FXuint>(bytes[h]) << 8 | static_cast<FXuint>(bytes[h+1]));
+    h+=2;
+    if (sr==14) samplerate *= 10;
+    if (samplerate!=af.rate) return 0;
+    }
+
+  crc = 0;
+  for (FXint c=0;c<h;c++){
+    crc = crc8_lookup[crc ^ bytes[c]];
+    }
+  if (crc!=bytes[h++]){
+    return 0;
+    }
+  return h;
+  }
+
+
+FXbool FlacReader::sync(FXlong & offset,FXlong & sample,FXuint & blocksize) {
+  const FXuchar blocking_strategy = (minblocksize==maxblocksize) ? 0xf8 : 0xf9;
   FXuchar bytes[20];
-  FXint p,h;
+  FXint p;
 
   if (input->read(&bytes,20)!=20)
     return false;
@@ -211,112 +752,19 @@ FXbool FlacReader::sync(FXlong & offset,FXlong & sample,FXuint & blocksize) {
       // Match frame header start
       if (match_frame_header(bytes+p,blocking_strategy)) {
 
-        h=p;
-
-        // Match samplesize (invalid values were already filtered out)
-        switch(bytes[h+3]&0xf){
-          case  2: samplesize =  8; break;
-          case  4: samplesize = 12; break;
-          case  8: samplesize = 16; break;
-          case 10: samplesize = 20; break;
-          case 12: samplesize = 24; break;
-          case 14: samplesize = 32; break;
-          default: samplesize = af.bps(); break;
-          }
-        if (samplesize!=af.bps()) continue;
-
-        // Match samplerate
-        const FXuchar sr = bytes[h+2]&0xf;
-        switch(sr){
-          case  0: samplerate=af.rate; break;
-          case  1: samplerate=88200;   break;
-          case  2: samplerate=176400;  break;
-          case  3: samplerate=192000;  break;
-          case  4: samplerate=8000;    break;
-          case  5: samplerate=16000;   break;
-          case  6: samplerate=22050;   break;
-          case  7: samplerate=24000;   break;
-          case  8: samplerate=32000;   break;
-          case  9: samplerate=44100;   break;
-          case 10: samplerate=48000;   break;
-          case 11: samplerate=96000;   break;
-          default: samplerate=0;       break;
-          }
-        if (samplerate && samplerate!=af.rate) continue;
-
-        // Match blocksize [for fixed blocksize streams]
-        const FXuchar bs = bytes[h+2]>>4;
-        if (minblocksize==maxblocksize && bs!=6 && bs!=7) {
-          if (bs==1)
-            blocksize=192;
-          else if (bs>=8)
-            blocksize=256<<(bs-8);
-          else
-            blocksize=576<<(bs-2);
-          if (blocksize!=minblocksize) continue;
-          }
-
-        // Match Channel Count
-        const FXuchar ch = bytes[h+3]>>4;
-        if (ch<0x7) {
-          if (af.channels!=(ch+1)) continue;
-          }
-        else if (af.channels!=2) continue;
-
         // Get remaining bytes
-        memmove(bytes,bytes+p,20-p);
-        if (input->read(bytes+20-p,p)!=p)
-          return false;
-        p=0;h=4;
-
-
-        // read frame or sample
-        if (minblocksize==maxblocksize) {
-          const FXint n = parse_utf_value(bytes+h,framenumber);
-          if (n==0) continue;
-          h+=n;
-          sample=minblocksize*framenumber;
-          }
-        else {
-          const FXint n = parse_utf_value(bytes+h,sample);
-          if (n==0) continue;
-          h+=n;
+        if (p) {
+          memmove(bytes,bytes+p,20-p);
+          if (input->read(bytes+20-p,p)!=p)
+            return false;
+          p=0;
           }
 
         // Check sample number
-        if (sample<0 || sample>stream_length) continue;
-
-        if (bs==6) { // read 8-bit blocksize
-          blocksize = 1 + bytes[h++];
-          if (minblocksize==maxblocksize && blocksize!=minblocksize) continue;
-          }
-        else if (bs==7) { // read 16-bit blocksize
-          blocksize = 1 + (static_cast<FXuint>(bytes[h]) << 8 | static_cast<FXuint>(bytes[h+1]));
-          h+=2;
-          if (minblocksize==maxblocksize && blocksize!=minblocksize) continue;
-          }
-
-        if (sr==12) { // read 8-bit samplerate
-          samplerate = bytes[h++]*1000;
-          if (samplerate!=af.rate) continue;
-          }
-        else if (sr>=13) { // read 16-bit samplerate
-          samplerate = (static_cast<FXuint>(bytes[h]) << 8 | static_cast<FXuint>(bytes[h+1]));
-          h+=2;
-          if (sr==14) samplerate *= 10;
-          if (samplerate!=af.rate) continue;
-          }
-
-        crc = 0;
-        for (FXuchar c=0;c<h;c++){
-          crc = crc8_lookup[crc ^ bytes[c]];
-          }
-        if (crc!=bytes[h++]){
-          continue;
+        if (parse_frame_header(bytes,af,minblocksize,maxblocksize,sample,blocksize) && sample>=0 && sample<=stream_length) {
+          offset=input->position()-20;
+          return true;
           }
-
-        offset=input->position()-20;
-        return true;
         }
       }
     FXASSERT(p==16);
@@ -342,6 +790,18 @@ FXbool FlacReader::seek(FXlong target) {
   FXuint framesize = ((minframesize+maxframesize) / 2) + 1;
   FXint count=0;
 
+  // Use the frame index if we have one
+  if (frameindex.find(target,min_offset)) {
+    input->position(min_offset,FXIO::Begin);
+    return true;
+    }
+
+  // Index only gets build for uninterrupted playback
+  if (frameindex.build()) {
+    frameindex.abort();
+    indexer.reset();
+    }
+
 
   // Use seektable to reduce search range
   for (FXint i=0;i<seektable.no();i++) {
@@ -409,6 +869,27 @@ FXbool FlacReader::seek(FXlong target) {
   }
 
 
+void FlacReader::index_frames(const FXuchar * data,FXival nbytes) {
+  const FXbool eos = (nbytes==0);
+  FXival length;
+
+  indexer.buffer.append(data,nbytes);
+  while(indexer.find(eos,length)) {
+    frameindex.add(indexer.offset,indexer.sample);
+    if (!frameindex.build()) {
+      indexer.reset();
+      return;
+      }
+    indexer.consume(length);
+    }
+
+  if (eos) {
+    frameindex.save();
+    indexer.reset();
+    }
+  }
+
+
 ReadStatus FlacReader::process(Packet*p) {
   if (!(flags&FLAG_PARSED)) {
     ReadStatus result = parse();
@@ -417,7 +898,26 @@ ReadStatus FlacReader::process(Packet*p) {
       return result;
       }
     }
-  return ReaderPlugin::process(p);
+
+  if (!frameindex.build())
+    return ReaderPlugin::process(p);
+
+  // Build the frame index while passing on the data
+  FXival nread = input->read(p->ptr(),p->space());
+  if (nread<0) {
+    p->unref();
+    return ReadError;
+    }
+
+  index_frames(p->ptr(),nread);
+
+  p->af=af;
+  p->wroteBytes(nread);
+  p->flags=(nread==0) ? FLAG_EOS : 0;
+  p->stream_position=-1;
+  p->stream_length=0;
+  context->post_packet(p);
+  return (nread==0) ? ReadDone : ReadOk;
   }
 
 
@@ -532,27 +1032,19 @@ FXbool flac_audioformat(const FXuchar * info,AudioFormat & af,FXlong & stream_le
 
 
 FXbool FlacReader::parse_streaminfo() {
-  if (!input->read_uint16_be(minblocksize))
-    return false;
-
-  if (!input->read_uint16_be(maxblocksize))
-    return false;
-
-  if (!input->read_uint24_be(minframesize))
-    return false;
 
-  if (!input->read_uint24_be(maxframesize))
+  // Keep the raw block around for the frame decoders
+  if (input->read(streaminfo,34)!=34)
     return false;
 
-  FXuchar info[8];
-
-  if (input->read(&info,8)!=8)
-    return false;
+  minblocksize = (static_cast<FXushort>(streaminfo[0])<<8) | streaminfo[1];
+  maxblocksize = (static_cast<FXushort>(streaminfo[2])<<8) | streaminfo[3];
+  minframesize = (static_cast<FXuint>(streaminfo[4])<<16) | (static_cast<FXuint>(streaminfo[5])<<8) | streaminfo[6];
+  maxframesize = (static_cast<FXuint>(streaminfo[7])<<16) | (static_cast<FXuint>(streaminfo[8])<<8) | streaminfo[9];
 
-  if (!flac_audioformat(info,af,stream_length))
+  if (!flac_audioformat(streaminfo+10,af,stream_length))
     return false;
 
-  input->position(16,FXIO::Current);
   return true;
   }
 
@@ -682,8 +1174,25 @@ ReadStatus FlacReader::parse() {
 
       flags|=FLAG_PARSED;
 
+      frameindex.init(input,stream_start,stream_length,minblocksize,maxblocksize);
+      if (frameindex.build()) {
+        indexer.af=af;
+        indexer.minblocksize=minblocksize;
+        indexer.maxblocksize=maxblocksize;
+        indexer.reset(stream_start);
+        }
+
       ConfigureEvent * config = new ConfigureEvent(af,Codec::FLAC,stream_length);
       config->replaygain=gain;
+
+      // Local files may be split into frames and decoded in parallel
+      if (!input->serial()) {
+        FlacConfig * flac_config = new FlacConfig;
+        flac_config->minblocksize = minblocksize;
+        flac_config->maxblocksize = maxblocksize;
+        memcpy(flac_config->streaminfo,streaminfo,34);
+        config->dc = flac_config;
+        }
       context->post_configuration(config);
       if (meta) {
         context->post_meta(meta);
@@ -700,7 +1209,6 @@ FLAC__StreamDecoderWriteStatus FlacDecoder::flac_decoder_write(const FLAC__Strea
   FlacDecoder * plugin = static_cast<FlacDecoder*>(client_data);
   FXASSERT(frame);
   FXASSERT(buffer);
-  FXint s,c,p=0;
   FXint sample  = 0;
   FXint nchannels = frame->header.channels;
   FXint ncopy;
@@ -715,6 +1223,10 @@ FLAC__StreamDecoderWriteStatus FlacDecoder::flac_decoder_write(const FLAC__Strea
   if (nframes==0)
     return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
 
+  const InterleaveFunc interleave = interleave_planar(frame->header.bits_per_sample,nchannels);
+  if (interleave==nullptr)
+    return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+
   Packet * packet = plugin->out;
   if (packet) {
     FXASSERT(packet->stream_position+packet->numFrames()==stream_position);
@@ -747,50 +1259,7 @@ FLAC__StreamDecoderWriteStatus FlacDecoder::flac_decoder_write(const FLAC__Strea
       }
 
     ncopy = FXMIN(nframes,packet->availableFrames());
-    switch(frame->header.bits_per_sample) {
-      case 8:
-        {
-          FXchar * buf8 = packet->s8();
-          for (p=0,s=sample;s<(ncopy+sample);s++)
-            for (c=0;c<nchannels;c++,p++)
-              buf8[p]=buffer[c][s];
-        }
-        break;
-      case 16:
-        {
-          FXshort * buf16 = packet->s16();
-          for (p=0,s=sample;s<(ncopy+sample);s++)
-            for (c=0;c<nchannels;c++,p++)
-              buf16[p]=buffer[c][s];
-        }
-        break;
-      case 24:
-        {
-          FXchar * buf8 = packet->s8();
-          for (p=0,s=sample;s<(ncopy+sample);s++) {
-            for (c=0;c<nchannels;c++,p+=3) {
-              buf8[p+0]=(buffer[c][s]&0xFF);
-              buf8[p+1]=(buffer[c][s]&0xFF00)>>8;
-              buf8[p+2]=(buffer[c][s]&0xFF0000)>>16;
-              }
-            }
-        }
-        break;
-      case 32:
-        {
-          FXchar * buf8 = packet->s8();
-          for (p=0,s=sample;s<(ncopy+sample);s++) {
-            for (c=0;c<nchannels;c++,p+=4) {
-              buf8[p+0]=(buffer[c][s]&0xFF);
-              buf8[p+1]=(buffer[c][s]&0xFF00)>>8;
-              buf8[p+2]=(buffer[c][s]&0xFF0000)>>16;
-              buf8[p+3]=(buffer[c][s]&0xFF000000)>>24;
-              }
-            }
-        }
-        break;
-      default: return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT; break;
-      }
+    interleave(buffer,sample,ncopy,packet->ptr());
     sample+=ncopy;
     nframes-=ncopy;
     stream_position+=ncopy;
@@ -882,11 +1351,191 @@ void FlacDecoder::flac_decoder_error(const FLAC__StreamDecoder */*decoder*/, FLA
 #endif
   }
 
+
+
+FlacFrameQueue::FlacFrameQueue() {
+  }
+
+FlacFrameQueue::~FlacFrameQueue() {
+  mutex.lock();
+  quit=true;
+  condition_work.broadcast();
+  mutex.unlock();
+  for (FXint i=0;i<workers.no();i++) {
+    workers[i]->join();
+    delete workers[i];
+    }
+  }
+
+FXbool FlacFrameQueue::start(FXint nthreads) {
+  FXASSERT(workers.no()==0);
+
+  // Keep every worker busy while the oldest frame is being written out
+  frames.no(nthreads*2);
+
+  for (FXint i=0;i<nthreads;i++) {
+    FlacFrameWorker * worker = new FlacFrameWorker(this);
+    if (!worker->init() || !worker->start()) {
+      delete worker;
+      break;
+      }
+    workers.append(worker);
+    }
+  GM_DEBUG_PRINT("[flac] started %d frame decoders\n",workers.no());
+  return workers.no()>0;
+  }
+
+FlacFrame * FlacFrameQueue::reserve() {
+  if (nsubmitted-ncollected<(FXuint)frames.no())
+    return &frames[nsubmitted%frames.no()];
+  return nullptr;
+  }
+
+void FlacFrameQueue::submit() {
+  FXScopedMutex lock(mutex);
+  frames[nsubmitted%frames.no()].done=false;
+  nsubmitted++;
+  condition_work.signal();
+  }
+
+FlacFrame * FlacFrameQueue::wait() {
+  if (ncollected==nsubmitted)
+    return nullptr;
+  FXScopedMutex lock(mutex);
+  FlacFrame & frame = frames[ncollected%frames.no()];
+  while(!frame.done)
+    condition_done.wait(mutex);
+  return &frame;
+  }
+
+void FlacFrameQueue::release() {
+  FXASSERT(ncollected<nsubmitted);
+  ncollected++;
+  }
+
+void FlacFrameQueue::clear() {
+  while(wait()) release();
+  }
+
+FlacFrame * FlacFrameQueue::take() {
+  FXScopedMutex lock(mutex);
+  while(!quit && ntaken==nsubmitted)
+    condition_work.wait(mutex);
+  if (quit)
+    return nullptr;
+  return &frames[(ntaken++)%frames.no()];
+  }
+
+void FlacFrameQueue::finish(FlacFrame * frame) {
+  FXScopedMutex lock(mutex);
+  frame->done=true;
+  condition_done.signal();
+  }
+
+
+
+FlacFrameWorker::FlacFrameWorker(FlacFrameQueue * q) : queue(q) {
+  }
+
+FlacFrameWorker::~FlacFrameWorker() {
+  if (flac) {
+    FLAC__stream_decoder_finish(flac);
+    FLAC__stream_decoder_delete(flac);
+    flac = nullptr;
+    }
+  }
+
+FXbool FlacFrameWorker::init() {
+  flac = FLAC__stream_decoder_new();
+  if (flac == nullptr)
+    return false;
+
+  FLAC__stream_decoder_set_md5_checking(flac,false);
+
+  if (FLAC__stream_decoder_init_stream(flac,flac_decoder_read,nullptr,nullptr,nullptr,nullptr,
+                                          flac_decoder_write,nullptr,
+                                          flac_decoder_error,
+                                          this)!=FLAC__STREAM_DECODER_INIT_STATUS_OK){
+    return false;
+    }
+  return true;
+  }
+
+FXint FlacFrameWorker::run() {
+  ap_set_thread_name("ap_flac_worker");
+  while((frame=queue->take())!=nullptr) {
+    frame->nframes=0;
+    frame->pcm.clear();
+    position=0;
+
+    // Frame headers may refer to the STREAMINFO for the samplerate and
+    // sample size, so reset the decoder and replay the stream header first.
+    FLAC__stream_decoder_reset(flac);
+    do {
+      if (!FLAC__stream_decoder_process_single(flac))
+        break;
+      }
+    while(FLAC__stream_decoder_get_state(flac)<FLAC__STREAM_DECODER_END_OF_STREAM);
+
+    queue->finish(frame);
+    }
+  return 0;
+  }
+
+FLAC__StreamDecoderWriteStatus FlacFrameWorker::flac_decoder_write(const FLAC__StreamDecoder */*decoder*/, const FLAC__Frame *frame, const FLAC__int32 *const buffer[], void *client_data) {
+  FlacFrameWorker * worker = static_cast<FlacFrameWorker*>(client_data);
+  const FXint nframes = frame->header.blocksize;
+  const FXint framesize = worker->queue->framesize;
+
+  const InterleaveFunc interleave = interleave_planar(frame->header.bits_per_sample,frame->header.channels);
+  if (interleave==nullptr)
+    return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+
+  FlacFrame * output = worker->frame;
+  const FXint offset = output->pcm.no();
+  if (!output->pcm.no(offset+nframes*framesize))
+    return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+
+  interleave(buffer,0,nframes,output->pcm.data()+offset);
+  output->nframes+=nframes;
+  return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+  }
+
+FLAC__StreamDecoderReadStatus FlacFrameWorker::flac_decoder_read(const FLAC__StreamDecoder */*decoder*/, FLAC__byte buffer[], size_t *bytes, void *client_data) {
+  FlacFrameWorker * worker = static_cast<FlacFrameWorker*>(client_data);
+  const FlacFrame * frame = worker->frame;
+  const FXival nheader = sizeof(worker->queue->header);
+
+  if (worker->position<nheader) {
+    const FXival ncopy = FXMIN(static_cast<FXival>(*bytes),nheader-worker->position);
+    memcpy(buffer,worker->queue->header+worker->position,ncopy);
+    worker->position+=ncopy;
+    (*bytes)=ncopy;
+    return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+    }
+
+  const FXival ncopy = FXMIN(static_cast<FXival>(*bytes),frame->data.no()-(worker->position-nheader));
+  if (ncopy<=0) {
+    (*bytes)=0;
+    return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+    }
+  memcpy(buffer,frame->data.data()+(worker->position-nheader),ncopy);
+  worker->position+=ncopy;
+  (*bytes)=ncopy;
+  return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+  }
+
+void FlacFrameWorker::flac_decoder_error(const FLAC__StreamDecoder */*decoder*/, FLAC__StreamDecoderErrorStatus/*status*/, void */*client_data*/) {
+  }
+
+
+
 FlacDecoder::FlacDecoder(DecoderContext * e) : DecoderPlugin(e), flac(nullptr),in(nullptr),out(nullptr) {
   }
 
 FlacDecoder::~FlacDecoder() {
   flush();
+  delete queue;
   if (flac) {
     FLAC__stream_decoder_finish(flac);
     FLAC__stream_decoder_delete(flac);
@@ -919,11 +1568,45 @@ FXbool FlacDecoder::init(ConfigureEvent*event) {
     }
   af=event->af;
   stream_length=event->stream_length;
+
+  // Seekable streams may be decoded in parallel
+  const FlacConfig * config = dynamic_cast<FlacConfig*>(event->dc);
+  const FXint nthreads = (config) ? context->get_decode_threads() : 0;
+  if (queue && queue->threads()!=nthreads) {
+    delete queue;
+    queue=nullptr;
+    }
+  if (queue==nullptr && nthreads>1) {
+    queue = new FlacFrameQueue;
+    if (!queue->start(nthreads)) {
+      delete queue;
+      queue=nullptr;
+      }
+    }
+  if (queue) {
+    queue->framesize=af.framesize();
+    parser.af=af;
+    parser.minblocksize=config->minblocksize;
+    parser.maxblocksize=config->maxblocksize;
+    reset_frames();
+
+    // "fLaC" followed by a last STREAMINFO metadata block
+    queue->header[0]='f';
+    queue->header[1]='L';
+    queue->header[2]='a';
+    queue->header[3]='C';
+    queue->header[4]=0x80;
+    queue->header[5]=0;
+    queue->header[6]=0;
+    queue->header[7]=34;
+    memcpy(queue->header+8,config->streaminfo,34);
+    }
   return true;
   }
 
 FXbool FlacDecoder::flush(FXlong offset) {
   DecoderPlugin::flush(offset);
+  if (queue) reset_frames();
   FLAC__stream_decoder_flush(flac);
   if (in) {
     in->unref();
@@ -936,7 +1619,138 @@ FXbool FlacDecoder::flush(FXlong offset) {
   return true;
   }
 
+void FlacDecoder::reset_frames() {
+  queue->clear();
+  parser.reset();
+  }
+
+
+/*
+  Write out the oldest decoded frame
+*/
+FXbool FlacDecoder::write_frame() {
+  FlacFrame * frame = queue->wait();
+  FXASSERT(frame);
+
+  const FXint framesize = af.framesize();
+  FXlong stream_position = frame->sample;
+  FXint  nframes = frame->nframes;
+  FXint  sample = 0;
+  FXint  ncopy;
+
+  // Corrupt frames leave a gap
+  if (out && out->numFrames() && out->stream_position+out->numFrames()!=stream_position) {
+    context->post_output_packet(out);
+    }
+
+  if (stream_position<stream_decode_offset) {
+    FXlong offset = FXMIN(nframes,stream_decode_offset-stream_position);
+    GM_DEBUG_PRINT("[flac] stream decode offset %ld. Skipping %ld of %ld \n",stream_decode_offset,offset,stream_decode_offset-stream_position);
+    nframes-=offset;
+    stream_position+=offset;
+    sample+=offset;
+    }
+
+  while(nframes>0) {
+
+    /// get a fresh packet
+    if (!out) {
+      out=context->get_output_packet();
+      if (out==nullptr) {
+        queue->release();
+        return false;
+        }
+      out->af=af;
+      out->stream_position=stream_position;
+      out->stream_length=stream_length;
+      }
+    else if (out->numFrames()==0) {
+      out->stream_position=stream_position;
+      }
+
+    ncopy = FXMIN(nframes,out->availableFrames());
+    memcpy(out->ptr(),frame->pcm.data()+(sample*framesize),ncopy*framesize);
+    sample+=ncopy;
+    nframes-=ncopy;
+    stream_position+=ncopy;
+    out->wroteFrames(ncopy);
+    if (out->availableFrames()==0) {
+      context->post_output_packet(out);
+      }
+    }
+  queue->release();
+  return true;
+  }
+
+
+/*
+  Split the input into frames and decode them on the frame workers.
+*/
+FXbool FlacDecoder::process_frames(Packet * packet) {
+  FlacFrame * frame;
+  FXival length;
+  FXbool eos;
+  FXbool result=true;
+
+  for (;;) {
+    eos = packet->flags&FLAG_EOS;
+    parser.buffer.append(packet->data(),packet->size());
+    packet->unref();
+
+    while(parser.find(eos,length)) {
+
+      // Wait for a free frame
+      while((frame=queue->reserve())==nullptr) {
+        if (!write_frame()) {
+          result=false;
+          goto done;
+          }
+        }
+
+      frame->data.assign(parser.buffer.data(),length);
+      frame->sample=parser.sample;
+      queue->submit();
+      parser.consume(length);
+      }
+
+    if (eos) {
+      while(queue->wait()) {
+        if (!write_frame()) {
+          result=false;
+          goto done;
+          }
+        }
+      break;
+      }
+
+    packet=context->get_input_packet();
+    if (packet==nullptr) {
+      result=false;
+      break;
+      }
+    }
+
+done:
+  if (result) {
+    context->post_output_packet(out);
+    }
+  reset_frames();
+  if (out) {
+    out->unref();
+    out=nullptr;
+    }
+  {
+    Packet * nullpacket = nullptr;
+    context->post_output_packet(nullpacket,true);
+  }
+  return true;
+  }
+
+
 FXbool FlacDecoder::process(Packet*packet){
+  if (queue) {
+    return process_frames(packet);
+    }
   if (flac) {
     FXASSERT(in==nullptr);
     FXASSERT(out==nullptr);
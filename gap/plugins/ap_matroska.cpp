@@ -102,33 +102,64 @@ struct Block {
   };
 
 
-class Track {
+/*
+  Known cluster positions sorted by offset. Filled from the cues and from
+  any cluster read during playback or seeking. Entries from the cues carry the
+  cue time, which is never before the actual timecode of the cluster.
+*/
+class ClusterIndex {
+protected:
+  struct Entry {
+    FXlong  offset;
+    FXulong timecode;
+    };
+  FXArray<Entry> entries;
 public:
+  void clear() { entries.clear(); }
 
+  void add(FXlong offset,FXulong timecode) {
+    FXint l=0,h=entries.no();
+    while(l<h) {
+      const FXint m=(l+h)>>1;
+      if (entries[m].offset<offset) l=m+1; else h=m;
+      }
+    if (l<entries.no() && entries[l].offset==offset) {
+      entries[l].timecode=FXMIN(entries[l].timecode,timecode);
+      }
+    else {
+      const Entry entry = {offset,timecode};
+      entries.insert(l,entry);
+      }
+    }
 
-  struct cue_entry {
-    FXlong position;
-    FXlong cluster;
-    };
+  // Find last cluster at or before timecode and the offset of the one after it
+  FXbool find(FXulong timecode,FXlong & offset,FXlong & next) const {
+    FXint l=0,h=entries.no();
+    while(l<h) {
+      const FXint m=(l+h)>>1;
+      if (entries[m].timecode<=timecode) l=m+1; else h=m;
+      }
+    if (l<entries.no())
+      next=entries[l].offset;
+    if (l==0)
+      return false;
+    offset=entries[l-1].offset;
+    return true;
+    }
+  };
 
 
+// Bisect while the seek range is larger than this
+const FXlong max_cluster_scan = 65536;
+
+
+class Track {
 public:
   AudioFormat af;
   DecoderConfig * dc = nullptr;
   FXuchar     codec  = Codec::Invalid;
   FXulong     number = 0;
   FXushort    samples_per_frame = 0;
-  FXArray<cue_entry> cues;
-  FXint             ncues=0;
-
-  void add_cue_entry(FXlong pos,FXlong cluster) {
-    if (cues.no()>=ncues) {
-      cues.no(cues.no()+256);
-      }
-    cues[ncues].position = pos;
-    cues[ncues].cluster  = cluster;
-    ncues++;
-    }
 
   ~Track() {
     delete dc;
@@ -152,9 +183,14 @@ protected:
   Block   block;   // current block
   Element cluster; // current cluster
   Element group;   // current group
+protected:
+  ClusterIndex clusters;
+  FXlong       segment_start = 0;
+  FXlong       segment_end   = 0;
+  FXlong       cues_position = 0;
 protected:
   FXbool  is_webm         = false;
-  FXlong  stream_position = 0;
+  FXlong  stream_position = -1;
   FXulong timecode_scale  = 1000000;
   FXulong duration        = 0;
   FXlong  first_cluster   = 0;
@@ -198,6 +234,9 @@ protected:
   FXbool parse_cue_point(Element&);
   FXbool parse_cue_track(Element&,FXulong & track,FXulong & cluster);
 
+  FXbool read_cluster(FXlong offset,FXulong & timecode);
+  FXbool find_cluster(FXlong from,FXlong to,FXlong & offset,FXulong & timecode);
+
 protected:
   void clear_tracks();
 public:
@@ -253,8 +292,12 @@ FXbool MatroskaReader::init(InputPlugin*plugin) {
   timecode_scale  = 1000000;
   first_cluster   = 0;
   frame_size      = 0;
-  stream_position = 0;
+  stream_position = -1;
   duration        = 0;
+  segment_start   = 0;
+  segment_end     = 0;
+  cues_position   = 0;
+  clusters.clear();
   cluster.reset();
   block.reset();
   group.reset();
@@ -265,23 +308,102 @@ FXbool MatroskaReader::can_seek() const {
   return true;
   }
 
+
+// Read the timecode of the cluster at offset
+FXbool MatroskaReader::read_cluster(FXlong offset,FXulong & timecode) {
+  Element element;
+  Element child;
+
+  input->position(offset,FXIO::Begin);
+
+  if (!parse_element(element) || element.type!=CLUSTER)
+    return false;
+
+  // Timecode should be first, but may be preceded by a crc or void element
+  for (FXint i=0;i<3 && parse_element(element,child,true);i++) {
+    if (child.type==TIMECODE)
+      return (child.size<=8 && parse_unsigned_int(timecode,child.size));
+
+    if (child.size<0)
+      return false;
+
+    input->position(child.size,FXIO::Current);
+    }
+  return false;
+  }
+
+
+// Find the first cluster that starts between from and to
+FXbool MatroskaReader::find_cluster(FXlong from,FXlong to,FXlong & offset,FXulong & timecode) {
+  FXuchar buffer[4096];
+
+  while(from+4<=to) {
+
+    input->position(from,FXIO::Begin);
+
+    const FXival nread = input->read(buffer,FXMIN((FXlong)sizeof(buffer),to-from));
+    if (nread<4)
+      return false;
+
+    for (FXival i=0;i<=nread-4;i++) {
+      if (buffer[i]==0x1f && buffer[i+1]==0x43 && buffer[i+2]==0xb6 && buffer[i+3]==0x75) {
+        if (read_cluster(from+i,timecode)) {
+          offset=from+i;
+          return true;
+          }
+        }
+      }
+    from+=nread-3;
+    }
+  return false;
+  }
+
+
 FXbool MatroskaReader::seek(FXlong offset){
   if (track->codec==Codec::Opus)
     offset = FXMAX(0,offset-3840);
 
-  FXulong target  = (offset * NANOSECONDS_PER_SECOND) /  af.rate;
-  FXlong lastpos = 0;
-  FXlong timestamp = 0;
-  for (FXint i=0;i<track->ncues;i++) {
-    if (target<track->cues[i].position*timecode_scale) {
-      lastpos = track->cues[i].cluster;
-      timestamp = track->cues[i].position*timecode_scale;
-      continue;
+  if (first_cluster==0)
+    return false;
+
+  const FXulong target = ((offset * NANOSECONDS_PER_SECOND) / af.rate) / timecode_scale;
+
+  FXlong  lower = first_cluster;
+  FXlong  upper = (segment_end>0) ? segment_end : input->size();
+  FXlong  position;
+  FXulong timecode;
+
+  // Start with the closest known clusters around the target
+  clusters.find(target,lower,upper);
+
+  // Bisect until the range is small enough to read through
+  while(upper-lower>max_cluster_scan) {
+    const FXlong middle = lower + ((upper-lower)>>1);
+    if (find_cluster(middle,upper,position,timecode)) {
+      clusters.add(position,timecode);
+      if (timecode<=target)
+        lower=position;
+      else
+        upper=position;
+      }
+    else {
+      upper=middle;
       }
-    break;
     }
-  input->position(first_cluster+lastpos,FXIO::Begin);
-  stream_position = (timestamp * track->af.rate) / NANOSECONDS_PER_SECOND;
+
+  // Get the exact start of the cluster
+  if (!read_cluster(lower,timecode)) {
+    lower=first_cluster;
+    if (!read_cluster(lower,timecode))
+      return false;
+    }
+
+  clusters.add(lower,timecode);
+
+  GM_DEBUG_PRINT("[matroska] seek to cluster at %ld with timecode %lu for target %lu\n",lower,timecode,target);
+
+  input->position(lower,FXIO::Begin);
+  stream_position = (timecode * timecode_scale * track->af.rate) / NANOSECONDS_PER_SECOND;
 
   frame_size=0;
   cluster.reset();
@@ -300,6 +422,12 @@ ReadStatus MatroskaReader::process(Packet*packet) {
   packet->stream_length=stream_length;
   packet->af=af;
 
+  // Position of the first frame after a seek
+  if (stream_position!=-1) {
+    packet->stream_position=stream_position;
+    stream_position=-1;
+    }
+
   while(packet->space()) {
 
     if (frame_size) {
@@ -411,6 +539,8 @@ ReadStatus MatroskaReader::parse() {
   // Find First Segment
   while(parse_element(element)) {
     if (element.type==SEGMENT) {
+      segment_start = input->position();
+      segment_end   = (element.size>0) ? segment_start+element.size : 0;
       if (!parse_segment(element)) {
         return ReadError;
         }
@@ -633,6 +763,7 @@ FXbool MatroskaReader::get_next_frame(FXuint & framesize) {
           {
             FXulong timecode=0;
             if (!parse_unsigned_int(timecode,element.size)) return false;
+            clusters.add(cluster.offset,timecode);
             block.position = (timecode*timecode_scale*track->af.rate) / NANOSECONDS_PER_SECOND;
             break;
           }
@@ -1123,7 +1254,7 @@ FXbool MatroskaReader::parse_cue_point(Element & container) {
   if (has_cuetrack && has_cuetime) {
     for (FXint i=0;i<tracks.no();i++) {
       if (tracks[i]->number==cuetrack) {
-        tracks[i]->add_cue_entry(cuetime,cluster_position);
+        clusters.add(segment_start+cluster_position,cuetime);
         break;
         }
       }
@@ -1233,11 +1364,15 @@ FXbool MatroskaReader::parse_segment(Element & container) {
           if (first_cluster==0)
             first_cluster=element.offset;
 
-          if (input->serial())
-            return true;
-
-          input->position(element.size,FXIO::Current);
-
+          // Clusters are indexed lazily, only jump ahead to cues listed in the seekhead
+          if (cues_position && !input->serial()) {
+            input->position(cues_position,FXIO::Begin);
+            if (parse_element(element) && element.type==CUES) {
+              if (!parse_cues(element))
+                return false;
+              }
+            }
+          return true;
         } break;
 
       case CUES:
@@ -1245,6 +1380,7 @@ FXbool MatroskaReader::parse_segment(Element & container) {
           if (!parse_cues(element))
             return false;
 
+          cues_position=0;
           break;
         }
       default       :
@@ -1274,14 +1410,22 @@ FXbool MatroskaReader::parse_seekhead(Element & container) {
   }
 
 FXbool MatroskaReader::parse_seek(Element & container) {
+  FXulong id=0;
+  FXulong position=0;
   Element element;
   while(parse_element(container,element)) {
     switch(element.type) {
       case SEEK_ID:
-        input->position(element.size,FXIO::Current);
+        if (element.size>4)
+          input->position(element.size,FXIO::Current);
+        else if (!parse_uint64(id,element.size))
+          return false;
         break;
       case SEEK_POSITION:
-        input->position(element.size,FXIO::Current);
+        if (element.size>8)
+          input->position(element.size,FXIO::Current);
+        else if (!parse_uint64(position,element.size))
+          return false;
         break;
       default:
         element.debug("Seek.Entry");
@@ -1289,6 +1433,8 @@ FXbool MatroskaReader::parse_seek(Element & container) {
         break;
       }
     }
+  if (id==CUES && position>0)
+    cues_position = segment_start+position;
   return true;
   }
 
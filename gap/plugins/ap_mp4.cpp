@@ -34,17 +34,27 @@ class Track {
   struct stts_entry {
     FXuint nsamples;
     FXuint delta;
+    FXuint sample;      // first sample of this entry
+    FXlong position;    // position of the first sample of this entry
     };
 
   struct stsc_entry {
     FXint first;
     FXint nsamples;
     FXint index;
+    FXuint sample;      // first sample of this entry
     };
 
   struct ctts_entry {
     FXint nsamples;
     FXint offset;
+    FXuint sample;      // first sample of this entry
+    };
+
+  struct sample_cursor {
+    FXuint sample = 0;  // last located sample
+    FXuint next   = 0;  // first sample of the next chunk
+    FXlong offset = -1; // file offset of sample
     };
 
 public:
@@ -54,18 +64,57 @@ public:
   FXushort                samples_per_frame = 0;        // number of pcm samples in a frame (used by AAC)
   FXbool                  upsampled = false;
   DecoderSpecificConfig * dc = nullptr;
+  FXArray<FXushort>       stsz16;                       // samples size lookup table, if all sizes fit in 16 bits
   FXArray<FXuint>         stsz;                         // samples size lookup table (in bytes)
   FXArray<FXuint>         stco;                         // chunk offset table
+  FXArray<FXlong>         co64;                         // chunk offset table, only if offsets don't fit in 32 bits
   FXArray<stts_entry>     stts;                         // time to sample number lookup table
   FXArray<stsc_entry>     stsc;                         // chunk-to-sample table
   FXArray<ctts_entry>     ctts;
+protected:
+  FXuint                  total_samples = 0;            // number of samples in track
+  FXlong                  total_length = 0;             // length of track in (non-upsampled) pcm samples
+  sample_cursor           cursor;                       // last located sample for sequential access
 public:
   Track() {}
   ~Track() { delete dc; }
 public:
+
+  // Build the cumulative sample and position indices after parsing.
+  void index() {
+    FXuint nsamples = 0;
+    FXlong position = 0;
+
+    for (FXint i=0;i<stts.no();i++) {
+      stts[i].sample   = nsamples;
+      stts[i].position = position;
+      nsamples += stts[i].nsamples;
+      position += static_cast<FXlong>(stts[i].delta)*static_cast<FXlong>(stts[i].nsamples);
+      }
+    total_samples = nsamples;
+    total_length  = position;
+
+    nsamples = 0;
+    for (FXint i=0;i<stsc.no();i++) {
+      stsc[i].sample = nsamples;
+      if (i+1<stsc.no())
+        nsamples += (stsc[i+1].first - stsc[i].first) * stsc[i].nsamples;
+      }
+
+    nsamples = 0;
+    for (FXint i=0;i<ctts.no();i++) {
+      ctts[i].sample = nsamples;
+      nsamples += ctts[i].nsamples;
+      }
+
+    cursor = sample_cursor();
+    }
+
   FXlong getChunkOffset(FXuint chunk,FXuint chunk_nsamples,FXuint sample) const {
     FXlong offset;
-    if (stco.no())
+    if (co64.no())
+      offset = co64[FXMIN(chunk,co64.no()-1)];
+    else if (stco.no())
       offset = stco[FXMIN(chunk,stco.no()-1)];
     else
       offset = 8;
@@ -73,6 +122,11 @@ public:
     if (fixed_sample_size) {
       offset += (sample-chunk_nsamples)*fixed_sample_size;
       }
+    else if (stsz16.no()) {
+      for (FXuint i=chunk_nsamples;i<sample;i++) {
+        offset+=stsz16[i];
+        }
+      }
     else {
       for (FXuint i=chunk_nsamples;i<sample;i++) {
         offset+=stsz[i];
@@ -81,108 +135,116 @@ public:
     return offset;
     }
 
-  // Find the chunk that contains sample s. Also return nsamples at start of chunk
-  void getChunk(FXuint s,FXuint & chunk,FXuint & chunk_nsamples) const{
-    FXuint nchunks,nsamples,ntotal=0;
-    for (FXint i=0;i<stsc.no()-1;i++) {
-      nchunks  = (stsc[i+1].first - stsc[i].first);
-      nsamples = nchunks * stsc[i].nsamples;
-      if (s<ntotal+nsamples) {
-        chunk          = stsc[i].first + ((s-ntotal)/stsc[i].nsamples) - 1;
-        chunk_nsamples = ntotal + ((chunk+1)-stsc[i].first) * stsc[i].nsamples;
-        return;
-        }
-      ntotal+=nsamples;
+  // Find the chunk that contains sample s. Also return nsamples at start of chunk and the no. of samples in the chunk
+  void getChunk(FXuint s,FXuint & chunk,FXuint & chunk_nsamples,FXuint & chunk_size) const{
+    FXint lo=0,hi=stsc.no()-1,mid;
+    while(lo<hi) {
+      mid = (lo+hi+1)>>1;
+      if (stsc[mid].sample<=s)
+        lo=mid;
+      else
+        hi=mid-1;
       }
-
-    chunk          = stsc.tail().first + ((s-ntotal) / stsc.tail().nsamples) - 1;
-    chunk_nsamples = ntotal + ((chunk+1) - stsc.tail().first) * stsc.tail().nsamples;
+    const stsc_entry & entry = stsc[lo];
+    chunk          = entry.first + ((s-entry.sample) / entry.nsamples) - 1;
+    chunk_nsamples = entry.sample + ((chunk+1) - entry.first) * entry.nsamples;
+    chunk_size     = entry.nsamples;
     }
 
   // Sample Offset
   FXint getCompositionOffset(FXlong position) const {
-    FXint s = 0;
-    for (int i=0;i<ctts.no();i++){
-      if (position < s + ctts[i].nsamples){
-        if (upsampled)
-          return ctts[i].offset << 1;
-        else
-          return ctts[i].offset;
-        }
-      s+=ctts[i].nsamples;
+    FXint lo=0,hi=ctts.no()-1,mid;
+    if (hi<0)
+      return 0;
+    while(lo<hi) {
+      mid = (lo+hi+1)>>1;
+      if (ctts[mid].sample<=position)
+        lo=mid;
+      else
+        hi=mid-1;
       }
-    return 0;
+    if (position<ctts[lo].sample || position>=ctts[lo].sample+ctts[lo].nsamples)
+      return 0;
+    if (upsampled)
+      return ctts[lo].offset << 1;
+    else
+      return ctts[lo].offset;
     }
 
   FXint getSample(FXlong position) const {
-    FXlong n,ntotal = 0;
-    FXint nsamples = 0;
+    FXint lo=0,hi=stts.no()-1,mid;
 
     if (upsampled) {
       position>>=1;
       }
 
-    for (int i=0;i<stts.no();i++){
-      n = stts[i].nsamples*stts[i].delta;
-      if (position<ntotal+n) {
-        return nsamples+((position-ntotal)/stts[i].delta);
-        }
-      ntotal+=n;
-      nsamples+=stts[i].nsamples;
+    if (position<0 || position>=total_length)
+      return -1;
+
+    while(lo<hi) {
+      mid = (lo+hi+1)>>1;
+      if (stts[mid].position<=position)
+        lo=mid;
+      else
+        hi=mid-1;
       }
-    return -1;
+    return stts[lo].sample + ((position-stts[lo].position) / stts[lo].delta);
     }
 
   FXlong getSamplePosition(FXuint s) const {
-    FXlong pos=0;
-    FXuint nsamples=0;
-    for (int i=0;i<stts.no();i++){
-      if (s<(stts[i].nsamples+nsamples)){
-        pos+=stts[i].delta*(s-nsamples);
-        if (upsampled)
-          return pos << 1;
-        else
-          return pos;
-        }
-      else {
-        pos+=stts[i].delta*stts[i].nsamples;
-        }
-      nsamples+=stts[i].nsamples;
+    FXint lo=0,hi=stts.no()-1,mid;
+    FXlong pos;
+
+    if (s>=total_samples)
+      return 0;
+
+    while(lo<hi) {
+      mid = (lo+hi+1)>>1;
+      if (stts[mid].sample<=s)
+        lo=mid;
+      else
+        hi=mid-1;
       }
-    return 0;
+    pos = stts[lo].position + static_cast<FXlong>(stts[lo].delta)*(s-stts[lo].sample);
+    if (upsampled)
+      return pos << 1;
+    else
+      return pos;
     }
 
   FXlong getLength() const {
-    FXlong length=0;
-    for (int i=0;i<stts.no();i++){
-      length+=static_cast<FXlong>(stts[i].delta)*static_cast<FXlong>(stts[i].nsamples);
-      }
-
     if (upsampled)
-      return length << 1;
+      return total_length << 1;
     else
-      return length;
+      return total_length;
     }
 
-  FXlong getSampleOffset(FXuint s) const {
-    FXuint chunk,nsamples;
-    getChunk(s,chunk,nsamples);
-    return getChunkOffset(chunk,nsamples,s);
+  // Samples are usually read in order, so continue from the previous sample if we can
+  FXlong getSampleOffset(FXuint s) {
+    if (cursor.offset>=0 && s==cursor.sample+1 && s<cursor.next) {
+      cursor.offset += getSampleSize(cursor.sample);
+      cursor.sample  = s;
+      return cursor.offset;
+      }
+    FXuint chunk,nsamples,size;
+    getChunk(s,chunk,nsamples,size);
+    cursor.sample = s;
+    cursor.next   = nsamples + size;
+    cursor.offset = getChunkOffset(chunk,nsamples,s);
+    return cursor.offset;
     }
 
   FXlong getSampleSize(FXuint s) const {
     if (fixed_sample_size)
       return fixed_sample_size;
+    else if (stsz16.no())
+      return stsz16[s];
     else
       return stsz[s];
     }
 
   FXuint getNumSamples() const {
-    FXint nsamples = 0;
-    for (FXint i=0;i<stts.no();i++) {
-      nsamples += stts[i].nsamples;
-      }
-    return nsamples;
+    return total_samples;
     }
   };
 
@@ -205,6 +267,7 @@ protected:
   FXbool atom_parse_alac(FXlong size);
   FXbool atom_parse_stsd(FXlong size);
   FXbool atom_parse_stco(FXlong size);
+  FXbool atom_parse_co64(FXlong size);
   FXbool atom_parse_stsc(FXlong size);
   FXbool atom_parse_stts(FXlong size);
   FXbool atom_parse_stsz(FXlong size);
@@ -217,6 +280,7 @@ protected:
   FXbool atom_parse_meta_free(FXlong size);
   FXbool atom_parse_header(FXuint & atom_type,FXlong & atom_size,FXlong & container);
   FXbool atom_parse(FXlong size);
+  FXbool read_table(FXArray<FXuint> & table,FXuint n,FXuint width,FXlong size);
 protected:
   FXuint   sample = 0;      // current sample
   FXuint   nsamples = 0;    // number of samples
@@ -414,6 +478,8 @@ ReadStatus MP4Reader::parse() {
 
     FXASSERT(track);
 
+    track->index();
+
     stream_length = track->getLength();
     nsamples      = track->getNumSamples();
     sample        = 0;
@@ -498,6 +564,7 @@ enum Atom {
   STSC = DEFINE_ATOM('s','t','s','c'),
   STSZ = DEFINE_ATOM('s','t','s','z'),
   STCO = DEFINE_ATOM('s','t','c','o'),
+  CO64 = DEFINE_ATOM('c','o','6','4'),
   STTS = DEFINE_ATOM('s','t','t','s'),
   CTTS = DEFINE_ATOM('c','t','t','s'),
 
@@ -951,7 +1018,28 @@ FXbool MP4Reader::atom_parse_stsd(FXlong size) {
   }
 
 
-FXbool MP4Reader::atom_parse_stsc(FXlong /*size*/) {
+/*
+  Read a table of n entries of width big endian 32 bit values with a single
+  read, and swap them in place. The table has to fit in the remaining size
+  of the atom.
+*/
+FXbool MP4Reader::read_table(FXArray<FXuint> & table,FXuint n,FXuint width,FXlong size) {
+  const FXlong nvalues = static_cast<FXlong>(n) * width;
+  if (nvalues*4>size)
+    return false;
+  table.no(nvalues);
+  if (input->read(table.data(),nvalues*4)!=nvalues*4)
+    return false;
+#if FOX_BIGENDIAN == 0
+  for (FXlong i=0;i<nvalues;i++) {
+    table[i] = swap32(table[i]);
+    }
+#endif
+  return true;
+  }
+
+
+FXbool MP4Reader::atom_parse_stsc(FXlong size) {
   FXuint version;
   FXuint nentries;
 
@@ -965,23 +1053,47 @@ FXbool MP4Reader::atom_parse_stsc(FXlong /*size*/) {
     return false;
 
   if (nentries) {
+    FXArray<FXuint> table;
+    if (!read_table(table,nentries,3,size-8))
+      return false;
     track->stsc.no(nentries);
-    for (FXuint i=0;i<nentries;i++) {
-      if (!input->read_int32_be(track->stsc[i].first))
-        return false;
-      if (!input->read_int32_be(track->stsc[i].nsamples))
-        return false;
-      if (!input->read_int32_be(track->stsc[i].index))
-        return false;
+    for (FXuint i=0,j=0;i<nentries;i++,j+=3) {
+      track->stsc[i].first    = table[j];
+      track->stsc[i].nsamples = table[j+1];
+      track->stsc[i].index    = table[j+2];
       }
     }
-  //FXASSERT(size==((nentries*12)+8));
   return true;
   }
 
 
 
-FXbool MP4Reader::atom_parse_stco(FXlong/*size*/) {
+FXbool MP4Reader::atom_parse_stco(FXlong size) {
+  FXuint   version;
+  FXuint   nchunks;
+
+  if (track==nullptr)
+    return false;
+
+  if (input->read(&version,4)!=4)
+    return false;
+
+  if (!input->read_uint32_be(nchunks))
+    return false;
+
+  if (nchunks>0) {
+    if (!read_table(track->stco,nchunks,1,size-8))
+      return false;
+    }
+  return true;
+  }
+
+
+/*
+  Large files use 64 bit chunk offsets. Only keep them around if
+  they don't fit in the 32 bit table.
+*/
+FXbool MP4Reader::atom_parse_co64(FXlong size) {
   FXuint   version;
   FXuint   nchunks;
 
@@ -995,17 +1107,33 @@ FXbool MP4Reader::atom_parse_stco(FXlong/*size*/) {
     return false;
 
   if (nchunks>0) {
-    track->stco.no(nchunks);
+    if (static_cast<FXlong>(nchunks)*8>size-8)
+      return false;
+
+    track->co64.no(nchunks);
+    if (input->read(track->co64.data(),static_cast<FXlong>(nchunks)*8)!=static_cast<FXlong>(nchunks)*8)
+      return false;
+
+    FXbool wide = false;
     for (FXuint i=0;i<nchunks;i++) {
-      if (!input->read_uint32_be(track->stco[i]))
-        return false;
+#if FOX_BIGENDIAN == 0
+      track->co64[i] = swap64(track->co64[i]);
+#endif
+      if (track->co64[i]>UINT32_MAX) wide = true;
+      }
+
+    if (!wide) {
+      track->stco.no(nchunks);
+      for (FXuint i=0;i<nchunks;i++) {
+        track->stco[i] = static_cast<FXuint>(track->co64[i]);
+        }
+      track->co64.clear();
       }
     }
-  //FXASSERT(size==((nchunks*4)+8));
   return true;
   }
 
-FXbool MP4Reader::atom_parse_stts(FXlong /*size*/) {
+FXbool MP4Reader::atom_parse_stts(FXlong size) {
   FXuint   version;
   FXuint   nsize;
 
@@ -1019,20 +1147,20 @@ FXbool MP4Reader::atom_parse_stts(FXlong /*size*/) {
     return false;
 
   if (nsize>0) {
+    FXArray<FXuint> table;
+    if (!read_table(table,nsize,2,size-8))
+      return false;
     track->stts.no(nsize);
-    for (FXuint i=0;i<nsize;i++) {
-      if (!input->read_uint32_be(track->stts[i].nsamples)) return false;
-      if (!input->read_uint32_be(track->stts[i].delta)) return false;
-      //GM_DEBUG_PRINT("stts %d: %d %d\n",i,track->stts[i].nsamples,track->stts[i].delta);
+    for (FXuint i=0,j=0;i<nsize;i++,j+=2) {
+      track->stts[i].nsamples = table[j];
+      track->stts[i].delta    = table[j+1];
       }
-
     }
-  //FXASSERT(size==((nsize*8)+8));
   return true;
   }
 
 
-FXbool MP4Reader::atom_parse_ctts(FXlong /*size*/) {
+FXbool MP4Reader::atom_parse_ctts(FXlong size) {
   FXuint version;
   FXuint nentries;
 
@@ -1046,22 +1174,24 @@ FXbool MP4Reader::atom_parse_ctts(FXlong /*size*/) {
     return false;
 
   if (nentries) {
+    FXArray<FXuint> table;
+    if (!read_table(table,nentries,2,size-8))
+      return false;
     track->ctts.no(nentries);
-    for (FXuint i=0;i<nentries;i++) {
-      if (!input->read_int32_be(track->ctts[i].nsamples))
-        return false;
-      if (!input->read_int32_be(track->ctts[i].offset))
-        return false;
-      //GM_DEBUG_PRINT("ctts %d: %d %d\n",i,track->ctts[i].nsamples,track->ctts[i].offset);
+    for (FXuint i=0,j=0;i<nentries;i++,j+=2) {
+      track->ctts[i].nsamples = table[j];
+      track->ctts[i].offset   = table[j+1];
       }
     }
-  //FXASSERT(size==((nentries*12)+8));
   return true;
   }
 
 
-
-FXbool MP4Reader::atom_parse_stsz(FXlong /*size*/) {
+/*
+  Sample sizes are by far the largest table. AAC frames never exceed 16 bits,
+  so we store those in half the space.
+*/
+FXbool MP4Reader::atom_parse_stsz(FXlong size) {
   FXuint version;
   FXuint samplecount;
 
@@ -1078,13 +1208,22 @@ FXbool MP4Reader::atom_parse_stsz(FXlong /*size*/) {
     return false;
 
   if (track->fixed_sample_size==0 && samplecount>0) {
-    track->stsz.no(samplecount);
+    if (!read_table(track->stsz,samplecount,1,size-12))
+      return false;
+
+    FXuint largest = 0;
     for (FXuint i=0;i<samplecount;i++) {
-      if (!input->read_uint32_be(track->stsz[i]))
-        return false;
+      largest = FXMAX(largest,track->stsz[i]);
+      }
+
+    if (largest<=0xFFFF) {
+      track->stsz16.no(samplecount);
+      for (FXuint i=0;i<samplecount;i++) {
+        track->stsz16[i] = static_cast<FXushort>(track->stsz[i]);
+        }
+      track->stsz.clear();
       }
     }
-  //FXASSERT(size==((nsamples*4)+12));
   return true;
   }
 
@@ -1141,6 +1280,7 @@ FXbool MP4Reader::atom_parse(FXlong size) {
       case META: ok=atom_parse_meta(atom_size); break;
       case STSZ: ok=atom_parse_stsz(atom_size); break;
       case STCO: ok=atom_parse_stco(atom_size); break;
+      case CO64: ok=atom_parse_co64(atom_size); break;
       case STSD: ok=atom_parse_stsd(atom_size); break;
       case STSC: ok=atom_parse_stsc(atom_size); break;
       case STTS: ok=atom_parse_stts(atom_size); break;
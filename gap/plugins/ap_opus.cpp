@@ -154,24 +154,43 @@ FXbool OpusDecoderPlugin::process(Packet * packet) {
   FXlong stream_end          = stream_length;
 
   while(get_next_packet(packet)) {
-    FXint nsamples = opus_multistream_decode_float(opus,(unsigned char*)op.packet,op.bytes,pcm,MAX_FRAME_SIZE,0);
+    FXint nsamples = opus_packet_get_nb_samples((unsigned char*)op.packet,op.bytes,48000);
+    FXfloat * output = pcm;
 
-    const FXuchar * pcmi = (const FXuchar*)pcm;
+    // Decode straight into the output packet if the whole frame fits and nothing needs to be skipped
+    if (nsamples>0 && stream_position>=stream_begin) {
+      if (out && out->availableFrames()<nsamples)
+        context->post_output_packet(out);
+
+      if (out==nullptr) {
+        out = context->get_output_packet();
+        if (out==nullptr) {
+          if (packet) packet->unref();
+          return true;
+          }
+        out->stream_position=stream_position - stream_offset_start;
+        out->stream_length=stream_length;
+        out->af=af;
+        }
+
+      if (out->availableFrames()>=nsamples)
+        output = out->flt();
+      }
+
+    if (output==pcm)
+      nsamples = opus_multistream_decode_float(opus,(unsigned char*)op.packet,op.bytes,pcm,MAX_FRAME_SIZE,0);
+    else
+      nsamples = opus_multistream_decode_float(opus,(unsigned char*)op.packet,op.bytes,output,out->availableFrames(),0);
+
+    if (nsamples<=0)
+      continue;
 
     // apply output gain
     if (gain!=0.0f) {
       for (FXint i=0;i<nsamples*af.channels;i++) {
-        pcm[i]*=gain;
+        output[i]*=gain;
         }
       }
-    // Adjust for beginning of stream
-    if (stream_position<stream_begin) {
-      FXlong offset = FXMIN(nsamples,stream_begin - stream_position);
-      GM_DEBUG_PRINT("[opus] stream offset start %ld. Skip %ld at %ld\n",stream_begin,offset,stream_position);
-      nsamples-=offset;
-      pcmi+=(offset*af.framesize());
-      stream_position+=offset;
-      }
 
     //GM_DEBUG_PRINT("[opus] decoded %d frames\n",nsamples);
     if (eos) {
@@ -182,6 +201,29 @@ FXbool OpusDecoderPlugin::process(Packet * packet) {
         }
       }
 
+    // Decoded in place
+    if (output!=pcm) {
+      if (nsamples>0) {
+        out->wroteFrames(nsamples);
+        stream_position+=nsamples;
+        }
+      if (out->availableFrames()==0) {
+        context->post_output_packet(out);
+        }
+      continue;
+      }
+
+    const FXuchar * pcmi = (const FXuchar*)pcm;
+
+    // Adjust for beginning of stream
+    if (stream_position<stream_begin) {
+      FXlong offset = FXMIN(nsamples,stream_begin - stream_position);
+      GM_DEBUG_PRINT("[opus] stream offset start %ld. Skip %ld at %ld\n",stream_begin,offset,stream_position);
+      nsamples-=offset;
+      pcmi+=(offset*af.framesize());
+      stream_position+=offset;
+      }
+
     while(nsamples>0) {
       /// Get new buffer
       if (out==nullptr) {
@@ -153,7 +153,7 @@ public:
     }
 
   static void enable(pa_io_event*event,pa_io_event_flags_t events) {
-    event->mode = fromPulse(events);
+    event->setMode(fromPulse(events));
     }
 
   static void set_destroy(pa_io_event *event, pa_io_event_destroy_cb_t cb){
@@ -20,6 +20,7 @@
 #include "ap_packet.h"
 #include "ap_vorbis.h"
 #include "ap_ogg_decoder.h"
+#include "ap_convert.h"
 
 #if defined(HAVE_VORBIS)
 #include <vorbis/codec.h>
@@ -185,6 +186,7 @@ FXbool VorbisDecoder::process(Packet * packet) {
 #if defined(HAVE_VORBIS)
   FXfloat ** pcm=nullptr;
   FXfloat * buf32=nullptr;
+  const InterleaveFloatFunc interleave = interleave_planar_float(info.channels);
 #elif defined(HAVE_TREMOR)
   FXint ** pcm=nullptr;
   FXshort * buf32=nullptr;
@@ -261,6 +263,12 @@ FXbool VorbisDecoder::process(Packet * packet) {
 #endif
         /// Copy Samples
         nsamples = FXMIN(ntotalsamples,navail);
+#if defined(HAVE_VORBIS)
+        if (interleave) {
+          interleave(pcm,sample,nsamples,buf32);
+          }
+        else {
+#endif
         for (p=0,s=sample;s<(nsamples+sample);s++){
           for (c=0;c<info.channels;c++,p++) {
 #if defined(HAVE_VORBIS)
@@ -272,6 +280,9 @@ FXbool VorbisDecoder::process(Packet * packet) {
 #endif
             }
           }
+#if defined(HAVE_VORBIS)
+          }
+#endif
 
         /// Update sample counts
         out->wroteFrames(nsamples);
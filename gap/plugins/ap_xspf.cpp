@@ -103,7 +103,7 @@ void XSPFParser::end(const FXchar*) {
 
 
 
-class XSPFReader : public TextReader {
+class XSPFReader : public ReaderPlugin {
 protected:
   FXStringList uri;
 public:
@@ -116,28 +116,43 @@ public:
   };
 
 
-XSPFReader::XSPFReader(InputContext*ctx) : TextReader(ctx) {
+XSPFReader::XSPFReader(InputContext*ctx) : ReaderPlugin(ctx) {
   }
 
 XSPFReader::~XSPFReader(){
   }
 
 FXbool XSPFReader::init(InputPlugin*plugin) {
-  TextReader::init(plugin);
+  ReaderPlugin::init(plugin);
   uri.clear();
   return true;
   }
 
+// Parse the playlist while reading it instead of buffering the whole document
 ReadStatus XSPFReader::process(Packet*packet) {
-  if (TextReader::process(packet)==ReadDone) {
-    FXString title;
-    ap_parse_xspf(textbuffer,uri,title);
-    if (uri.no())
-      return ReadRedirect;
-    else
-      return ReadDone;
+  XSPFParser xspf;
+  FXchar     buffer[4096];
+  FXival     nread;
+  FXbool     parsed;
+
+  packet->unref();
+
+  parsed = xspf.open();
+  while((nread=input->read(buffer,4096))>0) {
+    if (parsed && !xspf.write(buffer,nread))
+      parsed = false;
     }
-  return ReadError;
+
+  if (nread==-1)
+    return ReadError;
+
+  if (parsed && xspf.close())
+    uri=xspf.files;
+
+  if (uri.no())
+    return ReadRedirect;
+  else
+    return ReadDone;
   }
 
 ReaderPlugin * ap_xspf_reader(InputContext * ctx) {
@@ -26,6 +26,7 @@ set(SOURCES
     ap_player.cpp
     ap_reactor.cpp
     ap_reader_plugin.cpp
+    ap_resampler.cpp
     ap_signal.cpp
     ap_socket.cpp
     ap_thread.cpp
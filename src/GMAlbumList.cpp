@@ -28,7 +28,7 @@
 
 
 
-#define GET_ARTIST_STRING(x)  GMPlayerManager::instance()->getTrackDatabase()->getArtist(x)
+#define COMPARE_ARTIST(a,b)   GMPlayerManager::instance()->getTrackDatabase()->compareArtist(a,b)
 
 
 // return true if string starts with configured keyword
@@ -39,32 +39,6 @@ static inline FXbool begins_with_keyword(const FXString & t){
   return false;
   }
 
-// return true if string starts with configured keyword
-static inline FXbool begins_with_keyword_ptr(const FXString * t){
-  for (FXint i=0;i<GMPlayerManager::instance()->getPreferences().gui_sort_keywords.no();i++){
-    if (FXString::comparecase(*t,GMPlayerManager::instance()->getPreferences().gui_sort_keywords[i],GMPlayerManager::instance()->getPreferences().gui_sort_keywords[i].length())==0) return true;
-    }
-  return false;
-  }
-
-// compare two string taking into account the configured keywords it needs to ignore
-static inline FXint keywordcompare(const FXString *a,const FXString *b) {
-  FXint pa,pb;
-
-  if (a==b) return 0;
-
-  if (begins_with_keyword_ptr(a))
-    pa=FXMIN(a->length()-1,a->find(' ')+1);
-  else
-    pa=0;
-
-  if (begins_with_keyword_ptr(b))
-    pb=FXMIN(b->length()-1,b->find(' ')+1);
-  else
-    pb=0;
-  return FXString::comparecase(&((*a)[pa]),&((*b)[pb]));
-  }
-
 // compare two string taking into account the configured keywords it needs to ignore
 static inline FXint keywordcompare(const FXString & a,const FXString & b) {
   FXint pa,pb;
@@ -107,7 +81,7 @@ FXint GMAlbumListItem::album_list_sort_reverse(const GMAlbumListItem* pa,const G
 
 
 FXint GMAlbumListItem::album_browser_sort(const GMAlbumListItem* pa,const GMAlbumListItem* pb){
-  FXint x = keywordcompare(GET_ARTIST_STRING(pa->artist),GET_ARTIST_STRING(pb->artist));
+  FXint x = COMPARE_ARTIST(pa->artist,pb->artist);
   if (x!=0) return GMTrackView::reverse_artist ? -x : x;
   if (GMTrackView::album_by_year) {
     if (pa->year>pb->year) return 1;
@@ -117,7 +91,7 @@ FXint GMAlbumListItem::album_browser_sort(const GMAlbumListItem* pa,const GMAlbu
   }
 
 FXint GMAlbumListItem::album_browser_sort_reverse(const GMAlbumListItem* pa,const GMAlbumListItem* pb){
-  FXint x = keywordcompare(GET_ARTIST_STRING(pb->artist),GET_ARTIST_STRING(pa->artist));
+  FXint x = COMPARE_ARTIST(pb->artist,pa->artist);
   if (x!=0) return GMTrackView::reverse_artist ? -x : x;
   if (GMTrackView::album_by_year) {
     if (pa->year>pb->year) return -1;
@@ -43,6 +43,10 @@
 #define CLIENT_SECRET "09397d5d6a55858a6883735b7cb694f7"
 
 #define SCROBBLER_CACHE_FILE PATHSEPSTRING "scrobbler.cache"
+#define SCROBBLER_JOURNAL_FILE PATHSEPSTRING "scrobbler.journal"
+
+/// Maximum number of tracks the services accept in a single submission
+#define MAX_SUBMIT_TRACKS 50
 
 #define LASTFM_URL "http://ws.audioscrobbler.com:80/2.0/"
 #define LASTFM_OLD_URL "http://post.audioscrobbler.com:80"
@@ -108,16 +112,6 @@ void GMAudioScrobblerTrack::clear() {
   loveban=0;
   }
 
-void GMAudioScrobblerTrack::save(FXStream & store) const {
-  store << artist;
-  store << album;
-  store << title;
-  store << duration;
-  store << no;
-  store << timestamp;
-  store << loveban;
-  }
-
 void GMAudioScrobblerTrack::load(FXStream & store) {
   store >> artist;
   store >> album;
@@ -129,6 +123,192 @@ void GMAudioScrobblerTrack::load(FXStream & store) {
   }
 
 
+/**********************************************************************************************************/
+
+/*
+  Journal Format:
+
+    header: "GMSJ" version(1 byte)
+    record: type(1 byte) size(varint) payload(size bytes)
+
+    JOURNAL_TRACK: timestamp duration no loveban artist album title
+    JOURNAL_ACK:   count
+
+  Numbers are stored as unsigned LEB128 varints and strings as a varint
+  length followed by the utf8 bytes. A record cut short by a crash ends the
+  journal.
+*/
+
+static const FXchar  journal_magic[4] = {'G','M','S','J'};
+static const FXuchar journal_version  = 1;
+
+enum {
+  JOURNAL_TRACK = 'T',
+  JOURNAL_ACK   = 'A'
+  };
+
+/// Compact after this many acknowledged entries
+#define JOURNAL_COMPACT_ACK 256
+
+
+static void journal_record(FXString & record,FXuchar type,const FXString & payload) {
+  record.append((FXchar)type);
+  gm_varint_put(record,(FXulong)payload.length());
+  record.append(payload);
+  }
+
+static void journal_track(FXString & record,const GMAudioScrobblerTrack & track) {
+  FXString payload;
+  gm_varint_put(payload,(FXulong)track.timestamp);
+  gm_varint_put(payload,(FXulong)track.duration);
+  gm_varint_put(payload,(FXulong)(FXuint)track.no);
+  gm_varint_put(payload,(FXulong)(FXuint)track.loveban);
+  gm_varint_put(payload,track.artist);
+  gm_varint_put(payload,track.album);
+  gm_varint_put(payload,track.title);
+  journal_record(record,JOURNAL_TRACK,payload);
+  }
+
+
+GMAudioScrobblerJournal::GMAudioScrobblerJournal() {
+  }
+
+
+void GMAudioScrobblerJournal::load(GMAudioScrobblerTrackList & queue) {
+  FXString buffer;
+  FXulong  size,value;
+  FXint    start=queue.no();
+
+  filename = GMApp::getCacheDirectory() + SCROBBLER_JOURNAL_FILE;
+
+  FXFile input(filename,FXIO::Reading);
+  if (!input.isOpen())
+    return;
+
+  buffer.length((FXint)input.size());
+  if (input.readBlock(&buffer[0],buffer.length())!=buffer.length())
+    return;
+
+  const FXuchar * p   = (const FXuchar*)buffer.text();
+  const FXuchar * end = p + buffer.length();
+
+  if (buffer.length()<5 || memcmp(p,journal_magic,4)!=0 || p[4]!=journal_version) {
+    GM_DEBUG_PRINT("[scrobbler] ignoring unknown journal %s\n",filename.text());
+    return;
+    }
+
+  for (p+=5;p<end;) {
+    const FXuchar type = *p++;
+    if (!gm_varint_get(p,end,size) || size>(FXulong)(end-p))
+      break;
+
+    const FXuchar * record = p;
+    const FXuchar * record_end = p + size;
+    p = record_end;
+
+    if (type==JOURNAL_TRACK) {
+      GMAudioScrobblerTrack track;
+      if (!gm_varint_get(record,record_end,value)) break;
+      track.timestamp = (FXlong)value;
+      if (!gm_varint_get(record,record_end,value)) break;
+      track.duration = (FXuint)value;
+      if (!gm_varint_get(record,record_end,value)) break;
+      track.no = (FXint)value;
+      if (!gm_varint_get(record,record_end,value)) break;
+      track.loveban = (FXint)value;
+      if (!gm_varint_get(record,record_end,track.artist) ||
+          !gm_varint_get(record,record_end,track.album) ||
+          !gm_varint_get(record,record_end,track.title)) break;
+      queue.append(track);
+      }
+    else if (type==JOURNAL_ACK) {
+      if (!gm_varint_get(record,record_end,value)) break;
+      const FXint n = (FXint)FXMIN(value,(FXulong)(queue.no()-start));
+      queue.erase(start,n);
+      }
+    }
+  GM_DEBUG_PRINT("[scrobbler] %d tracks in journal\n",queue.no()-start);
+  }
+
+
+void GMAudioScrobblerJournal::compact(const GMAudioScrobblerTrackList & queue) {
+  FXString buffer(journal_magic,4);
+  buffer.append((FXchar)journal_version);
+  for (FXint i=0;i<queue.no();i++) {
+    journal_track(buffer,queue[i]);
+    }
+
+  close();
+
+  filename = GMApp::getCacheDirectory(true) + SCROBBLER_JOURNAL_FILE;
+
+  // Replace the journal in one step, so a crash leaves either version intact
+  FXFile output(filename+".part",FXIO::Writing);
+  if (output.isOpen()) {
+    if (output.writeBlock(buffer.text(),buffer.length())==buffer.length() && output.flush()) {
+      output.close();
+      FXFile::rename(filename+".part",filename);
+      }
+    else {
+      output.close();
+      FXFile::remove(filename+".part");
+      }
+    }
+
+  if (!file.open(filename,FXIO::WriteOnly|FXIO::Append))
+    GM_DEBUG_PRINT("[scrobbler] failed to open journal %s\n",filename.text());
+
+  nacked=0;
+  dirty=false;
+  }
+
+
+FXbool GMAudioScrobblerJournal::write(const FXString & record) {
+  if (file.isOpen() && file.writeBlock(record.text(),record.length())==record.length()) {
+    dirty=true;
+    return true;
+    }
+  return false;
+  }
+
+
+void GMAudioScrobblerJournal::append(const GMAudioScrobblerTrack & track) {
+  FXString record;
+  journal_track(record,track);
+  write(record);
+  }
+
+
+void GMAudioScrobblerJournal::acknowledge(FXint n,const GMAudioScrobblerTrackList & queue) {
+  nacked+=n;
+  if (queue.no()==0 || nacked>=JOURNAL_COMPACT_ACK) {
+    compact(queue);
+    }
+  else {
+    FXString payload,record;
+    gm_varint_put(payload,(FXulong)n);
+    journal_record(record,JOURNAL_ACK,payload);
+    write(record);
+    }
+  }
+
+
+void GMAudioScrobblerJournal::sync() {
+  if (dirty) {
+    file.flush();
+    dirty=false;
+    }
+  }
+
+
+void GMAudioScrobblerJournal::close() {
+  if (file.isOpen()) {
+    sync();
+    file.close();
+    }
+  }
+
+
 class ServiceResponse : public XmlParser {
 protected:
   FXbool       status;
@@ -478,6 +658,7 @@ void GMAudioScrobbler::submit(FXlong timestamp,GMTrack & info){
     }
   else {
     submitqueue.append(GMAudioScrobblerTrack(timestamp,info,0));
+    journal.append(submitqueue[submitqueue.no()-1]);
     mutex_data.unlock();
     runTask();
     }
@@ -584,6 +765,8 @@ FXbool GMAudioScrobbler::isEnabled(){
 void GMAudioScrobbler::load_queue(){
   FXTRACE(60,"GMAudioScrobbler::load_queue\n");
   FXuint version,size;
+
+  // Queue saved by older versions
   FXString filename = GMApp::getCacheDirectory() + SCROBBLER_CACHE_FILE;
   FXFileStream store;
   if (store.open(filename,FXStreamLoad)){
@@ -597,28 +780,24 @@ void GMAudioScrobbler::load_queue(){
       }
     store.close();
     }
+
+  journal.load(submitqueue);
+  journal.compact(submitqueue);
+
   FXFile::remove(filename);
   }
 
 
 void GMAudioScrobbler::save_queue(){
   FXTRACE(60,"GMAudioScrobbler::save_queue => %ld entries\n",submitqueue.no());
-  FXuint version=20080501,size;
-  if (submitqueue.no()) {
-    FXString filename = GMApp::getCacheDirectory(true) + SCROBBLER_CACHE_FILE;
-    FXFileStream store;
-    if (store.open(filename,FXStreamSave)){
-      store << version;
-      size = submitqueue.no();
-      store << size;
-      for (FXint i=0;i<submitqueue.no();i++)
-        submitqueue[i].save(store);
-      }
-    }
-  else {
-    FXString filename = GMApp::getCacheDirectory() + SCROBBLER_CACHE_FILE;
-    FXFile::remove(filename);
-    }
+  journal.compact(submitqueue);
+  journal.close();
+  }
+
+
+void GMAudioScrobbler::sync_queue(){
+  FXScopedMutex lock(mutex_data);
+  journal.sync();
   }
 
 FXbool GMAudioScrobbler::waitForTask() {
@@ -737,8 +916,10 @@ FXint GMAudioScrobbler::run() {
         case TASK_SHUTDOWN     : goto done;      break;
         }
       }
+    sync_queue();
     }	while(waitForTask());
 done:
+  sync_queue();
 
   mutex_data.lock();
   flags&=~FLAG_SHUTDOWN;
@@ -767,6 +948,7 @@ void GMAudioScrobbler::reset_timeout(){
 
 void GMAudioScrobbler::set_submit_failed() {
   FXTRACE(60,"GMAudioScrobbler::set_failed\n");
+  set_timeout();
   nfailed++;
   if (nfailed==3) {
     session.clear();
@@ -1037,7 +1219,7 @@ void GMAudioScrobbler::create_submit_request(FXString & request) {
   FXScopedMutex lock(mutex_data);
   FXTRACE(60,"GMAudioScrobbler::create_submit_request\n");
   FXint i,s;
-  FXint ntracks = FXMIN(50,submitqueue.no());
+  FXint ntracks = FXMIN(MAX_SUBMIT_TRACKS,submitqueue.no());
   FXString signature;
 
   if (mode==SERVICE_LASTFM) {
@@ -1230,7 +1412,9 @@ void GMAudioScrobbler::process_submit_response(const FXString & response){
     else {
       FXTRACE(60,"last.fm service submit success\n");
       submitqueue.erase(0,nsubmitted);
+      journal.acknowledge(nsubmitted,submitqueue);
       nsubmitted=0;
+      reset_timeout();
       }
     }
   else {
@@ -1243,8 +1427,10 @@ void GMAudioScrobbler::process_submit_response(const FXString & response){
         }
       else {
         submitqueue.erase(0,nsubmitted);
+        journal.acknowledge(nsubmitted,submitqueue);
         }
       nsubmitted=0;
+      reset_timeout();
       }
     else if (FXString::compare(code,"BADSESSION",10)==0) {
       session.clear();
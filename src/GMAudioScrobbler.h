@@ -31,7 +31,6 @@ struct GMAudioScrobblerTrack {
   GMAudioScrobblerTrack(FXlong time,GMTrack & t,FXint lb) : artist(t.artist),album(t.album),title(t.title),duration(t.time),no(t.no),timestamp(time)/* LastFM */,loveban(lb)/* LastFM End */{}
 
   void load(FXStream & store);
-  void save(FXStream & store) const;
 
   FXuint getTimeStamp() const { return (FXuint)(timestamp/1000000000); }
 
@@ -40,6 +39,40 @@ struct GMAudioScrobblerTrack {
 
 typedef FXArray<GMAudioScrobblerTrack> GMAudioScrobblerTrackList;
 
+
+/*
+  Append-only log of pending scrobbles. Submitted tracks are recorded as
+  acknowledgements and dropped when the log is compacted.
+*/
+class GMAudioScrobblerJournal {
+protected:
+  FXFile   file;
+  FXString filename;
+  FXint    nacked = 0;      // acknowledged entries since last compaction
+  FXbool   dirty  = false;  // appended since last sync
+protected:
+  FXbool write(const FXString & record);
+public:
+  GMAudioScrobblerJournal();
+
+  /// Append all entries in the journal to queue
+  void load(GMAudioScrobblerTrackList & queue);
+
+  /// Rewrite journal with just the queue and open it for appending
+  void compact(const GMAudioScrobblerTrackList & queue);
+
+  /// Record new track
+  void append(const GMAudioScrobblerTrack & track);
+
+  /// Record the first n tracks as submitted.
+  void acknowledge(FXint n,const GMAudioScrobblerTrackList & queue);
+
+  /// Flush appended records to disk
+  void sync();
+
+  void close();
+  };
+
 enum {
   SERVICE_LASTFM,
   SERVICE_LIBREFM,
@@ -102,6 +135,7 @@ protected:
 protected:
   GMAudioScrobblerTrack     nowplayingtrack;
   GMAudioScrobblerTrackList submitqueue;
+  GMAudioScrobblerJournal   journal;
   FXint nsubmitted;
   FXint nfailed;
 protected:
@@ -125,6 +159,7 @@ protected:
   void set_submit_failed();
   void load_queue();
   void save_queue();
+  void sync_queue();
   FXbool can_submit();
 public:
   GMAudioScrobbler(FXObject* tgt,FXSelector msg);
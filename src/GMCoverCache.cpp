@@ -213,6 +213,44 @@ FXbool GMCoverCache::contains(FXint id) {
   return (info.map.at(id)>0);
   }
 
+GMCover * GMCoverCache::getCover(FXint id) {
+  FXint i = info.map.at(id) - 1;
+  if (i>=0) {
+#if FOXVERSION >= FXVERSION(1, 7, 82)
+    const FXuchar * ptr = (const FXuchar*)data.data();
+#else
+    const FXuchar * ptr = (const FXuchar*)data.base();
+#endif
+    if (ptr==nullptr)
+      return nullptr;
+
+    ptr+=info.index[i].position;
+
+    // Covers can only load jpeg, png, bmp and gif, so convert webp to png
+    if (info.format==COVERCACHE_WEBP) {
+      FXColor * pixels=nullptr;
+      FXint ww,hh;
+      FXMemoryStream load(FXStreamLoad,(FXuchar*)ptr,info.index[i].length);
+      if (!fxloadWEBP(load,pixels,ww,hh))
+        return nullptr;
+
+      FXMemoryStream store(FXStreamSave,nullptr);
+      FXbool ok = fxsavePNG(store,pixels,ww,hh);
+      freeElms(pixels);
+      if (!ok)
+        return nullptr;
+
+      FXuchar * png  = nullptr;
+      FXuval    size = 0;
+      FXuint    len  = (FXuint)store.position();
+      store.takeBuffer(png,size);
+      return new GMCover(png,len,GMCover::FrontCover,FXString::null,true);
+      }
+    return new GMCover(ptr,info.index[i].length,GMCover::FrontCover);
+    }
+  return nullptr;
+  }
+
 FXbool GMCoverCache::render(FXint id,FXImage * image) {
   FXColor * pixels=nullptr;
   FXbool result;
@@ -99,6 +99,9 @@ public:
   // Check if cover is contained in cache
   FXbool contains(FXint id);
 
+  // Return a copy of the cached cover with id
+  GMCover * getCover(FXint id);
+
   // Load cache from file
   FXbool load();
 
@@ -20,12 +20,163 @@
 #include "gmutils.h"
 #include "GMTrack.h"
 #include "GMCover.h"
+#include "GMCoverCache.h"
 #include "GMCoverManager.h"
 
-GMCoverManager::GMCoverManager() : cover(nullptr){
+// Maximum number of covers loaded ahead of time
+static const FXint max_prefetched = 2;
+
+
+struct GMCoverResult {
+  FXString  filename;          // file the cover was requested for
+  FXString  source;            // file or path the cover was loaded from
+  GMCover * cover  = nullptr;  // the cover
+  FXArray<FXint>    sizes;     // sizes the cover was decoded at
+  FXArray<FXImage*> images;    // decoded and scaled cover for each size
+
+  GMCoverResult(const FXString & f) : filename(f) {}
+  ~GMCoverResult() {
+    for (FXint i=0;i<images.no();i++) delete images[i];
+    delete cover;
+    }
+  };
+
+
+/*
+  GMCoverThread: looks up covers from tags or the directory, so slow
+  storage doesn't block the user interface. The cover is also decoded and
+  scaled for each size the consumers asked for. The images are not created
+  yet, that's left to the main thread. Results are kept in a list
+  and the manager is notified through the message channel. Results never
+  collected are deleted with the thread.
+*/
+class GMCoverThread : public FXThread {
+protected:
+  FXMutex           mutex;
+  FXCondition       condition;
+  FXString          request;            // current track
+  FXStringList      pending;            // upcoming tracks
+  GMCoverResultList results;            // loaded, not yet collected by the manager
+  FXArray<FXint>    sizes;              // image sizes to decode
+  FXbool            running = true;
+  GMCoverManager  * manager;
+  FXMessageChannel* channel;
+public:
+  GMCoverThread(GMCoverManager * m,FXMessageChannel * c) : manager(m), channel(c) {}
+
+  ~GMCoverThread() {
+    for (FXint i=0;i<results.no();i++) delete results[i];
+    }
+
+  void setSizes(const FXArray<FXint> & s) {
+    FXMutexLock lock(mutex);
+    sizes=s;
+    }
+
+  void collect(GMCoverResultList & list) {
+    FXMutexLock lock(mutex);
+    list.adopt(results);
+    }
+
+  void load(const FXString & filename) {
+    FXMutexLock lock(mutex);
+    for (FXint i=0;i<pending.no();i++) {
+      if (pending[i]==filename) pending.erase(i--);
+      }
+    request=filename;
+    condition.signal();
+    }
+
+  void prefetch(const FXString & filename) {
+    FXMutexLock lock(mutex);
+    for (FXint i=0;i<pending.no();i++) {
+      if (pending[i]==filename) return;
+      }
+    if (pending.no()==max_prefetched) pending.erase(0);
+    pending.append(filename);
+    condition.signal();
+    }
+
+  void shutdown() {
+    FXMutexLock lock(mutex);
+    running=false;
+    condition.signal();
+    }
+
+  FXint run() {
+    FXString       filename;
+    FXArray<FXint> decode;
+    for (;;) {
+      mutex.lock();
+      while(running && request.empty() && pending.no()==0)
+        condition.wait(mutex);
+      if (!running) {
+        mutex.unlock();
+        break;
+        }
+      if (!request.empty()) {
+        filename=request;
+        request.clear();
+        }
+      else {
+        filename=pending[0];
+        pending.erase(0);
+        }
+      decode=sizes;
+      mutex.unlock();
+
+      GMCoverResult * result = new GMCoverResult(filename);
+      result->cover = GMCover::fromTag(filename);
+      if (result->cover==nullptr) {
+        result->cover = GMCover::fromPath(FXPath::directory(filename));
+        if (result->cover) result->source=FXPath::directory(filename);
+        }
+      else {
+        result->source=filename;
+        }
+
+      if (result->cover) {
+        result->sizes=decode;
+        for (FXint i=0;i<decode.no();i++)
+          result->images.append(GMCover::copyToImage(result->cover,decode[i]));
+        }
+
+      mutex.lock();
+      results.append(result);
+      mutex.unlock();
+      channel->message(manager,FXSEL(SEL_COMMAND,GMCoverManager::ID_COVER_LOADED));
+      }
+    return 0;
+    }
+  };
+
+
+FXDEFMAP(GMCoverManager) GMCoverManagerMap[]={
+  FXMAPFUNC(SEL_COMMAND,GMCoverManager::ID_COVER_LOADED,GMCoverManager::onCoverLoaded),
+  };
+
+FXIMPLEMENT(GMCoverManager,FXObject,GMCoverManagerMap,ARRAYNUMBER(GMCoverManagerMap));
+
+
+GMCoverManager::GMCoverManager() {
+  }
+
+GMCoverManager::GMCoverManager(FXApp * app,FXObject * tgt,FXSelector sel) : target(tgt), message(sel) {
+  channel = new FXMessageChannel(app);
+  thread  = new GMCoverThread(this,channel);
+  thread->start();
   }
 
 GMCoverManager::~GMCoverManager(){
+  if (thread) {
+    thread->shutdown();
+    thread->join();
+    delete thread;
+    }
+  delete channel;
+  for (FXint i=0;i<prefetched.no();i++) {
+    delete prefetched[i];
+    }
   clear();
   }
 
@@ -35,19 +186,87 @@ void GMCoverManager::clear() {
     cover = nullptr;
     }
 
+  clear_images();
+
   if (!share.empty()){
     FXFile::remove(share);
     share.clear();
     }
 
   source.clear();
+  request.clear();
   }
 
-FXbool GMCoverManager::load(const FXString & filename) {
+
+void GMCoverManager::clear_images() {
+  for (FXint i=0;i<images.no();i++) {
+    delete images[i];
+    }
+  images.clear();
+  imagesizes.clear();
+  }
+
+
+FXImage * GMCoverManager::getImage(FXint size) {
+  FXint i;
+
+  // Have covers decoded at this size from now on
+  for (i=0;i<sizes.no();i++) {
+    if (sizes[i]==size) break;
+    }
+  if (i==sizes.no()) {
+    sizes.append(size);
+    if (thread) thread->setSizes(sizes);
+    }
+
+  // Hand out the image decoded by the loader
+  for (i=0;i<imagesizes.no();i++) {
+    if (imagesizes[i]==size && images[i]) {
+      FXImage * image = images[i];
+      images[i] = nullptr;
+      return image;
+      }
+    }
+  return GMCover::copyToImage(cover,size);
+  }
+
+
+void GMCoverManager::save_share() {
+  if (!share.empty()) {
+    FXFile::remove(share);
+    share.clear();
+    }
+  if (cover) {
+    share = "/dev/shm/gogglesmm/cover" + cover->fileExtension();
+    if (!cover->save(share))
+      share.clear();
+    }
+  }
+
+
+void GMCoverManager::adopt(GMCoverResult * result) {
+
+  // Replaces any cover shown while loading, even if nothing was found
+  delete cover;
+  cover = result->cover;
+  result->cover = nullptr;
+  source = result->source;
+
+  clear_images();
+  images.adopt(result->images);
+  imagesizes.adopt(result->sizes);
+
+  save_share();
+  request.clear();
+  delete result;
+  }
+
+
+FXbool GMCoverManager::load(const FXString & filename,GMCoverCache * cache,FXint id) {
   FXString path = FXPath::directory(filename);
 
   // Reuse existing
-  if (source==filename || source==path)
+  if (source==filename || source==path || request==filename)
     return false;
 
   // Clear existing
@@ -55,22 +274,55 @@ FXbool GMCoverManager::load(const FXString & filename) {
 
   if (gm_is_local_file(filename)) {
 
-    // Load
-    cover = GMCover::fromTag(filename);
-    if (cover==nullptr) {
-      cover = GMCover::fromPath(path);
-      if (cover) source=path;
+    // Loaded ahead of time
+    for (FXint i=0;i<prefetched.no();i++) {
+      if (prefetched[i]->filename==filename) {
+        GMCoverResult * result = prefetched[i];
+        prefetched.erase(i);
+        adopt(result);
+        return true;
+        }
       }
-    else {
-      source=filename;
+
+    // Show the cached album cover until the real one is loaded
+    if (cache && id>=0) {
+      cover = cache->getCover(id);
+      save_share();
       }
 
-    if (cover) {
-      share = "/dev/shm/gogglesmm/cover" + cover->fileExtension();
-      if (!cover->save(share))
-        share.clear();
+    request = filename;
+    thread->load(filename);
+    }
+  return true;
+  }
+
+
+void GMCoverManager::prefetch(const FXString & filename) {
+  if (gm_is_local_file(filename) && filename!=request && filename!=source && FXPath::directory(filename)!=source) {
+    for (FXint i=0;i<prefetched.no();i++) {
+      if (prefetched[i]->filename==filename) return;
       }
+    thread->prefetch(filename);
     }
+  }
 
-  return true;
+
+long GMCoverManager::onCoverLoaded(FXObject*,FXSelector,void*) {
+  GMCoverResultList results;
+  thread->collect(results);
+  for (FXint i=0;i<results.no();i++) {
+    GMCoverResult * result = results[i];
+    if (!request.empty() && result->filename==request) {
+      adopt(result);
+      if (target) target->handle(this,FXSEL(SEL_COMMAND,message),nullptr);
+      }
+    else {
+      if (prefetched.no()==max_prefetched) {
+        delete prefetched[0];
+        prefetched.erase(0);
+        }
+      prefetched.append(result);
+      }
+    }
+  return 1;
   }
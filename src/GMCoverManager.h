@@ -19,19 +19,53 @@
 #ifndef GMCOVER_MANAGER_H
 #define GMCOVER_MANAGER_H
 
-class GMCoverManager {
+class GMCoverCache;
+class GMCoverThread;
+struct GMCoverResult;
+
+typedef FXArray<GMCoverResult*> GMCoverResultList;
+
+class GMCoverManager : public FXObject {
+FXDECLARE(GMCoverManager)
+protected:
+  GMCover*          cover      = nullptr; // current cover
+  FXString          source;               // file or path the current cover was loaded from
+  FXString          request;              // file the current cover is being loaded for
+  FXString          share;                // shared copy of the current cover
+  GMCoverResultList prefetched;           // covers loaded ahead of time
+  GMCoverThread*    thread     = nullptr; // background loader
+  FXMessageChannel* channel    = nullptr;
+  FXArray<FXint>    sizes;                // image sizes requested by consumers
+  FXArray<FXint>    imagesizes;           // sizes of images
+  FXArray<FXImage*> images;               // current cover decoded by the loader
+  FXObject*         target     = nullptr;
+  FXSelector        message    = 0;
 protected:
-  GMCover* cover;
-  FXString source;
-  FXString share;
-public:
   GMCoverManager();
+  void adopt(GMCoverResult*);
+  void clear_images();
+  void save_share();
+private:
+  GMCoverManager(const GMCoverManager&);
+  GMCoverManager& operator=(const GMCoverManager&);
+public:
+  enum {
+    ID_COVER_LOADED = 1,
+    ID_LAST
+    };
+public:
+  long onCoverLoaded(FXObject*,FXSelector,void*);
+public:
+  GMCoverManager(FXApp*,FXObject*tgt=nullptr,FXSelector sel=0);
 
   // Clear
   void clear();
 
-  // Load Cover
-  FXbool load(const FXString & filename);
+  // Load Cover in the background. A cached cover with id is shown in the mean time.
+  FXbool load(const FXString & filename,GMCoverCache * cache=nullptr,FXint id=-1);
+
+  // Load Cover ahead of time
+  void prefetch(const FXString & filename);
 
   // Get the share filename
   FXString getShareFilename() const { return share; }
@@ -39,6 +73,9 @@ public:
   // Get the cover
   GMCover* getCover() const { return cover; }
 
+  // Get the cover as image of given size. Decoded in the background where possible. Caller owns the image.
+  FXImage* getImage(FXint size);
+
   ~GMCoverManager();
   };
 
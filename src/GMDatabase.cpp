@@ -22,6 +22,10 @@
 /// 100ms
 #define DATABASE_SLEEP 100000000
 
+/// Tasks commit at least every 1000 steps or 2s, so readers see progress
+#define TASK_BATCH_SIZE 1000
+#define TASK_BATCH_TIME 2000000000
+
 GMQuery::GMQuery() : statement(nullptr) {
   }
 
@@ -169,6 +173,11 @@ void GMQuery::set_null(FXint p,FXint v){
   }
 
 
+void GMQuery::set_null(FXint p){
+  if (__unlikely(sqlite3_bind_null(statement,(p+1))!=SQLITE_OK))
+    fatal();
+  }
+
 void GMQuery::set(FXint p,FXuint v){
   if (__unlikely(sqlite3_bind_int(statement,(p+1),(FXint)v)!=SQLITE_OK))
     fatal();
@@ -238,6 +247,11 @@ void GMQuery::get_null(FXint p,FXString & v) {
     v.assign("\0",1);
   }
 
+FXbool GMQuery::is_null(FXint p){
+  FXASSERT(sqlite3_data_count(statement));
+  return sqlite3_column_type(statement,p)==SQLITE_NULL;
+  }
+
 const FXchar * GMQuery::get(FXint p){
   FXASSERT(sqlite3_data_count(statement));
   return (const FXchar *) sqlite3_column_text(statement,p);
@@ -276,7 +290,9 @@ GMDatabase::~GMDatabase(){
   }
 
 void GMDatabase::close(){
+  sqlite3_close(rdb);
   sqlite3_close(db);
+  rdb=nullptr;
   db=nullptr;
   }
 
@@ -309,10 +325,19 @@ void GMDatabase::fatal(const FXchar * query) const {
 
 sqlite3_stmt * GMDatabase::compile(const FXchar * query){
   FXASSERT(db);
+  return compile(db,query);
+  }
+
+sqlite3_stmt * GMDatabase::compileRead(const FXchar * query){
+  FXASSERT(db);
+  return compile(rdb ? rdb : db,query);
+  }
+
+sqlite3_stmt * GMDatabase::compile(sqlite3 * handle,const FXchar * query){
   FXint result;
   sqlite3_stmt * statement=nullptr;
   do {
-    result = sqlite3_prepare_v2(db,query,-1,&statement,nullptr);
+    result = sqlite3_prepare_v2(handle,query,-1,&statement,nullptr);
     if (__likely(result==SQLITE_OK))
       return statement;
     else if (result==SQLITE_BUSY)
@@ -331,17 +356,159 @@ FXbool GMDatabase::open(const FXString & filename){
     db=nullptr;
     return false;
     }
-  init_regex();
+  init_regex(db);
+  return true;
+  }
+
+
+/*
+  In WAL mode readers never wait for the writer. Browsing through the read
+  connection therefore doesn't compete with running tasks, at the cost of
+  only seeing what they committed so far.
+*/
+FXbool GMDatabase::openReader() {
+  FXString mode;
+  FXASSERT(db);
+
+  if (rdb)
+    return true;
+
+  // Not available for in memory databases or some network filesystems
+  GMQuery journal(this,"PRAGMA journal_mode=WAL;");
+  journal.execute(mode);
+  if (mode!="wal") {
+    GM_DEBUG_PRINT("[sqlite] write-ahead logging not available (%s)\n",mode.text());
+    return false;
+    }
+
+  // Durable enough in WAL mode and avoids a sync for every commit
+  execute("PRAGMA synchronous=NORMAL;");
+
+  const FXchar * filename = sqlite3_db_filename(db,"main");
+  if (filename==nullptr || filename[0]=='\0')
+    return false;
+
+  if (sqlite3_open_v2(filename,&rdb,SQLITE_OPEN_READONLY|SQLITE_OPEN_FULLMUTEX,nullptr)!=SQLITE_OK){
+    sqlite3_close(rdb);
+    rdb=nullptr;
+    return false;
+    }
+  init_regex(rdb);
+  GM_DEBUG_PRINT("[sqlite] opened read connection\n");
   return true;
   }
 
 
+/*
+  Compiled regular expression. Patterns that are just a literal prefix are
+  matched without FXRex.
+*/
+struct GMRegex {
+  FXString pattern;         // source pattern
+  FXString prefix;          // literal prefix
+  FXRex    rex;             // compiled pattern
+  FXbool   literal = false; // pattern is only the literal prefix
+  FXbool   valid   = false; // pattern compiled successfully
+
+  GMRegex(const FXString & p) : pattern(p) {
+    literal = GMDatabase::regex_prefix(pattern,prefix);
+    if (!literal) valid = (rex.parse(pattern)==FXRex::ErrOK);
+    }
+
+  FXbool match(const FXchar * value) const {
+    if (strncmp(value,prefix.text(),prefix.length())!=0)
+      return false;
+    if (literal)
+      return true;
+    return valid && rex.amatch(value,strlen(value));
+    }
+  };
+
+
+// Recently compiled patterns, shared by all statements
+static const FXint       regex_cache_size = 16;
+static FXArray<GMRegex*> regex_cache;
+static FXMutex           regex_mutex;
+
+
+static void regex_free(void * ptr) {
+  delete static_cast<GMRegex*>(ptr);
+  }
+
+
+static GMRegex * regex_compile(const FXString & pattern) {
+  FXMutexLock lock(regex_mutex);
+  for (FXint i=0;i<regex_cache.no();i++) {
+    if (regex_cache[i]->pattern==pattern) {
+      GMRegex * regex = regex_cache[i];
+      regex_cache.erase(i);
+      regex_cache.insert(0,regex);
+      return new GMRegex(*regex);
+      }
+    }
+  if (regex_cache.no()==regex_cache_size) {
+    delete regex_cache[regex_cache_size-1];
+    regex_cache.erase(regex_cache_size-1);
+    }
+  regex_cache.insert(0,new GMRegex(pattern));
+  return new GMRegex(*regex_cache[0]);
+  }
+
+
+FXbool GMDatabase::regex_prefix(const FXString & pattern,FXString & prefix) {
+  FXint i,e;
+  prefix.clear();
+
+  // Alternatives don't share a prefix
+  if (pattern.empty() || pattern.find('|')>=0)
+    return false;
+
+  // Patterns are always anchored at the start
+  i = (pattern[0]=='^') ? 1 : 0;
+
+  while(i<pattern.length()) {
+    if (pattern[i]=='\\') {
+      // Only escaped metacharacters are literals; others like \< or \d have a meaning
+      if (i+1==pattern.length() || strchr("^$.[]()*+?{}|\\",pattern[i+1])==nullptr) break;
+      e=i+2;
+      }
+    else if (strchr("^$.[]()*+?{}",pattern[i])) {
+      break;
+      }
+    else {
+      for (e=i+1;e<pattern.length() && ((FXuchar)pattern[e]&0xC0)==0x80;e++){}
+      }
+
+    // Quantifier applies to this character
+    if (e<pattern.length() && strchr("*+?{",pattern[e]))
+      break;
+
+    if (pattern[i]=='\\')
+      prefix.append(pattern[i+1]);
+    else
+      prefix.append(&pattern[i],e-i);
+    i=e;
+    }
+  return (i==pattern.length());
+  }
+
+
 void GMDatabase::perform_regex_match(sqlite3_context *context, int argc, sqlite3_value **argv){
   if (argc==2) {
-    FXRex reg;
-    const FXchar * pattern = (const FXchar*)sqlite3_value_text(argv[0]);
-    const FXchar * value   = (const FXchar*)sqlite3_value_text(argv[1]);
-    if (value && reg.parse(pattern)==0  && reg.amatch(value,strlen(value))) {
+    const FXchar * value = (const FXchar*)sqlite3_value_text(argv[1]);
+    GMRegex * regex = static_cast<GMRegex*>(sqlite3_get_auxdata(context,0));
+    if (regex==nullptr) {
+      const FXchar * pattern = (const FXchar*)sqlite3_value_text(argv[0]);
+      if (pattern==nullptr) {
+        sqlite3_result_int(context,0);
+        return;
+        }
+      regex = regex_compile(pattern);
+      sqlite3_result_int(context,(value && regex->match(value)) ? 1 : 0);
+      sqlite3_set_auxdata(context,0,regex,regex_free);
+      return;
+      }
+    if (value && regex->match(value)) {
       sqlite3_result_int(context,1);
       return;
       }
@@ -350,13 +517,13 @@ void GMDatabase::perform_regex_match(sqlite3_context *context, int argc, sqlite3
   }
 
 
-void GMDatabase::init_regex() {
+void GMDatabase::init_regex(sqlite3 * handle) {
 #ifdef SQLITE_DETERMINISTIC // SQLITE 3.8.3
-  if (sqlite3_create_function(db,"REGEXP",2,SQLITE_UTF8|SQLITE_DETERMINISTIC,this,perform_regex_match,nullptr,nullptr)!=SQLITE_OK){
+  if (sqlite3_create_function(handle,"REGEXP",2,SQLITE_UTF8|SQLITE_DETERMINISTIC,this,perform_regex_match,nullptr,nullptr)!=SQLITE_OK){
     fxwarning("failed to register regular expression callback\n");
     }
 #else
-  if (sqlite3_create_function(db,"REGEXP",2,SQLITE_UTF8,this,perform_regex_match,nullptr,nullptr)!=SQLITE_OK){
+  if (sqlite3_create_function(handle,"REGEXP",2,SQLITE_UTF8,this,perform_regex_match,nullptr,nullptr)!=SQLITE_OK){
     fxwarning("failed to register regular expression callback\n");
     }
 #endif
@@ -471,6 +638,14 @@ FXint GMDatabase::getVersion(){
   return v;
   }
 
+FXbool GMDatabase::busy() {
+  if (mutex.trylock()) {
+    mutex.unlock();
+    return false;
+    }
+  return true;
+  }
+
 FXbool GMDatabase::threadsafe() {
   if (sqlite3_threadsafe())
     return true;
@@ -483,6 +658,28 @@ const FXchar * GMDatabase::version() {
 
 
 
+GMScopedTransaction::GMScopedTransaction(GMDatabase * database) : db(database) {
+  db->execute("BEGIN");
+  }
+
+
+GMScopedTransaction::~GMScopedTransaction() {
+  if (committed == false) {
+    try {
+      db->execute("ROLLBACK");
+      }
+    catch(GMDatabaseException&) {
+      }
+    }
+  }
+
+
+void GMScopedTransaction::commit() {
+  db->execute("COMMIT");
+  committed = true;
+  }
+
+
 GMLockTransaction::GMLockTransaction(GMDatabase * database) : db(database) /*, state(std::uncaught_exceptions())*/ {
   lock();
   try {
@@ -548,13 +745,21 @@ void GMLockTransaction::unlock() {
 
 GMTaskTransaction::GMTaskTransaction(GMDatabase * database) : db(database) {
   lock();
+  begin();
+  }
+
+
+void GMTaskTransaction::begin() {
   try {
+    committed=false;
     db->execute("BEGIN IMMEDIATE");
     }
   catch(GMDatabaseException&) {
     unlock();
     throw;
     }
+  count=0;
+  started=FXThread::time();
   }
 
 
@@ -592,14 +797,29 @@ void GMTaskTransaction::pause() {
     throw;
     }
   db->condition.wait(db->mutex);
+  begin();
+  }
+
+
+FXbool GMTaskTransaction::due() {
+  return db->interrupt || ++count>=TASK_BATCH_SIZE || (FXThread::time()-started)>=TASK_BATCH_TIME;
+  }
+
+
+void GMTaskTransaction::checkpoint() {
+  if (db->interrupt) {
+    pause();
+    return;
+    }
   try {
-    committed=false;
-    db->execute("BEGIN IMMEDIATE");
+    db->execute("COMMIT");
+    committed=true;
     }
   catch(GMDatabaseException&) {
     unlock();
     throw;
     }
+  begin();
   }
 
 
@@ -53,6 +53,7 @@ public:
 public: /// Parameter / Column retrieval
   void set(FXint p,FXint v);
   void set_null(FXint p,FXint v);
+  void set_null(FXint p);
   void set(FXint p,FXuint v);
   void set(FXint p,FXlong v);
   void set(FXint p,FXfloat v);
@@ -69,6 +70,7 @@ public: /// Parameter / Column retrieval
   void get(FXint p,FXString&);
   void get_null(FXint p,FXString&);
   const FXchar * get(FXint p);
+  FXbool is_null(FXint p);
 public:
   /// Reset query for another exection
   void reset();
@@ -106,15 +108,20 @@ friend class GMLockTransaction;
 friend class GMTaskTransaction;
 private:
   sqlite3 * db;
+  sqlite3 * rdb = nullptr;  // read only connection for the user interface
 private:
   static FXMutex     mutex;
   static FXCondition condition;
 public:
   static void perform_regex_match(sqlite3_context *,int,sqlite3_value**);
+
+  /// Extract the literal prefix of a regular expression. Returns true if the pattern is only the prefix.
+  static FXbool regex_prefix(const FXString & pattern,FXString & prefix);
 public:
   static volatile FXbool interrupt;
 private:
   void fatal(const FXchar * q=nullptr) const;
+  sqlite3_stmt * compile(sqlite3 * handle,const FXchar * statement);
 protected:
   GMDatabase(const GMDatabase&);
   GMDatabase& operator=(const GMDatabase&);
@@ -131,12 +138,19 @@ public:
   void reset();
 
   /// Initialize Regular Expressions
-  void init_regex();
+  void init_regex(sqlite3 * handle);
+
+  /// Switch to write-ahead logging and open a separate read connection
+  FXbool openReader();
 
   /// Compile Query
   sqlite3_stmt * compile(const FXchar * statement);
   sqlite3_stmt * compile(const FXString & statement) { return compile(statement.text()); }
 
+  /// Compile Query on the read connection. Only sees committed data and no temporary tables.
+  sqlite3_stmt * compileRead(const FXchar * statement);
+  sqlite3_stmt * compileRead(const FXString & statement) { return compileRead(statement.text()); }
+
   /// Run
   void execute(const FXchar*);
   void execute(const FXString &);
@@ -168,6 +182,9 @@ public:
   // Check if table has column
   FXbool hasColumn(const FXchar * table,const FXchar * column);
 
+  /// Check if the database is currently held by a task
+  static FXbool busy();
+
   static FXbool threadsafe();
   static const FXchar * version();
 
@@ -176,6 +193,20 @@ public:
   };
 
 
+/// Plain transaction on a private connection; rolled back unless committed
+class GMScopedTransaction {
+protected:
+  GMDatabase * db = nullptr;
+  FXbool committed = false;
+public:
+  GMScopedTransaction(GMDatabase * database);
+
+  void commit();
+
+  ~GMScopedTransaction();
+  };
+
+
 class GMLockTransaction {
 protected:
   GMDatabase * db = nullptr;
@@ -198,14 +229,24 @@ protected:
   GMDatabase * db = nullptr;
   FXbool committed = false;
   FXbool locked = false;
+  FXint  count = 0;         // steps in current batch
+  FXTime started = 0;       // start of current batch
 protected:
   void lock();
   void unlock();
+  void begin();
 public:
   GMTaskTransaction(GMDatabase * database);
 
+  /// Commit and wait until the user interface is done with the database
   void pause();
 
+  /// Count a step and return true if the current batch is big or old enough, or the user interface waits
+  FXbool due();
+
+  /// Commit current batch, pause if requested and start the next one
+  void checkpoint();
+
   void commit();
 
   ~GMTaskTransaction();
@@ -47,6 +47,7 @@
 #include "GMAudioPlayer.h"
 #include "GMTrackEditor.h"
 #include "GMScanner.h"
+#include "GMLibrarySnapshot.h"
 #include "GMCoverLoader.h"
 
 #include "GMFilter.h"
@@ -110,6 +111,8 @@ FXDEFMAP(GMDatabaseSource) GMDatabaseSourceMap[]={
   FXMAPFUNC(SEL_COMMAND,GMDatabaseSource::ID_IMPORT_PLAYLIST,GMDatabaseSource::onCmdImportPlayList),
 
   FXMAPFUNC(SEL_COMMAND,GMDatabaseSource::ID_NEW_FILTER,GMDatabaseSource::onCmdNewFilter),
+  FXMAPFUNC(SEL_COMMAND,GMDatabaseSource::ID_BACKUP_LIBRARY,GMDatabaseSource::onCmdBackupLibrary),
+  FXMAPFUNC(SEL_COMMAND,GMDatabaseSource::ID_RESTORE_LIBRARY,GMDatabaseSource::onCmdRestoreLibrary),
 
   FXMAPFUNC(SEL_COMMAND,GMDatabaseSource::ID_CLEAR,GMDatabaseSource::onCmdClear),
   FXMAPFUNC(SEL_DND_DROP,GMDatabaseSource::ID_DROP,GMDatabaseSource::onCmdDrop),
@@ -370,6 +373,9 @@ FXbool GMDatabaseSource::source_menu(FXMenuPane * pane){
   new GMMenuCommand(pane,fxtr("New Filter…\t\tCreate a new filter"),nullptr,this,GMDatabaseSource::ID_NEW_FILTER);
   new GMMenuCommand(pane,fxtr("New Playlist…\t\tCreate a new playlist"),nullptr,this,GMDatabaseSource::ID_NEW_PLAYLIST);
   new GMMenuCommand(pane,fxtr("Import Playlist…\t\tImport existing playlist"),GMIconTheme::instance()->icon_import,this,GMDatabaseSource::ID_IMPORT_PLAYLIST);
+  new FXMenuSeparator(pane);
+  new GMMenuCommand(pane,fxtr("Backup Library…\t\tSave a snapshot of the music library"),nullptr,this,GMDatabaseSource::ID_BACKUP_LIBRARY);
+  new GMMenuCommand(pane,fxtr("Restore Library…\t\tReplace the music library with a snapshot"),nullptr,this,GMDatabaseSource::ID_RESTORE_LIBRARY);
   return true;
   }
 
@@ -491,6 +497,19 @@ FXbool GMDatabaseSource::setFilter(const FXString & text,FXuint mask){
   }
 
 
+/*
+  Without filters, browsing reads from the separate read connection so it
+  doesn't wait for running tasks. The filter tables are temporary and only
+  exist on the main connection.
+*/
+sqlite3_stmt * GMDatabaseSource::compileBrowse(const FXString & query) {
+  if (hasFilter() || hasview)
+    return db->compile(query);
+  else
+    return db->compileRead(query);
+  }
+
+
 FXbool GMDatabaseSource::listTags(GMList * list,FXIcon * icon) {
   FXint id;
   GMQuery q;
@@ -510,9 +529,9 @@ FXbool GMDatabaseSource::listTags(GMList * list,FXIcon * icon) {
       if (playlist)
         query = "SELECT DISTINCT(tags.id),tags.name from tags WHERE id IN (SELECT tag FROM playlist_tracks JOIN track_tags ON (playlist_tracks.playlist == "  + FXString::value(playlist) +" AND track_tags.track == playlist_tracks.track));";
       else
-        query = "SELECT DISTINCT(id),name FROM tags WHERE id IN (SELECT tag FROM track_tags);";
+        query = "SELECT id,name FROM tags WHERE id IN (SELECT DISTINCT(tag) FROM album_tags);";
       }
-    q = db->compile(query);
+    q = compileBrowse(query);
     while(q.row()){
       q.get(0,id);
       list->appendItem(q.get(1),icon,(void*)(FXival)id);
@@ -565,17 +584,17 @@ FXbool GMDatabaseSource::listArtists(GMList * list,FXIcon * icon,const FXIntList
     else {
       if (taglist.no()==0) {
         if (!playlist)
-          query = "SELECT id,name FROM artists WHERE id IN (SELECT DISTINCT(artist) FROM albums);";
+          query = "SELECT id,name FROM artists WHERE id IN (SELECT artist FROM artist_summary);";
         else
           query = "SELECT DISTINCT(artists.id), artists.name FROM albums JOIN artists ON artists.id == albums.artist AND albums.id IN (SELECT DISTINCT(album) FROM playlist_tracks JOIN tracks ON playlist_tracks.track == tracks.id AND playlist_tracks.playlist == " + FXString::value(playlist) + " ORDER BY album)";
         }
       else {
         if (!playlist) {
-          query = "SELECT DISTINCT(id), name FROM artists "
+          query = "SELECT id,name FROM artists "
                     "WHERE id IN ( "
                       "SELECT artist "
-                      "FROM albums WHERE id IN ( "
-                        "SELECT DISTINCT(album) FROM tracks, track_tags WHERE tracks.id == track_tags.track AND tag";
+                      "FROM album_summary WHERE album IN ( "
+                        "SELECT album FROM album_tags WHERE tag";
           query+=tagselection + "));";
           }
         else {
@@ -583,7 +602,7 @@ FXbool GMDatabaseSource::listArtists(GMList * list,FXIcon * icon,const FXIntList
           }
         }
       }
-    q = db->compile(query);
+    q = compileBrowse(query);
     while(q.row()){
       q.get(0,id);
       name=q.get(1);
@@ -657,24 +676,20 @@ FXbool GMDatabaseSource::listAlbums(GMAlbumList * list,const FXIntList & artistl
         }
       else {
         if (taglist.no()) {
-          query = "SELECT albums.id,albums.name,albums.year,artists.id,albums.audio_channels,albums.audio_rate,albums.audio_format FROM albums,artists WHERE artists.id == albums.artist AND albums.id IN (SELECT DISTINCT(album) FROM tracks WHERE id IN (SELECT DISTINCT(track) FROM track_tags WHERE tag " + tagselection + ")) ";
+          query = "SELECT albums.id,albums.name,album_summary.year,album_summary.artist,albums.audio_channels,albums.audio_rate,albums.audio_format FROM album_summary JOIN albums ON albums.id == album_summary.album WHERE album_summary.album IN (SELECT album FROM album_tags WHERE tag " + tagselection + ")";
           if (artistlist.no())
-            query+=" AND albums.artist " + artistselection;
+            query+=" AND album_summary.artist " + artistselection;
           }
         else {
-          query = "SELECT albums.id,albums.name,albums.year,artists.id,albums.audio_channels,albums.audio_rate,albums.audio_format FROM albums,artists";
-          if (artistlist.no()) {
-            query+=" WHERE artist " + artistselection;
-            query+=" AND artists.id == albums.artist";
-            }
-          else
-            query+=" WHERE artists.id == albums.artist ";
+          query = "SELECT albums.id,albums.name,album_summary.year,album_summary.artist,albums.audio_channels,albums.audio_rate,albums.audio_format FROM album_summary JOIN albums ON albums.id == album_summary.album";
+          if (artistlist.no())
+            query+=" WHERE album_summary.artist " + artistselection;
           }
         }
       query+=" ORDER BY albums.name;";
       }
 
-    q = db->compile(query);
+    q = compileBrowse(query);
 
     while(q.row()){
       q.get(0,id);
@@ -835,7 +850,7 @@ FXbool GMDatabaseSource::listTracks(GMTrackList * tracklist,const FXIntList & al
     else
       query+=";";
 
-    q = db->compile(query);
+    q = compileBrowse(query);
 
     while(q.row()){
       q.get(0,id);
@@ -1098,6 +1113,43 @@ long GMDatabaseSource::onUpdExport(FXObject*sender,FXSelector,void*){
   }
 
 
+long GMDatabaseSource::onCmdBackupLibrary(FXObject*,FXSelector,void*){
+  const FXchar patterns[]="Library Snapshot (*.gmlib)";
+  GMFileDialog dialog(GMPlayerManager::instance()->getMainWindow(),fxtr("Backup Library"));
+  dialog.setDirectory(FXApp::instance()->reg().readStringEntry("Settings","last-export-directory",FXSystem::getHomeDirectory().text()));
+  dialog.setSelectMode(SELECTFILE_ANY);
+  dialog.setPatternList(patterns);
+  if (dialog.execute()){
+    FXString filename = dialog.getFilename();
+    if (FXPath::extension(filename).empty())
+      filename+=".gmlib";
+
+    if (FXStat::exists(filename)){
+      if (FXMessageBox::question(GMPlayerManager::instance()->getMainWindow(),MBOX_YES_NO,fxtr("Overwrite File?"),fxtr("File already exists. Would you like to overwrite it?"))!=MBOX_CLICKED_YES)
+        return 1;
+      }
+    FXApp::instance()->reg().writeStringEntry("Settings","last-export-directory",dialog.getDirectory().text());
+    GMPlayerManager::instance()->runTask(new GMExportSnapshotTask(GMPlayerManager::instance(),GMPlayerManager::ID_SNAPSHOT_TASK,filename));
+    }
+  return 1;
+  }
+
+
+long GMDatabaseSource::onCmdRestoreLibrary(FXObject*,FXSelector,void*){
+  const FXchar patterns[]="Library Snapshot (*.gmlib)";
+  GMFileDialog dialog(GMPlayerManager::instance()->getMainWindow(),fxtr("Restore Library"));
+  dialog.setDirectory(FXApp::instance()->reg().readStringEntry("Settings","last-export-directory",FXSystem::getHomeDirectory().text()));
+  dialog.setSelectMode(SELECTFILE_EXISTING);
+  dialog.setPatternList(patterns);
+  if (dialog.execute()){
+    if (FXMessageBox::question(GMPlayerManager::instance()->getMainWindow(),MBOX_YES_NO,fxtr("Restore Library?"),fxtr("All tracks and playlists in the music library will be replaced. Continue?"))!=MBOX_CLICKED_YES)
+      return 1;
+    GMPlayerManager::instance()->runTask(new GMImportSnapshotTask(GMPlayerManager::instance(),GMPlayerManager::ID_SNAPSHOT_TASK,dialog.getFilename()));
+    }
+  return 1;
+  }
+
+
 #include "GMCover.h"
 
 
@@ -1662,6 +1714,7 @@ long GMDatabaseSource::onCmdTrackPlayed(FXObject*,FXSelector,void*) {
   FXASSERT(current_track>=0);
   FXlong timestamp = (FXlong)FXThread::time();
   db->setTrackPlayed(current_track,timestamp);
+  GMPlayerManager::instance()->schedule_sync_played();
   GMTrack info;
   if (getTrack(info) && GMPlayerManager::instance()->getAudioScrobbler())
     GMPlayerManager::instance()->getAudioScrobbler()->submit(timestamp,info);
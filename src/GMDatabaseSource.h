@@ -25,6 +25,7 @@
 
 class GMSource;
 class GMTrackDatabase;
+struct sqlite3_stmt;
 
 class GMDatabaseClipboardData : public GMClipboardData {
 public:
@@ -62,6 +63,7 @@ private:
 protected:
   void removeFiles(const FXStringList & files);
   FXbool hasFilter() const { return hasfilter; }
+  sqlite3_stmt * compileBrowse(const FXString & query);
 public:
   enum {
     ID_NEW_PLAYLIST = GMSource::ID_LAST,
@@ -82,6 +84,8 @@ public:
     ID_SEARCH_COVER_ALBUM,
     ID_LOAD_COVERS,
     ID_NEW_FILTER,
+    ID_BACKUP_LIBRARY,
+    ID_RESTORE_LIBRARY,
     ID_LAST
     };
 public:
@@ -111,6 +115,8 @@ public:
   long onCmdMainWindow(FXObject*,FXSelector,void*);
   long onCmdLoadCovers(FXObject*,FXSelector,void*);
   long onCmdNewFilter(FXObject*,FXSelector,void*);
+  long onCmdBackupLibrary(FXObject*,FXSelector,void*);
+  long onCmdRestoreLibrary(FXObject*,FXSelector,void*);
 public:
   GMDatabaseSource(GMTrackDatabase * db);
 
@@ -18,6 +18,7 @@
 ********************************************************************************/
 #include "gmdefs.h"
 #include "GMIconTheme.h"
+#include "GMDatabase.h"
 #include "GMFilter.h"
 #include "GMFilterEditor.h"
 
@@ -66,6 +67,21 @@ static FXString sql_escape(FXString value) {
   return value.substitute("\'","\'\'");
   }
 
+static FXString glob_escape(FXString value) {
+  return value.substitute("[","[[]").substitute("*","[*]").substitute("?","[?]");
+  }
+
+// Rewrite regular expressions with a literal prefix to GLOB, which can use an index
+static FXString regex_match(const FXchar * column,const FXchar * name,const FXString & pattern) {
+  FXString prefix;
+  if (GMDatabase::regex_prefix(pattern,prefix))
+    return FXString::value("%s GLOB '%s*'",column,sql_escape(glob_escape(prefix)).text());
+  else if (!prefix.empty())
+    return FXString::value("%s GLOB '%s*' AND %s REGEXP '%s'",column,sql_escape(glob_escape(prefix)).text(),name,sql_escape(pattern).text());
+  else
+    return FXString::value("%s REGEXP '%s'",column,sql_escape(pattern).text());
+  }
+
 // Get sql match string
 FXString Rule::getMatch() const {
   switch(column) {
@@ -86,8 +102,8 @@ FXString Rule::getMatch() const {
           case OperatorEquals   :
           case OperatorNotEqual :
           case OperatorLess     :
-          case OperatorGreater  :
-          case OperatorMatch    : return FXString::value("%s %s '%s'",column_lookup[column],operator_lookup[opcode],sql_escape(text).text()); break;
+          case OperatorGreater  : return FXString::value("%s %s '%s'",column_lookup[column],operator_lookup[opcode],sql_escape(text).text()); break;
+          case OperatorMatch    : return "(" + regex_match(column_lookup[column],column_lookup[column],text) + ")"; break;
           }
       } break;
     case ColumnTag:
@@ -100,8 +116,8 @@ FXString Rule::getMatch() const {
           case OperatorEquals   :
           case OperatorNotEqual :
           case OperatorLess     :
-          case OperatorGreater  :
-          case OperatorMatch    : return FXString::value("%s %s '%s')",column_lookup[column],operator_lookup[opcode],sql_escape(text).text()); break;
+          case OperatorGreater  : return FXString::value("%s %s '%s')",column_lookup[column],operator_lookup[opcode],sql_escape(text).text()); break;
+          case OperatorMatch    : return regex_match(column_lookup[column],"tags.name",text) + ")"; break;
           }
       } break;
     case ColumnYear:
@@ -209,8 +225,8 @@ GMFilter::GMFilter(const FXString & n,FXint column,FXint opcode,FXint value) :
   }
 
 
-// Get sql match string
-FXString GMFilter::getMatch() const {
+// Get sql expression for the rules only
+FXString GMFilter::getRules() const {
   FXString query;
   FXString rule = (match == MatchAll) ? " AND " : " OR ";
 
@@ -218,6 +234,23 @@ FXString GMFilter::getMatch() const {
     if (!query.empty()) query+=rule;
     query += rules[i].getMatch();
     }
+  return query;
+  }
+
+
+// Rules depend on the current time
+FXbool GMFilter::isTimeRelative() const {
+  for (FXint i=0;i<rules.no();i++) {
+    if (rules[i].column==Rule::ColumnPlayDate || rules[i].column==Rule::ColumnImportDate)
+      return true;
+    }
+  return false;
+  }
+
+
+// Get sql match string
+FXString GMFilter::getMatch() const {
+  FXString query = getRules();
   if (!query.empty())
     query.prepend("WHERE ");
 
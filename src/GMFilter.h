@@ -126,6 +126,15 @@ public:
   // Get sql match string
   FXString getMatch() const;
 
+  // Get sql expression for the rules only
+  FXString getRules() const;
+
+  // Rules depend on the current time
+  FXbool isTimeRelative() const;
+
+  // Results can be maintained per track
+  FXbool isIncremental() const { return limit<=0; }
+
   // Load from stream
   void load(FXStream &);
 
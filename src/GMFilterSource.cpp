@@ -46,7 +46,11 @@
 
 #define FILTER_DB_V1 2015
 
+// Rebuild interval for filters with time relative rules
+static const FXTime refresh_interval = 60000000000LL;
+
 FXObjectListOf<GMFilterSource> GMFilterSource::sources;
+GMFilterSource * GMFilterSource::current = nullptr;
 
 
 void GMFilterSource::init(GMTrackDatabase * database,GMSourceList & list){
@@ -142,6 +146,7 @@ GMFilterSource::GMFilterSource(GMTrackDatabase * db) : GMDatabaseSource(db) {
 
 
 GMFilterSource::~GMFilterSource(){
+  if (current==this) current=nullptr;
   }
 
 
@@ -155,31 +160,126 @@ FXString GMFilterSource::getName() const {
   }
 
 
+FXString GMFilterSource::getViewQuery() const {
+  return "SELECT tracks.id, tracks.album FROM tracks JOIN albums ON tracks.album == albums.id "
+                                                 "JOIN artists AS album_artist ON (albums.artist == album_artist.id) "
+                                                 "JOIN artists AS track_artist ON (tracks.artist == track_artist.id) "
+                                                 "JOIN pathlist ON (tracks.path == pathlist.id) "
+                                                 "LEFT JOIN artists AS composers ON (tracks.composer == composers.id) "
+                                                 "LEFT JOIN artists AS conductors ON (tracks.conductor == conductors.id) ";
+  }
+
+
+/*
+  The filter results are materialized into the query_view table, so browsing
+  doesn't re-evaluate the rules for every list. Only one filter is materialized
+  at a time.
+*/
 void GMFilterSource::updateView() {
   FXString query = match.getMatch();
   if (query.length()) {
-    db->execute("DROP VIEW IF EXISTS query_view;");
-    db->execute("CREATE TEMP VIEW query_view AS "
-                "SELECT tracks.id as track, tracks.album as album FROM tracks JOIN albums ON tracks.album == albums.id "
-                                                                             "JOIN artists AS album_artist ON (albums.artist == album_artist.id) "
-                                                                             "JOIN artists AS track_artist ON (tracks.artist == track_artist.id) "
-                                                                             "JOIN pathlist ON (tracks.path == pathlist.id) "
-                                                                             "LEFT JOIN artists AS composers ON (tracks.composer == composers.id) "
-                                                                             "LEFT JOIN artists AS conductors ON (tracks.conductor == conductors.id) " + query);
+    try {
+      GMLockTransaction transaction(db);
+      db->getTrackJournal(version,epoch);
+      db->execute("DROP TABLE IF EXISTS query_view;");
+      db->execute("CREATE TEMP TABLE query_view (track INTEGER PRIMARY KEY, album INTEGER);");
+      db->execute("INSERT INTO query_view " + getViewQuery() + query);
+      db->execute("CREATE INDEX temp.query_view_album ON query_view(album);");
+      transaction.commit();
+      }
+    catch(GMDatabaseException&){
+      current=nullptr;
+      hasview=false;
+      return;
+      }
+    updated=FXThread::time();
+    current=this;
     hasview=true;
     }
   else {
+    if (current==this) current=nullptr;
     hasview=false;
     }
   }
 
 
+/*
+  Bring query_view up to date with the track journal. Changed tracks are
+  removed and matched again, unless the filter has a row limit or the
+  change affected more than individual tracks.
+*/
+void GMFilterSource::syncView() {
+  if (!hasview) return;
+
+  if (current!=this) {
+    updateView();
+    return;
+    }
+
+  if (match.isTimeRelative() && FXThread::time()-updated>refresh_interval) {
+    updateView();
+    return;
+    }
+
+  try {
+    FXlong v,e;
+    db->getTrackJournal(v,e);
+    if (v==version && e==epoch)
+      return;
+
+    if (e!=epoch || !match.isIncremental()) {
+      updateView();
+      return;
+      }
+
+    GM_DEBUG_PRINT("[filter] sync %s from version %lld to %lld\n",match.name.text(),version,v);
+    GMLockTransaction transaction(db);
+    GMQuery remove_tracks(db,"DELETE FROM query_view WHERE track IN (SELECT track FROM track_journal WHERE version > ?);");
+    FXString insert = "INSERT OR IGNORE INTO query_view " + getViewQuery() + "WHERE tracks.id IN (SELECT track FROM track_journal WHERE version > ?) AND (" + match.getRules() + ");";
+    GMQuery insert_tracks(db,insert.text());
+    remove_tracks.set(0,version);
+    remove_tracks.execute();
+    insert_tracks.set(0,version);
+    insert_tracks.execute();
+    transaction.commit();
+    version=v;
+    }
+  catch(GMDatabaseException&){
+    updateView();
+    }
+  }
+
+
 void GMFilterSource::configure(GMColumnList& columns) {
   GMDatabaseSource::configure(columns);
   updateView();
   }
 
 
+FXbool GMFilterSource::listTags(GMList * taglist,FXIcon * icon) {
+  syncView();
+  return GMDatabaseSource::listTags(taglist,icon);
+  }
+
+
+FXbool GMFilterSource::listArtists(GMList * artistlist,FXIcon * icon,const FXIntList & taglist) {
+  syncView();
+  return GMDatabaseSource::listArtists(artistlist,icon,taglist);
+  }
+
+
+FXbool GMFilterSource::listAlbums(GMAlbumList * albumlist,const FXIntList & artistlist,const FXIntList & taglist) {
+  syncView();
+  return GMDatabaseSource::listAlbums(albumlist,artistlist,taglist);
+  }
+
+
+FXbool GMFilterSource::listTracks(GMTrackList * tracklist,const FXIntList & albumlist,const FXIntList & taglist) {
+  syncView();
+  return GMDatabaseSource::listTracks(tracklist,albumlist,taglist);
+  }
+
+
 long GMFilterSource::onCmdEdit(FXObject*,FXSelector,void*){
   GMFilterEditor editor(GMPlayerManager::instance()->getMainWindow(),match);
   if (editor.execute(PLACEMENT_SCREEN)) {
@@ -26,6 +26,7 @@ class GMFilterSource : public GMDatabaseSource {
 FXDECLARE(GMFilterSource)
 protected:
   static FXObjectListOf<GMFilterSource> sources;  // global list of all filters
+  static GMFilterSource *               current;  // filter materialized in query_view
 public:
   // Initialize Filter Database
   static void init(GMTrackDatabase * database,GMSourceList &);
@@ -36,7 +37,13 @@ public:
   // Create New Filter
   static void create(GMTrackDatabase * database);
 protected:
-  GMFilter match; // the actual filter
+  GMFilter match;        // the actual filter
+  FXlong   version = -1; // track journal version of query_view
+  FXlong   epoch   = -1; // track journal epoch of query_view
+  FXTime   updated = 0;  // last time query_view was rebuilt
+protected:
+  FXString getViewQuery() const;
+  void syncView();
 protected:
   GMFilterSource(){}
 private:
@@ -64,6 +71,18 @@ public:
   // Configure
   void configure(GMColumnList&) override;
 
+  // List Tags
+  FXbool listTags(GMList * taglist,FXIcon * icon) override;
+
+  // List Artists
+  FXbool listArtists(GMList * artistlist,FXIcon * icon,const FXIntList & taglist) override;
+
+  // List Albums
+  FXbool listAlbums(GMAlbumList *,const FXIntList &,const FXIntList &) override;
+
+  // List Tracks
+  FXbool listTracks(GMTrackList * tracklist,const FXIntList & albumlist,const FXIntList & taglist) override;
+
   // Source Name
   FXString getName() const override;
 
@@ -0,0 +1,575 @@
+/*******************************************************************************
+*                         Goggles Music Manager                                *
+********************************************************************************
+*           Copyright (C) 2006-2026 by Sander Jansen. All Rights Reserved      *
+*                               ---                                            *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License for more details.                                 *
+*                                                                              *
+* You should have received a copy of the GNU General Public License            *
+* along with this program.  If not, see http://www.gnu.org/licenses.           *
+********************************************************************************/
+#include "gmdefs.h"
+#include "gmutils.h"
+#include "GMTaskManager.h"
+#include "GMTrack.h"
+#include "GMDatabase.h"
+#include "GMTrackDatabase.h"
+#include "GMPlayerManager.h"
+#include "GMLibrarySnapshot.h"
+
+/*
+  Library Snapshot
+
+  A compact copy of the music library, used for backups and to move a library
+  to another machine without rescanning it.
+
+    file    := magic[4] version table* 0
+    table   := name columns types group* 0
+    group   := size payload
+    payload := rows column*
+    column  := flags [null bitmap] [dictionary] value*
+
+  All numbers are LEB128 varints. Integer columns store the zigzag encoded
+  difference with the previous row, so ordered ids and dates mostly take a
+  byte or two. Text columns store a dictionary of unique strings followed by
+  one index per row. Tables are split in groups of rows, so neither export
+  nor import needs to keep a complete table in memory.
+*/
+
+static const FXchar  snapshot_magic[4] = {'G','M','L','S'};
+static const FXuchar snapshot_version  = 1;
+
+/// Rows per group
+#define SNAPSHOT_GROUP_SIZE 16384
+
+/// Sanity limits for reading
+#define SNAPSHOT_MAX_NAME  4096
+#define SNAPSHOT_MAX_GROUP 0x40000000
+
+/// Column flags
+#define SNAPSHOT_HAS_NULLS 1
+
+
+struct GMSnapshotTable {
+  const FXchar * name;
+  const FXchar * columns;
+  const FXchar * types;     // I: integer, S: text, T: tag id, P: playlist id
+  const FXchar * filter;
+  FXuchar        key;       // first column gets a new id on import (T or P)
+  };
+
+/// Tables in order of their dependencies
+static const GMSnapshotTable snapshot_tables[]={
+  {"pathlist","id,name","IS",nullptr,0},
+  {"artists","id,name","IS",nullptr,0},
+  {"albums","id,name,artist,year,audio_channels,audio_rate,audio_format","ISIIIII",nullptr,0},
+  {"tags","id,name","TS"," WHERE id IN (SELECT tag FROM track_tags)",'T'},
+  {"tracks","id,collection,path,mrl,title,time,no,year,bitrate,album,artist,composer,conductor,playcount,playdate,importdate,rating,samplerate,channels,filetype,lyrics","IIISSIIIIIIIIIIIIIIIS",nullptr,0},
+  {"track_tags","track,tag","IT",nullptr,0},
+  {"playlists","id,name","PS"," WHERE name!='__buildin_playqueue__'",'P'},
+  {"playlist_tracks","playlist,track,queue","PII"," WHERE playlist IN (SELECT id FROM playlists WHERE name!='__buildin_playqueue__')",0},
+  {"play_history","track,date","II",nullptr,0}
+  };
+
+
+static FXbool snapshot_read(FXFile & file,FXulong & v) {
+  FXuchar c;
+  v=0;
+  for (FXuint shift=0;shift<64;shift+=7) {
+    if (file.readBlock(&c,1)!=1) return false;
+    v|=((FXulong)(c&0x7f))<<shift;
+    if (!(c&0x80)) return true;
+    }
+  return false;
+  }
+
+static FXbool snapshot_read(FXFile & file,FXString & s) {
+  FXulong n;
+  if (!snapshot_read(file,n) || n>SNAPSHOT_MAX_NAME) return false;
+  s.length((FXint)n);
+  return n==0 || file.readBlock(&s[0],s.length())==s.length();
+  }
+
+static FXbool snapshot_write(FXFile & file,const FXString & buffer) {
+  return file.writeBlock(buffer.text(),buffer.length())==buffer.length();
+  }
+
+static inline FXulong snapshot_zigzag(FXlong v) {
+  return ((FXulong)v<<1)^(FXulong)(v>>63);
+  }
+
+static inline FXlong snapshot_unzigzag(FXulong v) {
+  return (FXlong)(v>>1)^-(FXlong)(v&1);
+  }
+
+
+class GMSnapshotColumn {
+public:
+  FXString        values;     // encoded values
+  FXString        nulls;      // null bitmap
+  FXStringList    strings;    // dictionary
+  FXDictionary    dictionary; // string to index+1
+  FXArray<FXlong> data;       // decoded values or dictionary indices
+  FXlong          last = 0;
+  FXint           rows = 0;
+  FXbool          hasnulls = false;
+  FXbool          text = false;
+public:
+  void reset();
+  void append(GMQuery & q,FXint col);
+  void encode(FXString & buffer) const;
+  FXbool decode(const FXuchar *& p,const FXuchar * end,FXint n);
+  FXbool null(FXint row) const { return hasnulls && (nulls[row>>3]&(1<<(row&7))); }
+  };
+
+
+void GMSnapshotColumn::reset() {
+  values.clear();
+  nulls.clear();
+  strings.clear();
+  dictionary.clear();
+  last=0;
+  rows=0;
+  hasnulls=false;
+  }
+
+
+void GMSnapshotColumn::append(GMQuery & q,FXint col) {
+  if ((rows&7)==0) nulls.append('\0');
+  if (q.is_null(col)) {
+    nulls[rows>>3]|=(FXchar)(1<<(rows&7));
+    hasnulls=true;
+    }
+  else if (text) {
+    FXString s;
+    q.get(col,s);
+    FXint index = (FXint)(FXival)dictionary[s];
+    if (index==0) {
+      strings.append(s);
+      index=strings.no();
+      dictionary.insert(s,(void*)(FXival)index);
+      }
+    gm_varint_put(values,(FXulong)(index-1));
+    }
+  else {
+    FXlong v;
+    q.get(col,v);
+    gm_varint_put(values,snapshot_zigzag((FXlong)((FXulong)v-(FXulong)last)));
+    last=v;
+    }
+  rows++;
+  }
+
+
+void GMSnapshotColumn::encode(FXString & buffer) const {
+  buffer.append((FXchar)(hasnulls ? SNAPSHOT_HAS_NULLS : 0));
+  if (hasnulls) buffer.append(nulls);
+  if (text) {
+    gm_varint_put(buffer,(FXulong)strings.no());
+    for (FXint i=0;i<strings.no();i++) {
+      gm_varint_put(buffer,strings[i]);
+      }
+    }
+  buffer.append(values);
+  }
+
+
+FXbool GMSnapshotColumn::decode(const FXuchar *& p,const FXuchar * end,FXint n) {
+  FXulong v;
+
+  if (p>=end) return false;
+  hasnulls = (*p++ & SNAPSHOT_HAS_NULLS)!=0;
+  if (hasnulls) {
+    const FXint nbytes = (n+7)>>3;
+    if (end-p<nbytes) return false;
+    nulls.assign((const FXchar*)p,nbytes);
+    p+=nbytes;
+    }
+
+  if (text) {
+    if (!gm_varint_get(p,end,v) || v>(FXulong)(end-p)) return false;
+    strings.no((FXint)v);
+    for (FXint i=0;i<strings.no();i++) {
+      if (!gm_varint_get(p,end,strings[i])) return false;
+      }
+    }
+
+  data.no(n);
+  last=0;
+  for (FXint i=0;i<n;i++) {
+    if (null(i)) continue;
+    if (!gm_varint_get(p,end,v)) return false;
+    if (text) {
+      if (v>=(FXulong)strings.no()) return false;
+      data[i]=(FXlong)v;
+      }
+    else {
+      last=(FXlong)((FXulong)last+(FXulong)snapshot_unzigzag(v));
+      data[i]=last;
+      }
+    }
+  return true;
+  }
+
+
+static FXbool snapshot_write_group(FXFile & file,GMSnapshotColumn * columns,FXint ncolumns,FXint rows) {
+  FXString payload,size;
+  gm_varint_put(payload,(FXulong)rows);
+  for (FXint i=0;i<ncolumns;i++) {
+    columns[i].encode(payload);
+    columns[i].reset();
+    }
+  gm_varint_put(size,(FXulong)payload.length());
+  return snapshot_write(file,size) && snapshot_write(file,payload);
+  }
+
+
+static const GMSnapshotTable * snapshot_find_table(const FXString & name) {
+  for (FXuint i=0;i<ARRAYNUMBER(snapshot_tables);i++) {
+    if (name==snapshot_tables[i].name)
+      return &snapshot_tables[i];
+    }
+  return nullptr;
+  }
+
+
+/*----------------------------------------------------------------------------*/
+
+
+GMExportSnapshotTask::GMExportSnapshotTask(FXObject*tgt,FXSelector sel,const FXString & f) : GMTask(tgt,sel),filename(f) {
+  database     = GMPlayerManager::instance()->getTrackDatabase();
+  databasefile = GMPlayerManager::instance()->getDatabaseFilename();
+  }
+
+GMExportSnapshotTask::~GMExportSnapshotTask() {
+  }
+
+
+FXint GMExportSnapshotTask::run() {
+  GMDatabase snapshot;
+  FXString   header(snapshot_magic,4);
+  FXString   trailer;
+  FXString   mode;
+  FXbool     done;
+
+  header.append((FXchar)snapshot_version);
+  gm_varint_put(trailer,(FXulong)0);
+
+  taskmanager->setStatus("Exporting Library..");
+
+  if (!snapshot.open(databasefile))
+    return 1;
+
+  try {
+    GMQuery journal(&snapshot,"PRAGMA journal_mode;");
+    journal.execute(mode);
+    }
+  catch(GMDatabaseException&) {
+    return 1;
+    }
+
+  FXFile file(filename+".part",FXIO::Writing);
+  if (!file.isOpen())
+    return 1;
+
+  done=snapshot_write(file,header);
+  try {
+    // All tables are read within one transaction and therefore from one consistent snapshot
+    if (mode=="wal") {
+      // Separate connection, so the export neither blocks nor sees other tasks
+      GMScopedTransaction transaction(&snapshot);
+      done=done && export_tables(snapshot,file);
+      transaction.commit();
+      }
+    else {
+      // Without WAL its read lock would make user interface writes fail. Hold the
+      // database like any other task instead, so they wait for the export.
+      GM_DEBUG_PRINT("[snapshot] journal mode %s, exporting through the shared connection\n",mode.text());
+      GMTaskTransaction transaction(database);
+      done=done && export_tables(*database,file);
+      transaction.commit();
+      }
+    }
+  catch(GMDatabaseException&) {
+    done=false;
+    }
+
+  done = done && processing && snapshot_write(file,trailer) && file.flush();
+  file.close();
+
+  if (done)
+    done=FXFile::rename(filename+".part",filename);
+  else
+    FXFile::remove(filename+".part");
+
+  return done ? 0 : 1;
+  }
+
+
+FXbool GMExportSnapshotTask::export_tables(GMDatabase & source,FXFile & file) {
+  for (FXuint i=0;i<ARRAYNUMBER(snapshot_tables) && processing;i++) {
+    if (!export_table(source,file,snapshot_tables[i]))
+      return false;
+    }
+  return true;
+  }
+
+
+FXbool GMExportSnapshotTask::export_table(GMDatabase & snapshot,FXFile & file,const GMSnapshotTable & table) {
+  const FXint ncolumns = (FXint)strlen(table.types);
+  FXString buffer;
+  FXint    rows=0;
+  FXbool   ok=true;
+
+  gm_varint_put(buffer,FXString(table.name));
+  gm_varint_put(buffer,FXString(table.columns));
+  gm_varint_put(buffer,FXString(table.types));
+  if (!snapshot_write(file,buffer))
+    return false;
+
+  GMSnapshotColumn * columns = new GMSnapshotColumn[ncolumns];
+  for (FXint i=0;i<ncolumns;i++) {
+    columns[i].text = (table.types[i]=='S');
+    }
+
+  try {
+    GMQuery query(&snapshot,FXString::value("SELECT %s FROM %s%s;",table.columns,table.name,table.filter ? table.filter : "").text());
+    while(processing && query.row()) {
+      for (FXint i=0;i<ncolumns;i++) {
+        columns[i].append(query,i);
+        }
+      if (++rows==SNAPSHOT_GROUP_SIZE) {
+        if (!(ok=snapshot_write_group(file,columns,ncolumns,rows)))
+          break;
+        rows=0;
+        }
+      }
+    }
+  catch(GMDatabaseException&) {
+    ok=false;
+    }
+
+  if (ok && rows)
+    ok=snapshot_write_group(file,columns,ncolumns,rows);
+
+  delete [] columns;
+
+  buffer.clear();
+  gm_varint_put(buffer,(FXulong)0);
+  return ok && processing && snapshot_write(file,buffer);
+  }
+
+
+/*----------------------------------------------------------------------------*/
+
+
+GMImportSnapshotTask::GMImportSnapshotTask(FXObject*tgt,FXSelector sel,const FXString & f) : GMTask(tgt,sel),filename(f) {
+  database = GMPlayerManager::instance()->getTrackDatabase();
+  }
+
+GMImportSnapshotTask::~GMImportSnapshotTask() {
+  }
+
+
+FXint GMImportSnapshotTask::run() {
+  FXString name,columns,types;
+  FXchar   header[5];
+  FXbool   done=false;
+
+  FXFile file(filename,FXIO::Reading);
+  if (!file.isOpen())
+    return 1;
+
+  if (file.readBlock(header,5)!=5 || memcmp(header,snapshot_magic,4)!=0 || (FXuchar)header[4]!=snapshot_version) {
+    GM_DEBUG_PRINT("[snapshot] unknown file format %s\n",filename.text());
+    return 1;
+    }
+
+  taskmanager->setStatus("Restoring Library..");
+
+  try {
+    // One transaction, so the library is either replaced completely or not at all
+    GMTaskTransaction transaction(database);
+
+    clear();
+
+    while(processing) {
+      if (!snapshot_read(file,name))
+        break;
+
+      if (name.empty()) {
+        done=true;
+        break;
+        }
+
+      if (!snapshot_read(file,columns) || !snapshot_read(file,types))
+        break;
+
+      const GMSnapshotTable * table = snapshot_find_table(name);
+      if (table==nullptr) {
+        GM_DEBUG_PRINT("[snapshot] skipping unknown table %s\n",name.text());
+        if (!skip_table(file)) break;
+        continue;
+        }
+
+      if (columns!=table->columns || types!=table->types) {
+        GM_DEBUG_PRINT("[snapshot] unexpected layout for table %s\n",name.text());
+        break;
+        }
+
+      if (!import_table(file,*table))
+        break;
+      }
+
+    if (!done)
+      return 1;
+
+    database->sync_summary();
+    transaction.commit();
+    }
+  catch(GMDatabaseException&) {
+    return 1;
+    }
+  return 0;
+  }
+
+
+void GMImportSnapshotTask::clear() {
+  database->execute("DELETE FROM playlist_tracks;");
+  database->execute("DELETE FROM play_history;");
+  database->execute("DELETE FROM track_tags;");
+  database->execute("DELETE FROM tracks;");
+  database->execute("DELETE FROM pathlist;");
+  database->execute("DELETE FROM albums;");
+  database->execute("DELETE FROM artists;");
+  database->execute("DELETE FROM album_tags;");
+  database->execute("DELETE FROM album_summary;");
+  database->execute("DELETE FROM artist_summary;");
+  database->execute("DELETE FROM tags WHERE id NOT IN (SELECT genre FROM streams UNION SELECT tag FROM feeds);");
+  database->execute("DELETE FROM playlists WHERE name!='__buildin_playqueue__';");
+  }
+
+
+FXbool GMImportSnapshotTask::skip_table(FXFile & file) {
+  FXulong size;
+  while(snapshot_read(file,size)) {
+    if (size==0) return true;
+    if (size>SNAPSHOT_MAX_GROUP || file.position((FXlong)size,FXIO::Current)<0) return false;
+    }
+  return false;
+  }
+
+
+/*
+  Tags and playlists may already exist in the database (stream genres and the
+  play queue), so they get new ids and references to them are mapped.
+*/
+FXbool GMImportSnapshotTask::import_table(FXFile & file,const GMSnapshotTable & table) {
+  const FXint ncolumns = (FXint)strlen(table.types);
+  const FXint first    = table.key ? 1 : 0;
+  FXString buffer;
+  FXString statement;
+  FXulong  size,rows;
+  FXbool   ok=true;
+
+  statement.format("INSERT INTO %s (%s) VALUES (?",table.name,table.key ? strchr(table.columns,',')+1 : table.columns);
+  for (FXint i=first+1;i<ncolumns;i++) statement+=",?";
+  statement+=");";
+
+  GMSnapshotColumn * columns = new GMSnapshotColumn[ncolumns];
+  for (FXint i=0;i<ncolumns;i++) {
+    columns[i].text = (table.types[i]=='S');
+    }
+
+  try {
+    GMQuery insert(database,statement.text());
+    GMQuery query_tag;
+
+    if (table.key=='T')
+      query_tag = database->compile("SELECT id FROM tags WHERE name == ?;");
+
+    while(ok && processing) {
+
+      if (!snapshot_read(file,size) || size>SNAPSHOT_MAX_GROUP) {
+        ok=false;
+        break;
+        }
+
+      // End of table
+      if (size==0)
+        break;
+
+      buffer.length((FXint)size);
+      if (file.readBlock(&buffer[0],buffer.length())!=buffer.length()) {
+        ok=false;
+        break;
+        }
+
+      const FXuchar * p   = (const FXuchar*)buffer.text();
+      const FXuchar * end = p + buffer.length();
+
+      if (!gm_varint_get(p,end,rows) || rows>SNAPSHOT_GROUP_SIZE) {
+        ok=false;
+        break;
+        }
+
+      for (FXint c=0;c<ncolumns && ok;c++) {
+        ok=columns[c].decode(p,end,(FXint)rows);
+        }
+
+      for (FXint r=0;r<(FXint)rows && ok;r++) {
+        FXbool skip=false;
+
+        for (FXint c=first;c<ncolumns;c++) {
+          const GMSnapshotColumn & column = columns[c];
+          if (column.null(r)) {
+            insert.set_null(c-first);
+            }
+          else if (column.text) {
+            insert.set(c-first,column.strings[(FXint)column.data[r]]);
+            }
+          else if (table.types[c]=='T' || table.types[c]=='P') {
+            const FXint id = (table.types[c]=='T') ? tagmap.at((FXint)column.data[r]) : playlistmap.at((FXint)column.data[r]);
+            if (id==0) skip=true;
+            insert.set(c-first,id);
+            }
+          else {
+            insert.set(c-first,column.data[r]);
+            }
+          }
+
+        if (skip)
+          continue;
+
+        if (table.key) {
+          FXint id=0;
+          if (table.key=='T' && !columns[1].null(r))
+            query_tag.execute(columns[1].strings[(FXint)columns[1].data[r]],id);
+          if (id==0)
+            id=database->insert(insert);
+          if (table.key=='T')
+            tagmap.insert((FXint)columns[0].data[r],id);
+          else
+            playlistmap.insert((FXint)columns[0].data[r],id);
+          }
+        else {
+          insert.execute();
+          }
+        }
+      }
+    }
+  catch(GMDatabaseException&) {
+    ok=false;
+    }
+
+  delete [] columns;
+  return ok && processing;
+  }
@@ -0,0 +1,59 @@
+/*******************************************************************************
+*                         Goggles Music Manager                                *
+********************************************************************************
+*           Copyright (C) 2006-2026 by Sander Jansen. All Rights Reserved      *
+*                               ---                                            *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License for more details.                                 *
+*                                                                              *
+* You should have received a copy of the GNU General Public License            *
+* along with this program.  If not, see http://www.gnu.org/licenses.           *
+********************************************************************************/
+#ifndef GMLIBRARYSNAPSHOT_H
+#define GMLIBRARYSNAPSHOT_H
+
+struct GMSnapshotTable;
+
+/// Write a snapshot of the music library to file
+class GMExportSnapshotTask : public GMTask {
+protected:
+  GMTrackDatabase * database = nullptr;
+  FXString          filename;
+  FXString          databasefile;
+protected:
+  FXbool export_tables(GMDatabase &,FXFile &);
+  FXbool export_table(GMDatabase &,FXFile &,const GMSnapshotTable &);
+  virtual FXint run();
+public:
+  GMExportSnapshotTask(FXObject*tgt,FXSelector sel,const FXString & filename);
+
+  virtual ~GMExportSnapshotTask();
+  };
+
+
+/// Replace the music library with a snapshot
+class GMImportSnapshotTask : public GMTask {
+protected:
+  GMTrackDatabase * database = nullptr;
+  FXString          filename;
+  FXIntMap          tagmap;
+  FXIntMap          playlistmap;
+protected:
+  void   clear();
+  FXbool import_table(FXFile &,const GMSnapshotTable &);
+  FXbool skip_table(FXFile &);
+  virtual FXint run();
+public:
+  GMImportSnapshotTask(FXObject*tgt,FXSelector sel,const FXString & filename);
+
+  virtual ~GMImportSnapshotTask();
+  };
+
+#endif
@@ -279,7 +279,7 @@ void GMNotifyDaemon::notify_track_change(const GMTrack & track){
 
   FXImagePtr image;
 
-  image = GMCover::copyToImage(GMPlayerManager::instance()->getCoverManager()->getCover(),64);
+  image = GMPlayerManager::instance()->getCoverManager()->getImage(64);
 
   notify(track.title.text(),body.text(),-1,image);
   }
@@ -156,6 +156,7 @@ void GMPlayQueue::addTracks(GMSource * src,const FXIntList & tracks) {
     ntracks+=tracks.no();
     updateTrackHash();
     GMPlayerManager::instance()->getSourceView()->refresh(this);
+    GMPlayerManager::instance()->prefetch_queue();
     }
   }
 
@@ -224,6 +225,23 @@ FXint GMPlayQueue::getNext() {
   }
 
 
+void GMPlayQueue::getUpcoming(FXIntList & list,FXint n) {
+  FXint track;
+  try {
+    GMQuery q(db,"SELECT track FROM playlist_tracks WHERE playlist == ? ORDER BY queue ASC LIMIT ? OFFSET ?");
+    q.set(0,playlist);
+    q.set(1,n);
+    q.set(2,poptrack ? 1 : 0);
+    while(q.row()) {
+      q.get(0,track);
+      list.append(track);
+      }
+    }
+  catch(GMDatabaseException & e){
+    }
+  }
+
+
 FXint GMPlayQueue::getCurrent() {
   current_track=-1;
   try {
@@ -70,6 +70,9 @@ public:
 
   FXint getNext();
 
+  /// Get up to n tracks that will be played after the current one
+  void getUpcoming(FXIntList & tracks,FXint n);
+
   FXint getType() const override { return SOURCE_PLAYQUEUE; }
 
   virtual ~GMPlayQueue();
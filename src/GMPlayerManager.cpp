@@ -53,6 +53,7 @@
 #include "GMFilename.h"
 
 #include "GMTaskManager.h"
+#include "GMLibrarySnapshot.h"
 #include "GMList.h"
 #include "GMTrackView.h"
 #include "GMSourceView.h"
@@ -96,10 +97,60 @@ enum {
   FIFO_STATUS_EXISTS = 2
   };
 
+
+/*
+  Startup Trace: set GOGGLESMM_TRACE_STARTUP to print the time spent in
+  each startup phase.
+*/
+static FXbool startup_trace = false;
+static FXTime startup_begin = 0;
+static FXTime startup_phase = 0;
+
+// Update podcasts once started
+static FXbool startup_podcasts = false;
+
+static void trace_startup(const FXchar * phase) {
+  if (startup_trace) {
+    FXTime now = FXThread::time();
+    fxmessage("[startup] %-24s %8.1f ms %8.1f ms\n",phase,(now-startup_phase)/1000000.0,(now-startup_begin)/1000000.0);
+    startup_phase = now;
+    }
+  }
+
+
+/*
+  Opens the database while the audio engine and icon theme are loaded.
+*/
+class GMDatabaseOpener : public FXThread {
+protected:
+  GMTrackDatabase * database;
+  FXString          filename;
+  FXTime            duration = 0;
+  FXbool            result   = false;
+public:
+  GMDatabaseOpener(GMTrackDatabase * db,const FXString & f) : database(db), filename(f) {}
+
+  FXint run() {
+    FXTime start = FXThread::time();
+    result = database->prepare(filename);
+    duration = FXThread::time() - start;
+    return 0;
+    }
+
+  FXbool prepared() const { return result; }
+
+  FXTime time() const { return duration; }
+  };
+
+
 FXDEFMAP(GMPlayerManager) GMPlayerManagerMap[]={
   FXMAPFUNC(SEL_TIMEOUT,GMPlayerManager::ID_UPDATE_TRACK_DISPLAY,GMPlayerManager::onUpdTrackDisplay),
   FXMAPFUNC(SEL_TIMEOUT,GMPlayerManager::ID_SLEEP_TIMER,GMPlayerManager::onCmdSleepTimer),
   FXMAPFUNC(SEL_TIMEOUT,GMPlayerManager::ID_PLAY_NOTIFY,GMPlayerManager::onPlayNotify),
+  FXMAPFUNC(SEL_COMMAND,GMPlayerManager::ID_COVER_MANAGER,GMPlayerManager::onCoverLoaded),
+  FXMAPFUNC(SEL_CHORE,GMPlayerManager::ID_STARTUP,GMPlayerManager::onStartup),
+  FXMAPFUNC(SEL_TIMEOUT,GMPlayerManager::ID_SYNC_PLAYED,GMPlayerManager::onSyncPlayed),
+  FXMAPFUNC(SEL_CHORE,GMPlayerManager::ID_SYNC_PLAYED,GMPlayerManager::onSyncPlayed),
   FXMAPFUNC(SEL_IO_READ,GMPlayerManager::ID_DDE_MESSAGE,GMPlayerManager::onDDEMessage),
   FXMAPFUNC(SEL_CLOSE,GMPlayerManager::ID_WINDOW,GMPlayerManager::onCmdCloseWindow),
   FXMAPFUNC(SEL_SIGNAL,GMPlayerManager::ID_CHILD,GMPlayerManager::onCmdChild),
@@ -128,6 +179,8 @@ FXDEFMAP(GMPlayerManager) GMPlayerManagerMap[]={
 
   FXMAPFUNC(SEL_TASK_COMPLETED,GMPlayerManager::ID_IMPORT_TASK,GMPlayerManager::onImportTaskCompleted),
   FXMAPFUNC(SEL_TASK_CANCELLED,GMPlayerManager::ID_IMPORT_TASK,GMPlayerManager::onImportTaskCompleted),
+  FXMAPFUNC(SEL_TASK_COMPLETED,GMPlayerManager::ID_SNAPSHOT_TASK,GMPlayerManager::onSnapshotTaskCompleted),
+  FXMAPFUNC(SEL_TASK_CANCELLED,GMPlayerManager::ID_SNAPSHOT_TASK,GMPlayerManager::onSnapshotTaskCompleted),
 #ifdef HAVE_SESSION
   FXMAPFUNC(SEL_SESSION_CLOSED,GMPlayerManager::ID_SESSION_MANAGER,GMPlayerManager::onCmdQuit)
 #endif
@@ -200,6 +253,19 @@ long GMPlayerManager::onPlayNotify(FXObject*,FXSelector,void*){
   return 0;
   }
 
+long GMPlayerManager::onCoverLoaded(FXObject*,FXSelector,void*){
+  mainwindow->update_meta_display();
+  mainwindow->update_cover_display();
+#ifdef HAVE_DBUS
+  // Notification already went out without the cover
+  if (sessionbus && !application->hasTimeout(this,ID_PLAY_NOTIFY)) {
+    if (mpris1) mpris1->notify_track_change(trackinfo);
+    if (mpris2) mpris2->notify_track_change(trackinfo);
+    }
+#endif
+  return 1;
+  }
+
 long GMPlayerManager::onUpdTrackDisplay(FXObject*,FXSelector,void*){
   //fxmessage("onUpdTrackDisplay\n");
   update_track_display();
@@ -378,14 +444,7 @@ FXint GMPlayerManager::init_fifo(int& argc,char** argv){
 
 FXbool GMPlayerManager::init_sources() {
 
-  // Main Database
-  database      = new GMTrackDatabase;
-  covermanager  = new GMCoverManager;
-
-  // Make sure we can open it.
-  if (!init_database(database)) {
-    return false;
-    }
+  covermanager  = new GMCoverManager(application,this,ID_COVER_MANAGER);
 
   /// Create the main database source
   sources.append(new GMDatabaseSource(database));
@@ -645,6 +704,9 @@ FXbool GMPlayerManager::init_dbus(int & argc,char**argv) {
 FXint GMPlayerManager::run(int& argc,char** argv) {
   FXint result;
 
+  startup_trace = !FXSystem::getEnvironment("GOGGLESMM_TRACE_STARTUP").empty();
+  startup_begin = startup_phase = FXThread::time();
+
   /// Initialize pre-thread libraries.
   GMTag::init();
 
@@ -654,6 +716,8 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
     return 1;
     }
 
+  trace_startup("libraries");
+
   /// Setup and migrate old config files.
   init_configuration();
 
@@ -662,6 +726,8 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
   application->init(argc,argv);
   application->create();
 
+  trace_startup("application");
+
   /// Keep track of child processes
   application->addSignal(SIGCHLD,this,GMPlayerManager::ID_CHILD);
 
@@ -714,14 +780,16 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
   /// Check for overrides on the command line
   preferences.parseCommandLine(argc,argv);
 
-  /// Open Database and initialize all sources.
-  if (!init_sources())
-    return false;
+  trace_startup("instance and preferences");
 
-  /// Everything opened succesfully... now create the GUI
-  player = new GMAudioPlayer(application,this,ID_AUDIO_PLAYER);
+  /// Open the database in the background
+  database = new GMTrackDatabase;
+  database->setSortKeywords(preferences.gui_sort_keywords);
+  GMDatabaseOpener opener(database,getDatabaseFilename());
+  opener.start();
 
-  /// Open Audio Device if needed.
+  /// Meanwhile start the audio engine
+  player = new GMAudioPlayer(application,this,ID_AUDIO_PLAYER);
   player->init();
   player->loadSettings();
 
@@ -735,6 +803,25 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
   if (preferences.play_crossfade)
     player->setCrossFade(preferences.play_crossfade_duration);
 
+  trace_startup("audio engine");
+
+  /// and load the icon theme
+  GMIconTheme * icontheme = new GMIconTheme(application);
+  icontheme->load();
+
+  trace_startup("icon theme");
+
+  opener.join();
+  if (startup_trace) fxmessage("[startup] %-24s %8.1f ms\n","database (background)",opener.time()/1000000.0);
+  trace_startup("database wait");
+
+  /// Finish or upgrade the database and initialize all sources.
+  if (!init_database(database) || !init_sources()) {
+    player->exit();
+    return false;
+    }
+
+  trace_startup("sources");
 
   /// Receive events from fifo
   if (fifo.isOpen()) {
@@ -744,8 +831,11 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
   FXString url = get_cmdline_url(argc,argv);
 
   /// Show user interface
+  startup=true;
   init_window(url.empty());
 
+  trace_startup("window");
+
 #ifdef HAVE_DBUS
   if (sessionbus) {
     /// Integrate Dbus into FOX Event Loop
@@ -754,10 +844,8 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
 #endif
 
   /// Start Services
-  scrobbler    = new GMAudioScrobbler(this,ID_SCROBBLER);
 #ifdef HAVE_DBUS
   if (sessionbus) {
-    notifydaemon = new GMNotifyDaemon(sessionbus);
 
     // KDE5 comes with mpris plugin on the toolbar, no need for
     // tray icon
@@ -770,8 +858,6 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
     gsd->GrabMediaPlayerKeys("gogglesmm");
 
     update_mpris();
-
-    notifydaemon->init();
     }
 #endif
 
@@ -790,15 +876,78 @@ FXint GMPlayerManager::run(int& argc,char** argv) {
 #endif
 
   // Update Podcasts on startup if desired.
-  if (get_cmdline_update_podcasts(argc,argv))
-    cmd_update_podcasts();
+  startup_podcasts = get_cmdline_update_podcasts(argc,argv);
 
+  /// Start the remaining services once the window has been drawn
+  application->addChore(this,ID_STARTUP);
+
+  trace_startup("services");
 
   /// Run the application
   return application->run();
   }
 
 
+long GMPlayerManager::onStartup(FXObject*,FXSelector,void*){
+  init_deferred();
+  return 1;
+  }
+
+
+/*
+  Services that are not needed to show the main window.
+*/
+void GMPlayerManager::init_deferred() {
+  if (!startup)
+    return;
+
+  startup=false;
+  application->removeChore(this,ID_STARTUP);
+
+  scrobbler = new GMAudioScrobbler(this,ID_SCROBBLER);
+
+#ifdef HAVE_DBUS
+  if (sessionbus) {
+    notifydaemon = new GMNotifyDaemon(sessionbus);
+    notifydaemon->init();
+    }
+#endif
+
+  // Album covers for the album browser
+  getTrackView()->loadCovers();
+
+  if (startup_podcasts)
+    cmd_update_podcasts();
+
+  trace_startup("deferred services");
+  }
+
+
+/*
+  Play counts are written in batches, either a little while after the last
+  track finished or once running tasks release the database.
+*/
+void GMPlayerManager::schedule_sync_played() {
+  if (!application->hasTimeout(this,ID_SYNC_PLAYED))
+    application->addTimeout(this,ID_SYNC_PLAYED,30_s);
+  }
+
+
+long GMPlayerManager::onSyncPlayed(FXObject*,FXSelector,void*){
+  application->removeTimeout(this,ID_SYNC_PLAYED);
+  application->removeChore(this,ID_SYNC_PLAYED);
+  if (!database->syncTrackPlayed())
+    schedule_sync_played();
+  return 1;
+  }
+
+
+GMAudioScrobbler * GMPlayerManager::getAudioScrobbler() {
+  init_deferred();
+  return scrobbler;
+  }
+
+
 void GMPlayerManager::exit() {
 
   player->saveSettings();
@@ -817,6 +966,10 @@ void GMPlayerManager::exit() {
 
   application->removeTimeout(this,GMPlayerManager::ID_TASKMANAGER_SHUTDOWN);
 
+  application->removeTimeout(this,GMPlayerManager::ID_SYNC_PLAYED);
+
+  application->removeChore(this,GMPlayerManager::ID_SYNC_PLAYED);
+
   application->removeTimeout(source,GMSource::ID_TRACK_PLAYED);
 
   preferences.save(application->reg());
@@ -824,6 +977,9 @@ void GMPlayerManager::exit() {
   if (scrobbler) scrobbler->shutdown();
   if (taskmanager) taskmanager->shutdown();
 
+  /// Write pending play counts
+  database->syncTrackPlayed(true);
+
 #ifdef HAVE_DBUS
   if (sessionbus) {
 
@@ -1025,6 +1181,7 @@ void GMPlayerManager::playItem(FXuint whence) {
   if (source) {
     trackinfoset = source->getTrack(trackinfo);
     player->open(trackinfo.url,true);
+    if (source==queue) prefetch_queue();
     }
   else {
     player->stop();
@@ -1181,6 +1338,28 @@ void GMPlayerManager::notify_playback_finished() {
     trackinfoset = source->getTrack(trackinfo);
     }
   player->open(trackinfo.url,false);
+  if (source==queue) prefetch_queue();
+  }
+
+
+void GMPlayerManager::prefetch_queue() {
+  FXIntList tracks;
+  FXStringList filenames;
+  if (queue) {
+    queue->getUpcoming(tracks,4);
+    try {
+      database->getTrackFilenames(tracks,filenames);
+      }
+    catch(GMDatabaseException & e){
+      return;
+      }
+    for (FXint i=0;i<filenames.no();i++) {
+      if (gm_is_local_file(filenames[i]))
+        player->prefetch(filenames[i]);
+      }
+    if (filenames.no() && preferences.gui_show_playing_albumcover)
+      covermanager->prefetch(filenames[0]);
+    }
   }
 
 FXbool GMPlayerManager::playing() const {
@@ -1227,12 +1406,26 @@ void GMPlayerManager::setStatus(const FXString & text){
   mainwindow->statusbar->getStatusLine()->setNormalText(text);
   }
 
+void GMPlayerManager::load_cover() {
+  GMCoverCache * cache = nullptr;
+  FXint artist,album=-1;
+
+  // Use the album browser cover while loading
+  if (dynamic_cast<GMDatabaseSource*>(source) && source->getCurrentTrack()!=-1) {
+    cache = source->getCoverCache();
+    if (cache && !database->getTrackAssociation(source->getCurrentTrack(),artist,album))
+      cache = nullptr;
+    }
+  covermanager->load(trackinfo.url,cache,album);
+  }
+
+
 void GMPlayerManager::update_cover_display() {
   if (playing()) {
 
     if (preferences.gui_show_playing_albumcover && covermanager->getCover()==nullptr) {
 
-      covermanager->load(trackinfo.url);
+      load_cover();
 
       mainwindow->update_meta_display();
 
@@ -1281,7 +1474,7 @@ void GMPlayerManager::update_track_display(FXbool notify) {
     }
 
   if (preferences.gui_show_playing_albumcover)
-    covermanager->load(trackinfo.url);
+    load_cover();
 
   mainwindow->display(trackinfo);
 
@@ -1429,6 +1622,38 @@ long GMPlayerManager::onImportTaskCompleted(FXObject*,FXSelector sel,void*ptr){
   }
 
 
+long GMPlayerManager::onSnapshotTaskCompleted(FXObject*,FXSelector sel,void*ptr){
+  GMTask * task = *static_cast<GMTask**>(ptr);
+  const FXbool restore = dynamic_cast<GMImportSnapshotTask*>(task)!=nullptr;
+  if (FXSELTYPE(sel)==SEL_TASK_COMPLETED) {
+    if (restore) {
+      FXIntList playlists;
+      database->initPathLookup();
+      database->initArtistLookup();
+
+      // Playlists were replaced as well
+      removePlayListSources();
+      if (database->listPlaylists(playlists)) {
+        for (FXint i=0;i<playlists.no();i++) {
+          insertSource(new GMPlayListSource(database,playlists[i]));
+          }
+        }
+      getDatabaseSource()->updateCovers();
+      getSourceView()->refresh();
+      getTrackView()->refresh();
+      }
+    }
+  else if (!task->cancelled()) {
+    if (restore)
+      show_message(fxtr("Restore Library"),fxtr("Unable to restore the music library from the selected file."));
+    else
+      show_message(fxtr("Backup Library"),fxtr("Unable to write the music library backup."));
+    }
+  delete task;
+  return 0;
+  }
+
+
 
 void GMPlayerManager::runTask(GMTask * task) {
   application->removeTimeout(this,GMPlayerManager::ID_TASKMANAGER_SHUTDOWN);
@@ -1439,6 +1664,8 @@ long GMPlayerManager::onTaskManagerIdle(FXObject*,FXSelector,void*){
   mainwindow->setStatus(FXString::null);
   GM_DEBUG_PRINT("Schedule taskmanager shutdown in 30s\n");
   application->addTimeout(this,GMPlayerManager::ID_TASKMANAGER_SHUTDOWN,30_s);
+  if (database->hasTrackPlayed())
+    application->addChore(this,GMPlayerManager::ID_SYNC_PLAYED);
   return 0;
   }
 
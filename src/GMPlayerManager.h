@@ -130,6 +130,7 @@ protected:
   GMCoverManager       * covermanager = nullptr;
   GMTrack                trackinfo;
   FXbool                 trackinfoset = false;
+  FXbool                 startup      = false;  // deferred startup pending
 protected:
   FXbool hasSourceWithKey(const FXString & key) const;
   void cleanSourceSettings();
@@ -153,10 +154,14 @@ public:
 #endif
     ID_AUDIO_PLAYER,
     ID_IMPORT_TASK,
+    ID_SNAPSHOT_TASK,
     ID_CANCEL_TASK,
     ID_TASKMANAGER,
     ID_TASKMANAGER_SHUTDOWN,
     ID_SESSION_MANAGER,
+    ID_COVER_MANAGER,
+    ID_STARTUP,
+    ID_SYNC_PLAYED,
     ID_CHILD
     };
 public:
@@ -167,12 +172,16 @@ public:
   long onCmdCloseRemote(FXObject*,FXSelector,void*);
   long onCmdCloseWindow(FXObject*,FXSelector,void*);
   long onPlayNotify(FXObject*,FXSelector,void*);
+  long onCoverLoaded(FXObject*,FXSelector,void*);
+  long onStartup(FXObject*,FXSelector,void*);
+  long onSyncPlayed(FXObject*,FXSelector,void*);
   long onCmdChild(FXObject*,FXSelector,void*);
   long onScrobblerError(FXObject*,FXSelector,void*);
   long onScrobblerOpen(FXObject*,FXSelector,void*);
 
 
   long onImportTaskCompleted(FXObject*,FXSelector,void*);
+  long onSnapshotTaskCompleted(FXObject*,FXSelector,void*);
   long onTaskManagerRunning(FXObject*,FXSelector,void*);
   long onTaskManagerStatus(FXObject*,FXSelector,void*);
   long onTaskManagerIdle(FXObject*,FXSelector,void*);
@@ -196,6 +205,7 @@ protected:
   FXbool init_sources();
   void   init_window(FXbool wizard);
   void   init_configuration();
+  void   init_deferred();
 #ifdef HAVE_DBUS
   FXbool init_dbus(int & argc,char**argv);
 #endif
@@ -251,7 +261,10 @@ public:
 
   GMPreferences & getPreferences() { return preferences; }
 
-  GMAudioScrobbler * getAudioScrobbler() { return scrobbler; }
+  GMAudioScrobbler * getAudioScrobbler();
+
+  /// Return true until the deferred services have started
+  FXbool isStarting() const { return startup; }
 
   GMTrayIcon * getTrayIcon() { return trayicon; }
 
@@ -309,8 +322,14 @@ public:
 
   void notify_playback_finished();
 
+  void prefetch_queue();
+
+  void schedule_sync_played();
+
   void reset_track_display();
 
+  void load_cover();
+
   void update_cover_display();
 
   void update_track_display(FXbool notify=true);
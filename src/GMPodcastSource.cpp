@@ -507,7 +507,7 @@ public:
 
       GM_DEBUG_PRINT("[rss] media.mime %s\n",media.mime.text());
       if (gm_is_feed(media.mime)) {
-        if (rss.parse(client.body(),media.parameters["charset"]))
+        if (rss.parse(client,media.parameters["charset"]))
           return 0;
         else
           return 1;
@@ -544,249 +544,490 @@ FXIMPLEMENT(GMImportPodcast,GMWorker,GMImportPodcastMap,ARRAYNUMBER(GMImportPodc
 
 /*--------------------------------------------------------------------------------------------*/
 
+/*
+  Podcast Downloader
+
+    - Queued items are downloaded by a small pool of download slots. The main thread
+      owns the database and is the only one that adds jobs to the pending list.
+    - Downloads go into a "<file>.part" file which is renamed on completion. An existing
+      .part file is resumed using a Range request, validated by If-Range with the ETag
+      or Last-Modified the server sent for it, stored in "<file>.part.validator".
+    - The number of parallel downloads per host and an optional total bandwidth limit
+      are read from the "podcast" registry section.
+*/
+
+struct GMDownloadJob {
+  FXint    id     = 0;
+  FXint    length = 0;
+  FXString url;
+  FXString host;
+  FXString localdir;
+  FXString local;
+  };
+
+struct GMDownloadProgress {
+  FXint id;
+  FXint pct;
+  };
+
+
+class GMPodcastDownloader;
 
-class GMDownloader : public GMWorker {
-FXDECLARE(GMDownloader)
+class GMDownloadSlot : public FXThread {
+protected:
+  GMPodcastDownloader * downloader;
+protected:
+  FXbool download(GMDownloadJob * job,const FXString & filename);
+  void   transfer(GMDownloadJob * job);
+private:
+  GMDownloadSlot(const GMDownloadSlot&);
+  GMDownloadSlot &operator=(const GMDownloadSlot&);
+public:
+  GMDownloadSlot(GMPodcastDownloader * d) : downloader(d) {}
+  FXint run() override;
+  };
+
+
+class GMPodcastDownloader : public FXObject {
+friend class GMDownloadSlot;
+FXDECLARE(GMPodcastDownloader)
+protected:
+  FXMutex                 mutex;
+  FXCondition             condition;
+  FXMessageChannel        channel;
+  FXArray<GMDownloadJob*> pending;
+  FXArray<GMDownloadJob*> active;
+  FXArray<GMDownloadJob*> completed;   // finished by the slots, not yet handled by the main thread
+  FXArray<GMDownloadSlot*> slots;
+  FXint                   maxhost   = 2;
+  FXlong                  ratelimit = 0;
+  volatile FXbool         processing = true;
+
+  GMPodcastSource* src = nullptr;
+  GMTrackDatabase* db  = nullptr;
+protected:
+  GMPodcastDownloader(){}
+private:
+  GMPodcastDownloader(const GMPodcastDownloader&);
+  GMPodcastDownloader &operator=(const GMPodcastDownloader&);
 protected:
-  FXbool download(const FXString & url,const FXString & filename,FXbool resume=true) {
-    HttpClient http;
-    HttpContentRange range;
-    FXFile     file;
-    FXString   headers;
-    FXuint     mode   = FXIO::Writing;
-    FXlong     offset = 0;
-
-    if (FXStat::exists(filename) && resume) {
-      GM_DEBUG_PRINT("[download] file %s exists trying resume\n",filename.text());
-      mode    = FXIO::ReadWrite|FXIO::Append;
-      offset  = FXStat::size(filename);
-      if (offset>0) {
-        // shutup compiler warnings and just pass string to bytes value
-        headers = FXString::value("Range: bytes=%s-\r\nIf-Range: %s\r\n",FXString::value(offset).text(),gm_rfc1123(FXStat::modified(filename)).text());
-        /// %lld for FOX is FXlong on 32bit and 64bit so ignore any formating warnings.
-        //headers = FXString::value("Range: bytes=%lld-\r\nIf-Range: %s\r\n",offset,gm_rfc1123(FXStat::modified(filename)).text());
-        GM_DEBUG_PRINT("%s\n",headers.text());
+  FXbool is_scheduled(FXint id) const {
+    for (FXint i=0;i<pending.no();i++) if (pending[i]->id==id) return true;
+    for (FXint i=0;i<active.no();i++) if (active[i]->id==id) return true;
+    for (FXint i=0;i<completed.no();i++) if (completed[i]->id==id) return true;
+    return false;
+    }
+
+  FXint count_host(const FXString & host) const {
+    FXint n=0;
+    for (FXint i=0;i<active.no();i++) if (active[i]->host==host) n++;
+    return n;
+    }
+
+  // Called by the slots. Returns next job or nullptr when shutting down.
+  GMDownloadJob * next() {
+    FXScopedMutex lock(mutex);
+    while(processing) {
+      for (FXint i=0;i<pending.no();i++) {
+        if (count_host(pending[i]->host)<maxhost) {
+          GMDownloadJob * job = pending[i];
+          pending.erase(i);
+          active.append(job);
+          return job;
+          }
         }
+      condition.wait(mutex);
       }
+    return nullptr;
+    }
 
-    if (!file.open(filename,mode)){
-      GM_DEBUG_PRINT("[download] failed to open local file\n");
-      return false;
+  // Called by the slots. Hands job back to the main thread. The job is kept in
+  // completed rather than sent through the channel, so it can't get lost when
+  // the downloader is deleted with messages still pending.
+  void finished(GMDownloadJob * job) {
+    mutex.lock();
+    for (FXint i=0;i<active.no();i++) {
+      if (active[i]==job) { active.erase(i); break; }
       }
+    completed.append(job);
+    condition.broadcast();
+    mutex.unlock();
+    channel.message(this,FXSEL(SEL_COMMAND,ID_DOWNLOAD_COMPLETE));
+    }
 
-    if (!http.basic("GET",url,headers)) {
-      GM_DEBUG_PRINT("[download] failed to connect %s\n",url.text());
-      return false;
-      }
+  void progress(FXint id,FXint pct) {
+    GMDownloadProgress p = {id,pct};
+    channel.message(this,FXSEL(SEL_COMMAND,ID_DOWNLOAD_PROGRESS),&p,sizeof(GMDownloadProgress));
+    }
 
-    if (http.status.code == HTTP_PARTIAL_CONTENT) {
+  // Bytes per second each active download may use, 0 means unlimited
+  FXlong rate() {
+    if (ratelimit>0) {
+      FXScopedMutex lock(mutex);
+      return ratelimit / FXMAX(1,active.no());
+      }
+    return 0;
+    }
 
-      if (!http.getContentRange(range)) {
-        GM_DEBUG_PRINT("[download] failed to parse content range header\n");
-        return false;
+  void update_item(FXint id,FXuint add,FXuint remove,FXint pct) {
+    GMTrackView * view = GMPlayerManager::instance()->getTrackView();
+    if (view->getSource()==src) {
+      FXint item = view->findTrackIndexById(id);
+      if (item>=0) {
+        GMFeedItem * feeditem = static_cast<GMFeedItem*>(view->getTrackItem(item));
+        feeditem->setFlags((feeditem->getFlags()&~remove)|add);
+        feeditem->setProgress(pct);
+        view->updateTrackItem(item);
         }
-
-      // FIXME make sure range is what we requested...
-      GM_DEBUG_PRINT("[download] http partial content %lld-%lld of %lld\n",range.first,range.last,range.length);
       }
-    else if (http.status.code == HTTP_REQUESTED_RANGE_NOT_SATISFIABLE) {
-      GM_DEBUG_PRINT("[download] http invalid range. retrying full content\n");
-      http.discard();
-      if (!http.basic("GET",url) || http.status.code!=HTTP_OK)
-        return false;
-      file.truncate(0);
+    }
+
+  void shutdown() {
+    mutex.lock();
+    processing=false;
+    condition.broadcast();
+    mutex.unlock();
+    for (FXint i=0;i<slots.no();i++) {
+      slots[i]->join();
+      delete slots[i];
       }
-    else if (http.status.code == HTTP_OK) {
-      GM_DEBUG_PRINT("[download] get full content\n");
-      file.truncate(0);
+    slots.clear();
+    }
+public:
+  enum {
+    ID_DOWNLOAD_COMPLETE = 1,
+    ID_DOWNLOAD_PROGRESS,
+    };
+public:
+  GMPodcastDownloader(FXApp*app,GMPodcastSource * s) : channel(app), src(s), db(s->db) {
+    maxhost   = FXMAX(1,GMApp::instance()->reg().readIntEntry(src->settingKey(),"download-host-slots",2));
+    ratelimit = FXMAX(0,GMApp::instance()->reg().readLongEntry(src->settingKey(),"download-rate-limit",0)) * 1024;
+    FXint nslots = FXCLAMP(1,GMApp::instance()->reg().readIntEntry(src->settingKey(),"download-slots",3),16);
+    for (FXint i=0;i<nslots;i++)
+      slots.append(new GMDownloadSlot(this));
+    schedule();
+    }
+
+  // Add any newly queued items to the pending list.
+  void schedule() {
+    GMQuery queued(db,"SELECT feed_items.id, feed_items.url,feeds.local FROM feed_items,feeds WHERE feeds.id == feed_items.feed AND flags&1 ORDER BY feed_items.date;");
+    FXScopedMutex lock(mutex);
+    while(queued.row()) {
+      FXint id;
+      queued.get(0,id);
+      if (!is_scheduled(id)) {
+        GMDownloadJob * job = new GMDownloadJob;
+        job->id = id;
+        queued.get(1,job->url);
+        queued.get(2,job->localdir);
+        job->host = FXURL::host(job->url);
+        pending.append(job);
+        }
       }
-    else {
-      GM_DEBUG_PRINT("[download] http failed %d\n",http.status.code);
-      return false;
+    condition.broadcast();
+    }
+
+  void start() {
+    const FXbool empty = (pending.no()==0);
+
+    for (FXint i=0;i<slots.no();i++)
+      slots[i]->start();
+
+    // Nothing to do. Let the main thread clean up
+    if (empty) {
+      channel.message(this,FXSEL(SEL_COMMAND,ID_DOWNLOAD_COMPLETE));
       }
+    }
 
-    /// Actual transfer
-    FXuchar buffer[4096];
-    FXlong  n,nbytes=0,ntotal=0,ncontent=http.getContentLength();
-    //FXTime  timestamp,last = FXThread::time();
-    //const FXlong seconds   = 1000000000;
-    //const FXlong msample   = 100000000;
-    //const FXlong kilobytes = 1024;
-
-    while((n=http.readBody(buffer,4096))>0 && processing) {
-      nbytes+=n;
-      ntotal+=n;
-
-      /* calculate transfer speed
-      timestamp = FXThread::time();
-      if (timestamp-last>msample) {
-        FXuint kbps = (nbytes * seconds ) / (kilobytes*(timestamp-last));
-        FXuint pct = (FXuint)(((double)ntotal/(double)ncontent) * 100.0);
-        nbytes=0;
-        last=timestamp;
-        }
-      */
+  void stop() {
+    processing=false;
+    }
 
-      /* Write and check out of disk space */
-      if (file.writeBlock(buffer,n)<n) {
-        GM_DEBUG_PRINT("[download] disk write error\n");
-        return false;
+  long onDownloadProgress(FXObject*,FXSelector,void*ptr) {
+    const GMDownloadProgress * p = static_cast<const GMDownloadProgress*>(ptr);
+    update_item(p->id,0,0,p->pct);
+    return 1;
+    }
+
+  long onDownloadComplete(FXObject*,FXSelector,void*) {
+    FXArray<GMDownloadJob*> jobs;
+
+    mutex.lock();
+    jobs.adopt(completed);
+    mutex.unlock();
+
+    for (FXint i=0;i<jobs.no();i++) {
+      GMDownloadJob * job = jobs[i];
+      if (processing) {
+        GMQuery update_feed(db,"UPDATE feed_items SET local = ?, time = CASE WHEN time != 0 THEN time ELSE ? END, flags = ((flags&~(1<<?))|(1<<?)) WHERE id == ?;");
+        update_feed.set(0,job->local);
+        update_feed.set(1,job->length);
+        update_feed.set(2,ITEM_FLAG_QUEUE);
+        if (!job->local.empty())
+          update_feed.set(3,ITEM_FLAG_LOCAL);
+        else
+          update_feed.set(3,ITEM_FLAG_DOWNLOAD_FAILED);
+        update_feed.set(4,job->id);
+        update_feed.execute();
+
+        if (!job->local.empty())
+          update_item(job->id,ITEM_LOCAL,ITEM_QUEUE,-1);
+        else
+          update_item(job->id,ITEM_FAILED,ITEM_QUEUE,-1);
         }
+      delete job;
       }
-    file.close();
 
-    /// Set the modtime
-    FXTime modtime=0;
-    if (gm_parse_datetime(http.getHeader("last-modified"),modtime) && modtime!=0) {
-      GM_DEBUG_PRINT("[download] Set Modified to \"%s\"\n",http.getHeader("last-modified").text());
-      FXStat::modified(filename,modtime);
-      }
+    if (processing) schedule();
 
-    /// Check for partial content
-    if (ncontent!=-1 && ncontent<ntotal){
-      GM_DEBUG_PRINT("[download] Incomplete %ld / %ld\n",ncontent,ntotal);
-      return false;
-      }
+    mutex.lock();
+    FXbool done = (pending.no()==0 && active.no()==0 && completed.no()==0) || !processing;
+    mutex.unlock();
 
-    if (ncontent!=-1)
-      GM_DEBUG_PRINT("[download] Finished %ld / %ld\n",ncontent,ntotal);
-    else
-      GM_DEBUG_PRINT("[download] Finished %ld\n",ncontent);
+    if (done && src->downloader==this) {
+      shutdown();
+      src->downloader = nullptr;
+      delete this;
+      }
+    return 1;
+    }
 
-    return true;
+  virtual ~GMPodcastDownloader() {
+    shutdown();
+    for (FXint i=0;i<pending.no();i++) delete pending[i];
+    for (FXint i=0;i<active.no();i++) delete active[i];
+    for (FXint i=0;i<completed.no();i++) delete completed[i];
     }
+  };
 
-  GMDownloader(){}
-  GMDownloader(FXApp*app) : GMWorker(app) {}
+FXDEFMAP(GMPodcastDownloader) GMPodcastDownloaderMap[]={
+  FXMAPFUNC(SEL_COMMAND,GMPodcastDownloader::ID_DOWNLOAD_COMPLETE,GMPodcastDownloader::onDownloadComplete),
+  FXMAPFUNC(SEL_COMMAND,GMPodcastDownloader::ID_DOWNLOAD_PROGRESS,GMPodcastDownloader::onDownloadProgress),
   };
+FXIMPLEMENT(GMPodcastDownloader,FXObject,GMPodcastDownloaderMap,ARRAYNUMBER(GMPodcastDownloaderMap));
+
 
-FXIMPLEMENT(GMDownloader,GMWorker,nullptr,0);
 
+FXint GMDownloadSlot::run() {
+  ap_set_thread_name("gm_download");
+  GMDownloadJob * job;
+  while((job=downloader->next())!=nullptr) {
+    transfer(job);
+    downloader->finished(job);
+    }
+  return 0;
+  }
 
 
+void GMDownloadSlot::transfer(GMDownloadJob * job) {
+  const FXString directory = GMApp::getPodcastDirectory()+PATHSEPSTRING+job->localdir;
+  const FXString local     = FXPath::name(FXURL::path(job->url));
+  const FXString filename  = directory+PATHSEPSTRING+local;
 
+  FXDir::createDirectories(directory);
 
-class GMPodcastDownloader : public GMDownloader {
-FXDECLARE(GMPodcastDownloader)
-protected:
-  FXMutex          mutex;
-  FXCondition      condition;
+  // Files from older versions were downloaded in place. Resume them as partial download.
+  if (FXStat::exists(filename) && !FXStat::exists(filename+".part"))
+    FXFile::rename(filename,filename+".part");
 
-  FXint            length = 0;
-  FXint            id     = 0;
-  FXString         url;
-  FXString         local;
-  FXString         localdir;
+  if (download(job,filename+".part") && FXFile::rename(filename+".part",filename)) {
+    job->local = local;
 
-  GMPodcastSource* src = nullptr;
-  GMTrackDatabase* db  = nullptr;
-protected:
-  GMPodcastDownloader(){}
-public:
-  enum {
-    ID_DOWNLOAD_COMPLETE = GMWorker::ID_LAST
-    };
-public:
-  GMPodcastDownloader(FXApp*app,GMPodcastSource * s) : GMDownloader(app),src(s), db(s->db) {
-    next_task();
+    // Get duration from file
+    GMFileTag tags;
+    if (tags.open(filename,FILETAG_AUDIOPROPERTIES)){
+      job->length = tags.getTime();
+      }
     }
+  }
 
-  void next_task() {
-    GMQuery next_download(db,"SELECT feed_items.id, feed_items.url,feeds.local FROM feed_items,feeds WHERE feeds.id == feed_items.feed AND flags&1 ORDER BY feed_items.date LIMIT 1;");
-    id=0;
-    url.clear();
-    local.clear();
-    if (next_download.row()) {
-      next_download.get(0,id);
-      next_download.get(1,url);
-      next_download.get(2,localdir);
+
+/*
+  Validator of the server's copy for If-Range. Weak entity tags can't be
+  used for range requests, so fall back to the modification date.
+*/
+static FXString download_validator(HttpClient & http) {
+  FXString etag = http.getHeader("etag");
+  if (!etag.empty() && FXString::compare(etag,"W/",2)!=0)
+    return etag;
+  return http.getHeader("last-modified");
+  }
+
+
+FXbool GMDownloadSlot::download(GMDownloadJob * job,const FXString & filename) {
+  HttpClient http;
+  HttpContentRange range;
+  FXFile     file;
+  FXString   headers;
+  FXString   validator;
+  FXuint     mode   = FXIO::Writing;
+  FXlong     offset = 0;
+
+  // Server validator of the partial download is kept next to it
+  const FXString validatorfile = filename + ".validator";
+
+  if (FXStat::exists(filename)) {
+    GM_DEBUG_PRINT("[download] file %s exists trying resume\n",filename.text());
+    mode    = FXIO::ReadWrite|FXIO::Append;
+    offset  = FXStat::size(filename);
+
+    // Without a validator we can't tell if the server's copy changed, so download it again
+    if (offset>0 && gm_buffer_file(validatorfile,validator) && !validator.empty()) {
+      // shutup compiler warnings and just pass string to bytes value
+      headers = FXString::value("Range: bytes=%s-\r\nIf-Range: %s\r\n",FXString::value(offset).text(),validator.text());
+      GM_DEBUG_PRINT("%s\n",headers.text());
       }
     }
 
-  long onDownloadComplete(FXObject*,FXSelector,void*) {
-    mutex.lock();
+  if (!file.open(filename,mode)){
+    GM_DEBUG_PRINT("[download] failed to open local file\n");
+    return false;
+    }
 
-    GMQuery update_feed(db,"UPDATE feed_items SET local = ?, time = CASE WHEN time != 0 THEN time ELSE ? END, flags = ((flags&~(1<<?))|(1<<?)) WHERE id == ?;");
+  if (!http.basic("GET",job->url,headers)) {
+    GM_DEBUG_PRINT("[download] failed to connect %s\n",job->url.text());
+    return false;
+    }
 
-    update_feed.set(0,local);
-    update_feed.set(1,length);
-    update_feed.set(2,ITEM_FLAG_QUEUE);
-    if (!local.empty())
-      update_feed.set(3,ITEM_FLAG_LOCAL);
-    else
-      update_feed.set(3,ITEM_FLAG_DOWNLOAD_FAILED);
+  if (http.status.code == HTTP_PARTIAL_CONTENT) {
 
-    update_feed.set(4,id);
-    update_feed.execute();
+    if (!http.getContentRange(range)) {
+      GM_DEBUG_PRINT("[download] failed to parse content range header\n");
+      return false;
+      }
 
-    GMTrackView * view = GMPlayerManager::instance()->getTrackView();
-    if (view->getSource()==src) {
-      FXint item = view->findTrackIndexById(id);
-      if (item>=0) {
-        GMFeedItem * feeditem = static_cast<GMFeedItem*>(view->getTrackItem(item));
-        FXuint f = feeditem->getFlags();
-        f&=~(1<<ITEM_FLAG_QUEUE);
-        if (!local.empty())
-          f|=(1<<ITEM_FLAG_LOCAL);
-        else
-          f|=(1<<ITEM_FLAG_DOWNLOAD_FAILED);
-        feeditem->setFlags(f);
-        view->updateTrackItem(item);
-        }
+    if (range.first!=offset) {
+      GM_DEBUG_PRINT("[download] unexpected range %lld-%lld. retrying full content\n",range.first,range.last);
+      http.discard();
+      if (!http.basic("GET",job->url) || http.status.code!=HTTP_OK)
+        return false;
+      file.truncate(0);
+      offset=0;
       }
-    next_task();
-    condition.signal();
-    mutex.unlock();
-    return 1;
+    GM_DEBUG_PRINT("[download] http partial content %lld-%lld of %lld\n",range.first,range.last,range.length);
     }
+  else if (http.status.code == HTTP_REQUESTED_RANGE_NOT_SATISFIABLE) {
 
-  long onThreadLeave(FXObject*,FXSelector,void*) {
-    FXint code=0;
-    if (thread->join(code) && code==0) {
+    // Already have everything
+    if (http.getContentRange(range) && range.length==offset) {
+      GM_DEBUG_PRINT("[download] already complete\n");
+      FXFile::remove(validatorfile);
+      return true;
       }
-    src->downloader = nullptr;
-    delete this;
-    return 1;
+
+    GM_DEBUG_PRINT("[download] http invalid range. retrying full content\n");
+    http.discard();
+    if (!http.basic("GET",job->url) || http.status.code!=HTTP_OK)
+      return false;
+    file.truncate(0);
+    offset=0;
+    }
+  else if (http.status.code == HTTP_OK) {
+    GM_DEBUG_PRINT("[download] get full content\n");
+    file.truncate(0);
+    offset=0;
+    }
+  else {
+    GM_DEBUG_PRINT("[download] http failed %d\n",http.status.code);
+    return false;
     }
 
+  // Starting from scratch, remember what we're downloading for a later resume
+  if (offset==0) {
+    validator = download_validator(http);
+    if (validator.empty() || !gm_dump_file(validatorfile,validator))
+      FXFile::remove(validatorfile);
+    }
 
-  void downloadNext() {
-    local  = FXPath::name(FXURL::path(url));
-    length = 0;
-    FXDir::createDirectories(GMApp::getPodcastDirectory()+PATHSEPSTRING+localdir);
+  /// Actual transfer
+  const FXTime second     = 1000000000;
+  const FXTime interval   = 250000000;
 
-    // Download file
-    if (download(url,GMApp::getPodcastDirectory()+PATHSEPSTRING+localdir+PATHSEPSTRING+local,true)){
+  FXuchar buffer[16384];
+  FXlong  n,ntotal=0,ncontent=http.getContentLength();
+  FXlong  nwindow=0;
+  FXTime  start=FXThread::time(),last=start,now;
+  FXint   pct=-1;
 
-      // Get duration from file
-      GMFileTag tags;
-      if (tags.open(GMApp::getPodcastDirectory()+PATHSEPSTRING+localdir+PATHSEPSTRING+local,FILETAG_AUDIOPROPERTIES)){
-        length = tags.getTime();
-        }
+  while(downloader->processing && (n=http.readBody(buffer,sizeof(buffer)))>0) {
+    ntotal+=n;
+    nwindow+=n;
 
+    /* Write and check out of disk space */
+    if (file.writeBlock(buffer,n)<n) {
+      GM_DEBUG_PRINT("[download] disk write error\n");
+      return false;
       }
-    else {
-      local.clear();
+
+    now = FXThread::time();
+
+    /* Throttle to our share of the bandwidth */
+    const FXlong bps = downloader->rate();
+    if (bps>0) {
+      const FXTime expected = (nwindow*second) / bps;
+      if (expected>now-start) {
+        FXThread::sleep(expected-(now-start));
+        now = FXThread::time();
+        }
+      if (now-start>second) {
+        start=now;
+        nwindow=0;
+        }
+      }
+
+    /* Report progress */
+    if (ncontent>0 && now-last>interval) {
+      FXint p = (FXint)(((offset+ntotal)*100)/(offset+ncontent));
+      if (p!=pct) {
+        pct=p;
+        downloader->progress(job->id,pct);
+        }
+      last=now;
       }
     }
+  file.close();
 
-  FXint run() {
-    while(id && processing) {
-      downloadNext();
-      mutex.lock();
-      send(FXSEL(SEL_COMMAND,ID_DOWNLOAD_COMPLETE));
-      condition.wait(mutex);
-      mutex.unlock();
+  if (!downloader->processing)
+    return false;
+
+  /// Set the modtime
+  FXTime modtime=0;
+  if (gm_parse_datetime(http.getHeader("last-modified"),modtime) && modtime!=0) {
+    GM_DEBUG_PRINT("[download] Set Modified to \"%s\"\n",http.getHeader("last-modified").text());
+    FXStat::modified(filename,modtime);
+    }
+
+  /// Check for partial content
+  if (ncontent!=-1 && ntotal<ncontent){
+    GM_DEBUG_PRINT("[download] Incomplete %ld / %ld\n",ntotal,ncontent);
+    return false;
+    }
+
+  GM_DEBUG_PRINT("[download] Finished %ld\n",offset+ntotal);
+  FXFile::remove(validatorfile);
+  return true;
+  }
+
+
+/* Parses a feed while it is being downloaded and keeps a copy on disk */
+class GMFeedSink : public HttpSink {
+protected:
+  XmlParser & parser;
+  FXFile    & file;
+  FXbool      failed = false;   // local copy is incomplete
+public:
+  GMFeedSink(XmlParser & p,FXFile & f) : parser(p), file(f) {}
+
+  FXbool write(const FXchar * data,FXival len) override {
+    if (!failed && (!file.isOpen() || file.writeBlock(data,len)!=len)) {
+      failed=true;
+      file.close();
       }
-    return 0;
+    return parser.write(data,len);
     }
-  };
 
-FXDEFMAP(GMPodcastDownloader) GMPodcastDownloaderMap[]={
-  FXMAPFUNC(SEL_COMMAND,GMPodcastDownloader::ID_THREAD_LEAVE,GMPodcastDownloader::onThreadLeave),
-  FXMAPFUNC(SEL_COMMAND,GMPodcastDownloader::ID_DOWNLOAD_COMPLETE,GMPodcastDownloader::onDownloadComplete),
+  FXbool hasFailed() const { return failed; }
   };
-FXIMPLEMENT(GMPodcastDownloader,GMDownloader,GMPodcastDownloaderMap,ARRAYNUMBER(GMPodcastDownloaderMap));
 
 
 class GMPodcastUpdater : public GMTask {
@@ -916,6 +1157,11 @@ FXint GMPodcastUpdater::run() {
 
 
     while(all_feeds.row() && processing) {
+
+      // Feeds are fetched while holding the database, give way now and then
+      if (transaction.due())
+        transaction.checkpoint();
+
       all_feeds.get(0,id);
       all_feeds.get(1,url);
       all_feeds.get(2,feed_dir);
@@ -946,16 +1192,24 @@ FXint GMPodcastUpdater::run() {
         }
 
 
-      FXString feed = http.body();
-      RssParser rss;
+      const FXString feedfile = GMApp::getPodcastDirectory()+PATHSEPSTRING+feed_dir+PATHSEPSTRING"feed.rss";
+
+      RssParser  rss;
+      FXFile     file(feedfile+".part",FXIO::Writing);
+      GMFeedSink sink(rss,file);
 
-      if (rss.parse(feed,media.parameters["charset"])) {
+      const FXbool parsed = rss.open(media.parameters["charset"]) && http.body(sink) && rss.close();
+      file.close();
+
+      if (parsed) {
         if (rss.feed.date!=date) {
           GM_DEBUG_PRINT("[rss] feed needs updating %s - %s\n",FXSystem::universalTime(rss.feed.date).text(),FXSystem::localTime(rss.feed.date).text());
 
           rss.feed.trim();
 
-          gm_dump_file(GMApp::getPodcastDirectory()+PATHSEPSTRING+feed_dir+PATHSEPSTRING"feed.rss",feed);
+          // Keep the previous copy if ours is incomplete
+          if (!sink.hasFailed())
+            FXFile::rename(feedfile+".part",feedfile);
 
           GM_DEBUG_PRINT("%s - %s\n",url.text(),FXSystem::universalTime(date).text());
           if (!rss.feed.image.empty()) {
@@ -1024,6 +1278,7 @@ FXint GMPodcastUpdater::run() {
       else {
         GM_DEBUG_PRINT("[rss] failed to parse feed\n");
         }
+      FXFile::remove(feedfile+".part");
       }
     transaction.commit();
     }
@@ -1128,6 +1383,7 @@ GMPodcastSource::~GMPodcastSource(){
   GMApp::instance()->removeTimeout(this,ID_REFRESH_FEED);
   if (downloader) {
     downloader->stop();
+    delete downloader;
     }
   delete covercache;
   }
@@ -1496,6 +1752,9 @@ long GMPodcastSource::onCmdFeedUpdated(FXObject*,FXSelector,void*ptr){
       downloader->start();
       }
     }
+  else {
+    downloader->schedule();
+    }
 
   GMPlayerManager::instance()->getSourceView()->refresh(this);
   setLastUpdate();
@@ -1518,6 +1777,9 @@ long GMPodcastSource::onCmdDownloadFeed(FXObject*,FXSelector,void*){
       downloader = new GMPodcastDownloader(FXApp::instance(),this);
       downloader->start();
       }
+    else {
+      downloader->schedule();
+      }
     }
   catch(GMDatabaseException&) {
     }
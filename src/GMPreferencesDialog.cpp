@@ -31,6 +31,7 @@
 #include "GMTrackList.h"
 #include "GMList.h"
 #include "GMSource.h"
+#include "GMTrackDatabase.h"
 #include "GMPlayerManager.h"
 #include "GMWindow.h"
 #include "GMRemote.h"
@@ -657,6 +658,44 @@ GMPreferencesDialog::GMPreferencesDialog(FXWindow * p) : FXDialogBox(p,FXString:
 
   showDriverSettings(config.device);
 
+  new FXLabel(matrix,tr("Resampling:"),nullptr,labelstyle);
+  resampler = new GMListBox(matrix,nullptr,0,LISTBOX_NORMAL|LAYOUT_FILL_COLUMN);
+  resampler->appendItem(tr("Off"),nullptr,(void*)ResamplerOff);
+  resampler->appendItem(tr("Fast"),nullptr,(void*)ResamplerFast);
+  resampler->appendItem(tr("Medium"),nullptr,(void*)ResamplerMedium);
+  resampler->appendItem(tr("Best"),nullptr,(void*)ResamplerBest);
+  resampler->setNumVisible(4);
+  resampler->setCurrentItem(resampler->findItemByData((void*)(FXival)config.resampler));
+
+  new FXLabel(matrix,tr("Output rate:"),nullptr,labelstyle);
+  fixed_rate = new GMListBox(matrix,nullptr,0,LISTBOX_NORMAL|LAYOUT_FILL_COLUMN);
+  fixed_rate->appendItem(tr("Follow stream"),nullptr,(void*)0);
+  fixed_rate->appendItem("44100 Hz",nullptr,(void*)44100);
+  fixed_rate->appendItem("48000 Hz",nullptr,(void*)48000);
+  fixed_rate->appendItem("88200 Hz",nullptr,(void*)88200);
+  fixed_rate->appendItem("96000 Hz",nullptr,(void*)96000);
+  fixed_rate->appendItem("192000 Hz",nullptr,(void*)192000);
+  fixed_rate->setNumVisible(6);
+  if (fixed_rate->findItemByData((void*)(FXival)config.fixed_rate)==-1)
+    fixed_rate->appendItem(FXString::value("%u Hz",config.fixed_rate),nullptr,(void*)(FXival)config.fixed_rate);
+  fixed_rate->setCurrentItem(fixed_rate->findItemByData((void*)(FXival)config.fixed_rate));
+
+  new FXLabel(matrix,tr("Output format:"),nullptr,labelstyle);
+  fixed_format = new GMListBox(matrix,nullptr,0,LISTBOX_NORMAL|LAYOUT_FILL_COLUMN);
+  fixed_format->appendItem(tr("16 bit"),nullptr,(void*)FixedFormatS16);
+  fixed_format->appendItem(tr("32 bit"),nullptr,(void*)FixedFormatS32);
+  fixed_format->appendItem(tr("Float"),nullptr,(void*)FixedFormatFloat);
+  fixed_format->setNumVisible(3);
+  fixed_format->setCurrentItem(fixed_format->findItemByData((void*)(FXival)config.fixed_format));
+
+  new FXFrame(matrix,FRAME_NONE);
+  low_latency = new GMCheckButton(matrix,tr("Low latency"),nullptr,0,CHECKBUTTON_NORMAL|LAYOUT_FILL_COLUMN);
+  low_latency->setCheck((config.flags&OutputConfig::LowLatency)==OutputConfig::LowLatency);
+
+  new FXFrame(matrix,FRAME_NONE);
+  parallel_decode = new GMCheckButton(matrix,tr("Parallel decoding"),nullptr,0,CHECKBUTTON_NORMAL|LAYOUT_FILL_COLUMN);
+  parallel_decode->setCheck((config.flags&OutputConfig::ParallelDecode)==OutputConfig::ParallelDecode);
+
   new FXFrame(matrix,FRAME_NONE);
   new GMButton(matrix,tr("Apply Changes"),nullptr,this,ID_APPLY_AUDIO,BUTTON_NORMAL|LAYOUT_FILL_COLUMN);
 
@@ -836,6 +875,20 @@ long GMPreferencesDialog::onCmdApplyAudio(FXObject*,FXSelector,void*){
   config.oss.device = oss_device->getText();
   config.sndio.device = sndio_device->getText();
 
+  config.resampler = (FXuchar)(FXival)resampler->getItemData(resampler->getCurrentItem());
+  config.fixed_rate = (FXuint)(FXival)fixed_rate->getItemData(fixed_rate->getCurrentItem());
+  config.fixed_format = (FXuchar)(FXival)fixed_format->getItemData(fixed_format->getCurrentItem());
+
+  if (low_latency->getCheck())
+    config.flags|=OutputConfig::LowLatency;
+  else
+    config.flags&=~OutputConfig::LowLatency;
+
+  if (parallel_decode->getCheck())
+    config.flags|=OutputConfig::ParallelDecode;
+  else
+    config.flags&=~OutputConfig::ParallelDecode;
+
   GMPlayerManager::instance()->getPlayer()->setOutputConfig(config);
   return 1;
   }
@@ -891,6 +944,7 @@ long GMPreferencesDialog::onCmdAccept(FXObject*,FXSelector,void*) {
     }
 
   GMPlayerManager::instance()->getPreferences().setKeyWords(keywords);
+  GMPlayerManager::instance()->getTrackDatabase()->setSortKeywords(GMPlayerManager::instance()->getPreferences().gui_sort_keywords);
 
   if (!(selected==current)) {
     GMIconTheme::instance()->load();
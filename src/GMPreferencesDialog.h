@@ -48,6 +48,11 @@ protected:
 
   FXCheckButton* alsa_hardware_only = nullptr;
   FXFrame * alsa_hardware_only_frame = nullptr;
+  GMListBox    * resampler = nullptr;
+  GMListBox    * fixed_rate = nullptr;
+  GMListBox    * fixed_format = nullptr;
+  FXCheckButton* low_latency = nullptr;
+  FXCheckButton* parallel_decode = nullptr;
 
   FXLabel     * oss_device_label = nullptr;
   FXTextField * oss_device = nullptr;
@@ -260,7 +260,7 @@ void GMRemote::update_cover_display() {
     delete cover;
     cover=nullptr;
     }
-  cover = GMCover::copyToImage(GMPlayerManager::instance()->getCoverManager()->getCover(),coversize);
+  cover = GMPlayerManager::instance()->getCoverManager()->getImage(coversize);
   updateCover();
   }
 
@@ -116,9 +116,11 @@ void GMDBTracks::init(GMTrackDatabase*db,FXbool afg) {
 
   query_artist                        = database->compile("SELECT id FROM artists WHERE name == ?;");
   query_tag                           = database->compile("SELECT id FROM tags WHERE name == ?;");
+  query_track_album                   = database->compile("SELECT album FROM tracks WHERE id == ?;");
 
   delete_track_playlists              = database->compile("DELETE FROM playlist_tracks WHERE track == ?;");
   delete_track_tags                   = database->compile("DELETE FROM track_tags WHERE track == ?;");
+  delete_track_history                = database->compile("DELETE FROM play_history WHERE track == ?;");
   delete_track                        = database->compile("DELETE FROM tracks WHERE id == ?;");
 
   initPathDict(database);
@@ -141,6 +143,37 @@ FXint GMDBTracks::hasPath(const FXString & path) {
   }
 
 
+void GMDBTracks::touchAlbum(FXint album) {
+  // Tracks usually arrive grouped by album
+  if (album && (albums.no()==0 || albums[albums.no()-1]!=album))
+    albums.append(album);
+  }
+
+
+void GMDBTracks::touchTrackAlbum(FXint track) {
+  FXint album=0;
+  query_track_album.execute(track,album);
+  touchAlbum(album);
+  }
+
+
+void GMDBTracks::checkpoint_summary() {
+  FXIntList recent;
+  for (FXint i=nsynced;i<albums.no();i++)
+    recent.append(albums[i]);
+  database->sync_summary(recent);
+  nsynced=albums.no();
+  }
+
+
+// Album years are only fixed up at the end, so refresh every touched album again
+void GMDBTracks::sync_summary() {
+  database->sync_summary(albums);
+  albums.clear();
+  nsynced=0;
+  }
+
+
 FXint GMDBTracks::insertArtist(const FXString & artist){
   FXint id=0;
   if (!artist.empty()) {
@@ -266,6 +299,7 @@ void GMDBTracks::insert(GMTrack & track,FXint & path_index) {
     insert_track.set(15,track.lyrics);
 
     track.index = insert_track.insert();
+    touchAlbum(album_id);
 
     /// Tags
     if (track.tags.no())
@@ -290,6 +324,10 @@ void GMDBTracks::update(GMTrack & track) {
   FXint conductor_id    = insertArtist(track.conductor);
   FXint album_id        = insertAlbum(track,album_artist_id);
 
+  /// Old and new album both need a new summary
+  touchTrackAlbum(track.index);
+  touchAlbum(album_id);
+
   /// Update Tracks
 #if FOXVERSION < FXVERSION(1, 7, 83)
   update_track.set(0,track.title.empty() ? FXPath::title(track.url) : track.title);
@@ -318,8 +356,10 @@ void GMDBTracks::update(GMTrack & track) {
 
 
 void GMDBTracks::remove(FXint track) {
+  touchTrackAlbum(track);
   delete_track_playlists.update(track);
   delete_track_tags.update(track);
+  delete_track_history.update(track);
   delete_track.update(track);
   }
 
@@ -454,6 +494,7 @@ void GMImportTask::import() {
     import_tracks();
     }
   database->sync_album_year();
+  dbtracks.sync_summary();
   commit_transaction();
   }
 
@@ -639,9 +680,8 @@ void GMImportTask::import_tracks(FXint path_index) {
     // Store tracks into database
     for (FXint i=0;i<ntracks;i++) {
 
-      // Check for interrupts
-      if (database->interrupt) {
-        transaction->pause();
+      // Commit in batches and check for interrupts
+      if (checkpoint_transaction()) {
         dbtracks.playlist_queue = database->getNextQueue(dbtracks.playlist);
         }
 
@@ -755,6 +795,7 @@ void GMSyncTask::import_and_update(){
     database->sync_album_year();
     database->sync_tracks_removed();
     }
+  dbtracks.sync_summary();
   commit_transaction();
   }
 
@@ -784,8 +825,7 @@ void GMSyncTask::update() {
 
         for (FXint t=0;t<tracklist.no();t++) {
 
-          if (database->interrupt)
-            transaction->pause();
+          checkpoint_transaction();
 
           dbtracks.remove(tracklist[t].id);
           }
@@ -798,8 +838,7 @@ void GMSyncTask::update() {
 
         const FXString & name = tracklist[t].filename;
 
-        if (database->interrupt)
-          transaction->pause();
+        checkpoint_transaction();
 
         if (options.exclude_file.empty() || !FXPath::match(name,options.exclude_file,matchflags)) {
           if (FXStat::statFile(path+PATHSEPSTRING+name,data)) {
@@ -825,6 +864,7 @@ void GMSyncTask::update() {
     database->sync_album_year();
     database->sync_tracks_removed();
     }
+  dbtracks.sync_summary();
   commit_transaction();
 
   }
@@ -851,8 +891,7 @@ void GMSyncTask::remove_missing() {
       if (!options.exclude_folder.empty() && filter_path(options.exclude_folder,pathlist[p])){
         for (FXint t=0;t<tracklist.no() && processing;t++) {
 
-          if (database->interrupt)
-            transaction->pause();
+          checkpoint_transaction();
 
           dbtracks.remove(tracklist[t].id);
           }
@@ -864,8 +903,7 @@ void GMSyncTask::remove_missing() {
 
         const FXString & name = tracklist[t].filename;
 
-        if (database->interrupt)
-          transaction->pause();
+        checkpoint_transaction();
 
         if ((options_sync.remove_missing && !FXStat::exists(pathlist[p]+PATHSEPSTRING+name)) ||
             (!options.exclude_file.empty() && FXPath::match(name,options.exclude_file,matchflags))){
@@ -876,6 +914,7 @@ void GMSyncTask::remove_missing() {
       }
     }
   if (changed) database->sync_tracks_removed();
+  dbtracks.sync_summary();
   commit_transaction();
   }
 
@@ -989,10 +1028,8 @@ void GMSyncTask::update_tracks(FXint pathindex) {
     // Update Database
     for (FXint i=0;i<ntracks;i++) {
 
-      // Check for interrupts
-      if (database->interrupt) {
-        transaction->pause();
-        }
+      // Commit in batches and check for interrupts
+      checkpoint_transaction();
 
       // Update or Insert
       if (tracks[i].index){
@@ -1056,8 +1093,10 @@ void GMRemoveTask::remove(GMTaskTransaction & transaction) {
 
       for (FXint t=0;t<tracklist.no() && processing;t++) {
 
-        if (database->interrupt)
-          transaction.pause();
+        if (transaction.due()) {
+          dbtracks.checkpoint_summary();
+          transaction.checkpoint();
+          }
 
         dbtracks.remove(tracklist[t].id);
         changed=true;
@@ -1065,4 +1104,5 @@ void GMRemoveTask::remove(GMTaskTransaction & transaction) {
       }
     }
   if (changed) database->sync_tracks_removed();
+  dbtracks.sync_summary();
   }
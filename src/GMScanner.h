@@ -27,6 +27,8 @@ protected:
   GMTrackDatabase * database = nullptr;
 protected:
   FXDictionary pathdict;
+  FXIntList    albums;      // albums touched since last sync_summary
+  FXint        nsynced = 0; // albums already refreshed by checkpoint_summary
   FXbool   album_format_grouping = true;
 public:
   FXint    playlist       = 0;
@@ -47,8 +49,10 @@ protected:
   GMQuery query_album_by_year;
   GMQuery query_artist;
   GMQuery query_tag;
+  GMQuery query_track_album;
   GMQuery delete_track;
   GMQuery delete_track_tags;
+  GMQuery delete_track_history;
   GMQuery delete_track_playlists;
 protected:
   FXint insertPath(const FXString & path);
@@ -57,6 +61,8 @@ protected:
   void insertTags(FXint,const FXStringList&);
   void updateTags(FXint,const FXStringList&);
   void initPathDict(GMTrackDatabase*);
+  void touchAlbum(FXint album);
+  void touchTrackAlbum(FXint track);
 public:
   GMDBTracks();
 
@@ -78,6 +84,12 @@ public:
   // Update Track
   void update(GMTrack & track);
 
+  // Update summaries of albums touched since the last checkpoint. Keeps them for sync_summary.
+  void checkpoint_summary();
+
+  // Update summaries of all albums touched by insert, update or remove
+  void sync_summary();
+
   ~GMDBTracks(){}
   };
 
@@ -114,6 +126,16 @@ protected:
     transaction=nullptr;
     }
 
+  // Commit in batches and give way to the user interface. Returns true if committed.
+  FXbool checkpoint_transaction() {
+    if (transaction->due()) {
+      dbtracks.checkpoint_summary();
+      transaction->checkpoint();
+      return true;
+      }
+    return false;
+    }
+
 protected:
   // Return true if same composer is set on all tracks
   FXbool has_same_composer() const;
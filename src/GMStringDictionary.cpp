@@ -0,0 +1,110 @@
+/*******************************************************************************
+*                         Goggles Music Manager                                *
+********************************************************************************
+*           Copyright (C) 2006-2026 by Sander Jansen. All Rights Reserved      *
+*                               ---                                            *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License for more details.                                 *
+*                                                                              *
+* You should have received a copy of the GNU General Public License            *
+* along with this program.  If not, see http://www.gnu.org/licenses.           *
+********************************************************************************/
+#include "gmdefs.h"
+#include "GMDatabase.h"
+#include "GMStringDictionary.h"
+
+
+GMStringDictionary::GMStringDictionary(const FXchar * t,FXbool k) : table(t),usekeywords(k) {
+  }
+
+
+void GMStringDictionary::makeKey(GMStringEntry & entry) const {
+  FXint p=0;
+  if (usekeywords) {
+    for (FXint i=0;i<keywords.no();i++){
+      if (FXString::comparecase(entry.name,keywords[i],keywords[i].length())==0) {
+        p=FXMIN(entry.name.length()-1,entry.name.find(' ')+1);
+        break;
+        }
+      }
+    }
+  entry.key.assign(&entry.name[p],entry.name.length()-p);
+  entry.key.lower();
+  }
+
+
+GMStringDictionary::~GMStringDictionary() {
+  clear();
+  }
+
+
+void GMStringDictionary::resize(FXint n) {
+  FXint old=entries.no();
+  if (n>old) {
+    entries.no(n);
+    for (FXint i=old;i<n;i++) entries[i]=nullptr;
+    }
+  }
+
+
+void GMStringDictionary::load(GMDatabase * db,FXint from) {
+  GM_TICKS_START();
+  FXint id,maxid=0;
+  try {
+    db->execute(FXString::value("SELECT MAX(id) FROM %s;",table).text(),maxid);
+    if (maxid<=from)
+      return;
+
+    resize(maxid+1);
+
+    GMQuery q(db,FXString::value("SELECT id,name FROM %s WHERE id > %d;",table,from).text());
+    while(q.row()) {
+      q.get(0,id);
+      if (id<=0) continue;
+      resize(id+1);
+      if (entries[id]==nullptr) entries[id]=new GMStringEntry;
+      q.get(1,entries[id]->name);
+      makeKey(*entries[id]);
+      last=FXMAX(last,id);
+      }
+    }
+  catch(GMDatabaseException&){
+    }
+  GM_TICKS_END();
+  }
+
+
+void GMStringDictionary::update(GMDatabase * db) {
+  load(db,last);
+  }
+
+
+void GMStringDictionary::reload(GMDatabase * db) {
+  load(db,0);
+  }
+
+
+void GMStringDictionary::clear() {
+  for (FXint i=0;i<entries.no();i++) {
+    delete entries[i];
+    }
+  entries.clear();
+  last=0;
+  }
+
+
+void GMStringDictionary::setKeywords(const FXStringList & list) {
+  keywords=list;
+  if (usekeywords) {
+    for (FXint i=0;i<entries.no();i++) {
+      if (entries[i]) makeKey(*entries[i]);
+      }
+    }
+  }
@@ -0,0 +1,75 @@
+/*******************************************************************************
+*                         Goggles Music Manager                                *
+********************************************************************************
+*           Copyright (C) 2006-2026 by Sander Jansen. All Rights Reserved      *
+*                               ---                                            *
+* This program is free software: you can redistribute it and/or modify         *
+* it under the terms of the GNU General Public License as published by         *
+* the Free Software Foundation, either version 3 of the License, or            *
+* (at your option) any later version.                                          *
+*                                                                              *
+* This program is distributed in the hope that it will be useful,              *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of               *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                *
+* GNU General Public License for more details.                                 *
+*                                                                              *
+* You should have received a copy of the GNU General Public License            *
+* along with this program.  If not, see http://www.gnu.org/licenses.           *
+********************************************************************************/
+#ifndef GMSTRINGDICTIONARY_H
+#define GMSTRINGDICTIONARY_H
+
+class GMDatabase;
+
+struct GMStringEntry {
+  FXString name;
+  FXString key;             // sort key
+  };
+
+
+/*
+  Id to name lookup for one of the name tables, shared by everything that
+  displays or sorts tracks. Entries are stored by their database id, so a
+  lookup is a plain array access. Entries never move once loaded, so returned
+  pointers stay valid until clear(). Rows added to the table are picked up
+  incrementally. The sort key is the lowercase name without a leading sort
+  keyword, so sorting only needs a byte compare.
+*/
+class GMStringDictionary {
+protected:
+  FXArray<GMStringEntry*> entries;    // indexed by id
+  FXStringList            keywords;   // ignored at the start of the sort key
+  const FXchar *          table;
+  FXint                   last = 0;   // largest id loaded
+  FXbool                  usekeywords;
+protected:
+  void makeKey(GMStringEntry &) const;
+  void resize(FXint n);
+  void load(GMDatabase * db,FXint from);
+private:
+  GMStringDictionary(const GMStringDictionary&);
+  GMStringDictionary& operator=(const GMStringDictionary&);
+public:
+  GMStringDictionary(const FXchar * table,FXbool usekeywords);
+
+  /// Load rows added since the last update
+  void update(GMDatabase * db);
+
+  /// Reload all rows, keeping existing entries in place
+  void reload(GMDatabase * db);
+
+  /// Forget all entries
+  void clear();
+
+  /// Set the keywords to ignore in sort keys
+  void setKeywords(const FXStringList & list);
+
+  /// Return entry or nullptr if not loaded
+  const GMStringEntry * find(FXint id) const {
+    return (id>0 && id<entries.no()) ? entries[id] : nullptr;
+    }
+
+  ~GMStringDictionary();
+  };
+
+#endif
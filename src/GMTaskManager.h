@@ -88,6 +88,9 @@ public:
 
   void setSelector(FXSelector sel) { message=sel; }
 
+  /// Return true if the task was asked to stop
+  FXbool cancelled() const { return !processing; }
+
   virtual FXint run() = 0;
 
   virtual ~GMTask();
@@ -37,7 +37,9 @@
 #endif
 
 
-#define GOGGLESMM_DATABASE_SCHEMA_VERSION 2018  /* Lyrics */
+#define GOGGLESMM_DATABASE_SCHEMA_VERSION 2020  /* Play History */
+#define GOGGLESMM_DATABASE_SCHEMA_V17     2019  /* Browser Summary */
+#define GOGGLESMM_DATABASE_SCHEMA_V16     2018  /* Lyrics */
 #define GOGGLESMM_DATABASE_SCHEMA_V15     2017  /* Album Audio Quality*/
 #define GOGGLESMM_DATABASE_SCHEMA_V14     2016  /* add autodownload to feed table*/
 #define GOGGLESMM_DATABASE_SCHEMA_V13     2015  /* Fix empty tags and add foreign reference to feeds table*/
@@ -150,22 +152,70 @@ const FXchar create_pathlist[]=       "CREATE TABLE pathlist ("
                                           "name TEXT NOT NULL UNIQUE,"
                                           "PRIMARY KEY (id));";
 
+/* Summary tables used to populate the browser. Maintained by sync_summary() */
+const FXchar create_album_summary[]=  "CREATE TABLE album_summary ("
+                                          "album INTEGER NOT NULL,"
+                                          "artist INTEGER NOT NULL,"
+                                          "year INTEGER,"
+                                          "tracks INTEGER NOT NULL,"
+                                          "time INTEGER NOT NULL,"
+                                          "PRIMARY KEY (album));";
+
+const FXchar create_album_tags[]=     "CREATE TABLE album_tags ("
+                                          "tag INTEGER NOT NULL,"
+                                          "album INTEGER NOT NULL,"
+                                          "tracks INTEGER NOT NULL,"
+                                          "PRIMARY KEY (tag,album));";
+
+const FXchar create_artist_summary[]= "CREATE TABLE artist_summary ("
+                                          "artist INTEGER NOT NULL,"
+                                          "albums INTEGER NOT NULL,"
+                                          "tracks INTEGER NOT NULL,"
+                                          "PRIMARY KEY (artist));";
+
+// Append only log of play events. Filters and sorting still use
+// tracks.playcount and tracks.playdate, which are updated alongside.
+const FXchar create_play_history[]=   "CREATE TABLE play_history ("
+                                          "track INTEGER NOT NULL REFERENCES tracks(id),"
+                                          "date INTEGER NOT NULL);";
+
 
 
-GMTrackDatabase::GMTrackDatabase()  {
+GMTrackDatabase::GMTrackDatabase() : paths("pathlist",false),artists("artists",true) {
   }
 
 
 GMTrackDatabase::~GMTrackDatabase() {
-  clear_path_lookup();
-  clear_artist_lookup();
+  }
+
+
+FXbool GMTrackDatabase::prepare(const FXString & database) {
+  if (!open(database))
+    return false;
+
+  opened=true;
+
+  // Upgrades may need user confirmation
+  if (getVersion()!=GOGGLESMM_DATABASE_SCHEMA_VERSION)
+    return false;
+
+  if (!init_database() || !init_queries() || !init_journal())
+    return false;
+
+  openReader();
+
+  ready=true;
+  return true;
   }
 
 
 FXbool GMTrackDatabase::init(const FXString & database) {
   FXint dbversion = 0;
 
-  if (!open(database))
+  if (ready)
+    return true;
+
+  if (!opened && !open(database))
     goto error;
 
   dbversion = getVersion();
@@ -187,6 +237,11 @@ FXbool GMTrackDatabase::init(const FXString & database) {
   if (!init_queries())
     goto error;
 
+  if (!init_journal())
+    goto error;
+
+  openReader();
+
   return true;
 error:
   FXMessageBox::error(FXApp::instance(),MBOX_OK,fxtr("Fatal Error"),fxtr("Goggles Music Manager was unable to open the database.\nThe database may have been corrupted. Please remove %s to try again.\nif the error keeps occurring, please file an issue at http://gogglesmm.github.io"),database.text());
@@ -220,6 +275,12 @@ void GMTrackDatabase::init_index() {
 
   execute("CREATE INDEX IF NOT EXISTS playlist_tracks_track ON playlist_tracks(track)");
   execute("CREATE INDEX IF NOT EXISTS playlist_tracks_playlist ON playlist_tracks(playlist)");
+
+  execute("CREATE INDEX IF NOT EXISTS album_summary_artist ON album_summary(artist)");
+  execute("CREATE INDEX IF NOT EXISTS album_tags_album ON album_tags(album)");
+
+  execute("CREATE INDEX IF NOT EXISTS play_history_track ON play_history(track)");
+  execute("CREATE INDEX IF NOT EXISTS play_history_date ON play_history(date)");
   }
 
 void GMTrackDatabase::fix_empty_tags(){
@@ -335,6 +396,21 @@ FXbool GMTrackDatabase::init_database() {
           execute("ALTER TABLE tracks ADD COLUMN lyrics TEXT");
           }
 
+        // fallthrough - intentionally no break
+
+      case GOGGLESMM_DATABASE_SCHEMA_V16  :
+
+        execute(create_album_summary);
+        execute(create_album_tags);
+        execute(create_artist_summary);
+        sync_summary();
+
+        // fallthrough - intentionally no break
+
+      case GOGGLESMM_DATABASE_SCHEMA_V17  :
+
+        execute(create_play_history);
+
         setVersion(GOGGLESMM_DATABASE_SCHEMA_VERSION);
         break;
 
@@ -352,6 +428,10 @@ FXbool GMTrackDatabase::init_database() {
         execute(create_streams);
         execute(create_feed);
         execute(create_feed_items);
+        execute(create_album_summary);
+        execute(create_album_tags);
+        execute(create_artist_summary);
+        execute(create_play_history);
         setVersion(GOGGLESMM_DATABASE_SCHEMA_VERSION);
         break;
       }
@@ -402,16 +482,65 @@ FXbool GMTrackDatabase::init_queries() {
 
     update_track_filename               = compile("UPDATE tracks SET path = ?, mrl = ? WHERE id == ?;");
     update_track_playcount              = compile("UPDATE tracks SET playcount = playcount + 1, playdate = ? WHERE id == ?;");
+    insert_play_history                 = compile("INSERT INTO play_history SELECT id, ? FROM tracks WHERE id == ?;");
     update_track_importdate             = compile("UPDATE tracks SET importdate = ? WHERE id == ?;");
 
     delete_track = compile("DELETE FROM tracks WHERE id == ?;");
     delete_playlist_track = compile("DELETE FROM playlist_tracks WHERE track == ?;");
     delete_tag_track = compile("DELETE FROM track_tags WHERE track == ?;");
+    delete_play_history = compile("DELETE FROM play_history WHERE track == ?;");
+
+
+
+    paths.update(this);
+    artists.update(this);
+    }
+  catch(GMDatabaseException&){
+    return false;
+    }
+  return true;
+  }
 
 
+/*
+  Track Journal: records the id of every track that was inserted, updated,
+  removed or retagged on this connection, stamped with an increasing version.
+  Since the track is the primary key, the journal never grows beyond the
+  number of tracks. Changes to albums, artists, tags or paths may affect many
+  tracks at once and bump the epoch instead.
+*/
+FXbool GMTrackDatabase::init_journal() {
+  try {
+    // prepare() may have set up part of the journal before failing, so every
+    // statement must be safe to run again on the same connection.
+    execute("CREATE TEMP TABLE IF NOT EXISTS track_journal (track INTEGER PRIMARY KEY, version INTEGER NOT NULL);");
+    execute("CREATE INDEX IF NOT EXISTS temp.track_journal_version ON track_journal(version);");
+    execute("CREATE TEMP TABLE IF NOT EXISTS track_journal_state (version INTEGER NOT NULL, epoch INTEGER NOT NULL);");
+    execute("INSERT INTO track_journal_state SELECT 0,0 WHERE NOT EXISTS (SELECT 1 FROM track_journal_state);");
+
+    const FXchar * const tracks[][3] = {
+      { "tracks_insert", "AFTER INSERT ON main.tracks", "NEW.id" },
+      { "tracks_update", "AFTER UPDATE ON main.tracks", "NEW.id" },
+      { "tracks_delete", "AFTER DELETE ON main.tracks", "OLD.id" },
+      { "track_tags_insert", "AFTER INSERT ON main.track_tags", "NEW.track" },
+      { "track_tags_delete", "AFTER DELETE ON main.track_tags", "OLD.track" }
+      };
+
+    for (FXuint i=0;i<ARRAYNUMBER(tracks);i++) {
+      executeFormat("CREATE TEMP TRIGGER IF NOT EXISTS journal_%s %s BEGIN "
+                      "UPDATE track_journal_state SET version = version + 1; "
+                      "INSERT OR REPLACE INTO track_journal SELECT %s, version FROM track_journal_state; "
+                    "END;",tracks[i][0],tracks[i][1],tracks[i][2]);
+      }
+
+    const FXchar * const tables[] = { "albums", "artists", "tags", "pathlist" };
+    for (FXuint i=0;i<ARRAYNUMBER(tables);i++) {
+      executeFormat("CREATE TEMP TRIGGER IF NOT EXISTS journal_%s_update AFTER UPDATE ON main.%s BEGIN "
+                      "UPDATE track_journal_state SET epoch = epoch + 1; "
+                    "END;",tables[i],tables[i]);
+      }
 
-    setup_path_lookup();
-    setup_artist_lookup();
+    query_track_journal = compile("SELECT version, epoch FROM track_journal_state;");
     }
   catch(GMDatabaseException&){
     return false;
@@ -420,16 +549,31 @@ FXbool GMTrackDatabase::init_queries() {
   }
 
 
+void GMTrackDatabase::getTrackJournal(FXlong & version,FXlong & epoch) {
+  DEBUG_DB_GET();
+  version = epoch = 0;
+  if (query_track_journal.row()) {
+    query_track_journal.get(0,version);
+    query_track_journal.get(1,epoch);
+    }
+  query_track_journal.reset();
+  }
+
+
 FXbool GMTrackDatabase::clearTracks(FXbool removeplaylists){
   DEBUG_DB_SET();
   try {
     GMLockTransaction transaction(this);
     execute("DELETE FROM playlist_tracks;");
+    execute("DELETE FROM play_history;");
     execute("DELETE FROM track_tags;");
     execute("DELETE FROM tracks;");
     execute("DELETE FROM pathlist;");
     execute("DELETE FROM albums;");
     execute("DELETE FROM artists;");
+    execute("DELETE FROM album_tags;");
+    execute("DELETE FROM album_summary;");
+    execute("DELETE FROM artist_summary;");
     execute("DELETE FROM tags WHERE id NOT IN (SELECT genre FROM streams UNION SELECT tag FROM feeds);");
     if (removeplaylists) {
       execute("DELETE FROM playlists;");
@@ -868,26 +1012,54 @@ FXbool GMTrackDatabase::getAlbumTrack(FXint id,FXString & path) {
   return true;
   }
 
+/// Find entry, load new rows on a miss and reload everything as last resort
+const GMStringEntry * GMTrackDatabase::lookup(GMStringDictionary & dictionary,FXint id) {
+  if (__likely(id>0)) {
+    const GMStringEntry * entry = dictionary.find(id);
+    if (__likely(entry)) return entry;
+    dictionary.update(this);
+    entry = dictionary.find(id);
+    if (__likely(entry)) return entry;
+    dictionary.reload(this);
+    return dictionary.find(id);
+    }
+  return nullptr;
+  }
+
 /// Return the track path;
 const FXchar * GMTrackDatabase::getTrackPath(FXint pid) {
-  const void * ptr = pathdict.at((void*)(FXival)pid);
-  if (__likely(ptr)) return (const FXchar*)ptr;
-  initPathLookup();
-  ptr = pathdict.at((void*)(FXival)pid);
-  if (__likely(ptr)) return (const FXchar*)ptr;
-  return "";
+  const GMStringEntry * entry = lookup(paths,pid);
+  return entry ? entry->name.text() : "";
   }
 
 /// Return artist;
 const FXString * GMTrackDatabase::getArtist(FXint aid) {
-  if (__likely(aid>0)) {
-    const void * ptr = artistdict.at((void*)(FXival)aid);
-    if (__likely(ptr)) return (const FXString*)ptr;
-    initArtistLookup();
-    ptr = artistdict.at((void*)(FXival)aid);
-    if (__likely(ptr)) return (const FXString*)ptr;
-    }
-  return &empty;
+  const GMStringEntry * entry = lookup(artists,aid);
+  return entry ? &entry->name : &empty;
+  }
+
+FXint GMTrackDatabase::compareArtist(FXint a,FXint b) {
+  if (a==b) return 0;
+  // Load both before taking pointers
+  lookup(artists,a);
+  lookup(artists,b);
+  const GMStringEntry * ea = artists.find(a);
+  const GMStringEntry * eb = artists.find(b);
+  return FXString::compare(ea ? ea->key : empty,eb ? eb->key : empty);
+  }
+
+FXint GMTrackDatabase::comparePath(FXint a,FXint b) {
+  if (a==b) return 0;
+  // Load both before taking pointers
+  lookup(paths,a);
+  lookup(paths,b);
+  const GMStringEntry * ea = paths.find(a);
+  const GMStringEntry * eb = paths.find(b);
+  return FXString::compare(ea ? ea->key : empty,eb ? eb->key : empty);
+  }
+
+void GMTrackDatabase::setSortKeywords(const FXStringList & keywords) {
+  artists.setKeywords(keywords);
   }
 
 
@@ -1048,12 +1220,34 @@ FXbool GMTrackDatabase::getTrackAssociation(FXint id,FXint & artist,FXint & albu
 
 
 
+void GMTrackDatabase::getTrackAlbums(const FXIntList & tracks,FXIntList & albums) {
+  DEBUG_DB_GET();
+  GMQuery query(this,"SELECT album FROM tracks WHERE id == ?;");
+  for (FXint i=0;i<tracks.no();i++) {
+    FXint album=0;
+    query.execute(tracks[i],album);
+    if (album && (albums.no()==0 || albums[albums.no()-1]!=album))
+      albums.append(album);
+    }
+  }
+
+
 FXbool GMTrackDatabase::removeArtist(FXint artist) {
   DEBUG_DB_SET();
   try {
     GMQuery query;
+    FXIntList albums;
     GMLockTransaction transaction(this);
 
+    query = compile("SELECT id FROM albums WHERE artist == ? UNION SELECT album FROM tracks WHERE artist == ?;");
+    query.set(0,artist);
+    query.set(1,artist);
+    while(query.row()) {
+      FXint album;
+      query.get(0,album);
+      albums.append(album);
+      }
+
     query = compile("DELETE FROM playlist_tracks WHERE track IN (SELECT id FROM tracks WHERE artist == ? OR album IN (SELECT id FROM albums WHERE artist == ?))");
     query.set(0,artist);
     query.set(1,artist);
@@ -1064,6 +1258,11 @@ FXbool GMTrackDatabase::removeArtist(FXint artist) {
     query.set(1,artist);
     query.execute();
 
+    query = compile("DELETE FROM play_history WHERE track IN (SELECT id FROM tracks WHERE artist == ? OR album IN (SELECT id FROM albums WHERE artist == ?))");
+    query.set(0,artist);
+    query.set(1,artist);
+    query.execute();
+
     query = compile("DELETE FROM tracks WHERE artist == ? OR album IN ( SELECT id FROM albums WHERE artist == ?);");
     query.set(0,artist);
     query.set(1,artist);
@@ -1073,6 +1272,7 @@ FXbool GMTrackDatabase::removeArtist(FXint artist) {
     query.update(artist);
 
     sync_tracks_removed();
+    sync_summary(albums);
     transaction.commit();
     }
   catch (GMDatabaseException & e){
@@ -1095,6 +1295,10 @@ FXbool GMTrackDatabase::removeAlbum(FXint album) {
     query = compile("DELETE FROM track_tags WHERE track IN (SELECT id FROM tracks WHERE album == ?);");
     query.update(album);
 
+    // Remove tracks from play history
+    query = compile("DELETE FROM play_history WHERE track IN (SELECT id FROM tracks WHERE album == ?);");
+    query.update(album);
+
     /// Removes tracks with album
     query = compile("DELETE FROM tracks WHERE album == ?;");
     query.update(album);
@@ -1108,6 +1312,10 @@ FXbool GMTrackDatabase::removeAlbum(FXint album) {
     clean_tags();
     execute("DELETE FROM pathlist WHERE id NOT IN (SELECT DISTINCT(path) FROM tracks);");
 
+    FXIntList albums;
+    albums.append(album);
+    sync_summary(albums);
+
     transaction.commit();
     }
   catch (GMDatabaseException & e){
@@ -1369,72 +1577,14 @@ FXbool GMTrackDatabase::listAlbums(FXComboBox * list,FXint track){
 
 
 
-void GMTrackDatabase::clear_path_lookup() {
-  DEBUG_DB_GET();
-  for (FXint i=0;i<pathdict.no();i++) {
-    if (!pathdict.empty(i) && pathdict.data(i)!=nullptr) {
-      free(pathdict.data(i));
-      }
-    }
-  pathdict.clear();
-  }
-
-
-void GMTrackDatabase::setup_path_lookup() {
-  DEBUG_DB_GET();
-  GM_TICKS_START();
-  GMQuery q;
-  FXint path;
-  try {
-    q = compile("SELECT id,name FROM pathlist;");
-    while(q.row()) {
-      q.get(0,path);
-      pathdict.insert((void*)(FXival)path,strdup(q.get(1)));
-      }
-    }
-  catch(GMDatabaseException & e){
-    }
-  GM_TICKS_END();
-  }
-
 void GMTrackDatabase::initPathLookup() {
-  clear_path_lookup();
-  setup_path_lookup();
-  }
-
-
-
-void GMTrackDatabase::setup_artist_lookup() {
-  DEBUG_DB_GET();
-  GM_TICKS_START();
-  GMQuery q;
-  FXint id;
-  try {
-    q = compile("SELECT id,name FROM artists;");
-    while(q.row()) {
-      q.get(0,id);
-      artistdict.insert((void*)(FXival)id,new FXString(q.get(1)));
-      }
-    }
-  catch(GMDatabaseException & e){
-    }
-  GM_TICKS_END();
-  }
-
-void GMTrackDatabase::clear_artist_lookup() {
-  DEBUG_DB_GET();
-  for (FXint i=0;i<artistdict.no();i++) {
-    if (!artistdict.empty(i) && artistdict.data(i)!=nullptr) {
-      FXString * a = (FXString*)artistdict.data(i);
-      delete a;
-      }
-    }
-  artistdict.clear();
+  paths.clear();
+  paths.update(this);
   }
 
 void GMTrackDatabase::initArtistLookup() {
-  clear_artist_lookup();
-  setup_artist_lookup();
+  artists.clear();
+  artists.update(this);
   }
 
 
@@ -1477,10 +1627,8 @@ FXbool GMTrackDatabase::vacuum() {
     transaction.commit();
 
     /// Reinitialize path lookup
-    clear_path_lookup();
-    clear_artist_lookup();
-    setup_path_lookup();
-    setup_artist_lookup();
+    initPathLookup();
+    initArtistLookup();
     }
   catch(GMDatabaseException &) {
     return false;
@@ -1630,11 +1778,38 @@ void GMTrackDatabase::setTrackRating(FXint id,FXuchar rating){
 
 void GMTrackDatabase::setTrackPlayed(FXint track,FXlong time) {
   DEBUG_DB_SET();
-  GMLockTransaction transaction(this);
-  update_track_playcount.set(0,time);
-  update_track_playcount.set(1,track);
-  update_track_playcount.execute();
-  transaction.commit();
+  GMPlayEvent event = {track,time};
+  played.append(event);
+  }
+
+
+FXbool GMTrackDatabase::syncTrackPlayed(FXbool force) {
+  DEBUG_DB_SET();
+  if (played.no()==0)
+    return true;
+
+  if (!force && busy()) {
+    GM_DEBUG_PRINT("Database busy, %d play events pending\n",played.no());
+    return false;
+    }
+
+  try {
+    GMLockTransaction transaction(this);
+    for (FXint i=0;i<played.no();i++) {
+      insert_play_history.set(0,played[i].date);
+      insert_play_history.set(1,played[i].track);
+      insert_play_history.execute();
+      update_track_playcount.set(0,played[i].date);
+      update_track_playcount.set(1,played[i].track);
+      update_track_playcount.execute();
+      }
+    transaction.commit();
+    }
+  catch(GMDatabaseException&) {
+    return false;
+    }
+  played.clear();
+  return true;
   }
 
 
@@ -2002,9 +2177,60 @@ void GMTrackDatabase::sync_album_year() {
   }
 
 
+/*
+  Rebuild the album, album tag and artist summaries from scratch.
+*/
+void GMTrackDatabase::sync_summary() {
+  DEBUG_DB_SET();
+  GM_TICKS_START();
+  execute("DELETE FROM album_tags;");
+  execute("DELETE FROM album_summary;");
+  execute("DELETE FROM artist_summary;");
+  execute("INSERT INTO album_summary SELECT albums.id, albums.artist, albums.year, COUNT(*), ifnull(SUM(tracks.time),0) FROM albums JOIN tracks ON tracks.album == albums.id GROUP BY albums.id;");
+  execute("INSERT INTO album_tags SELECT track_tags.tag, tracks.album, COUNT(*) FROM tracks JOIN track_tags ON track_tags.track == tracks.id GROUP BY tracks.album, track_tags.tag;");
+  execute("INSERT INTO artist_summary SELECT artist, COUNT(*), SUM(tracks) FROM album_summary GROUP BY artist;");
+  GM_TICKS_END();
+  }
+
+
+/*
+  Only refresh the summaries for the given albums and their album artists.
+  Albums that no longer have any tracks simply drop out of the summary.
+*/
+void GMTrackDatabase::sync_summary(const FXIntList & albums) {
+  DEBUG_DB_SET();
+  if (albums.no()==0) return;
+  GM_TICKS_START();
+  execute("CREATE TEMP TABLE IF NOT EXISTS summary_albums (id INTEGER PRIMARY KEY);");
+  execute("CREATE TEMP TABLE IF NOT EXISTS summary_artists (id INTEGER PRIMARY KEY);");
+
+  GMQuery insert_album(this,"INSERT OR IGNORE INTO summary_albums VALUES (?);");
+  for (FXint i=0;i<albums.no();i++) {
+    insert_album.update(albums[i]);
+    }
+
+  execute("INSERT OR IGNORE INTO summary_artists SELECT artist FROM album_summary WHERE album IN (SELECT id FROM summary_albums) "
+          "UNION SELECT artist FROM albums WHERE id IN (SELECT id FROM summary_albums);");
+
+  execute("DELETE FROM album_tags WHERE album IN (SELECT id FROM summary_albums);");
+  execute("DELETE FROM album_summary WHERE album IN (SELECT id FROM summary_albums);");
+  execute("INSERT INTO album_summary SELECT albums.id, albums.artist, albums.year, COUNT(*), ifnull(SUM(tracks.time),0) FROM albums JOIN tracks ON tracks.album == albums.id WHERE albums.id IN (SELECT id FROM summary_albums) GROUP BY albums.id;");
+  execute("INSERT INTO album_tags SELECT track_tags.tag, tracks.album, COUNT(*) FROM tracks JOIN track_tags ON track_tags.track == tracks.id WHERE tracks.album IN (SELECT id FROM summary_albums) GROUP BY tracks.album, track_tags.tag;");
+
+  execute("DELETE FROM artist_summary WHERE artist IN (SELECT id FROM summary_artists);");
+  execute("INSERT INTO artist_summary SELECT artist, COUNT(*), SUM(tracks) FROM album_summary WHERE artist IN (SELECT id FROM summary_artists) GROUP BY artist;");
+
+  execute("DELETE FROM summary_albums;");
+  execute("DELETE FROM summary_artists;");
+  GM_TICKS_END();
+  }
+
+
 
 void GMTrackDatabase::removeTracks(const FXIntList & tracks) {
   DEBUG_DB_SET();
+  FXIntList albums;
+  getTrackAlbums(tracks,albums);
   GM_TICKS_START();
   for (FXint i=0;i<tracks.no();i++){
     delete_playlist_track.update(tracks[i]);
@@ -2012,11 +2238,15 @@ void GMTrackDatabase::removeTracks(const FXIntList & tracks) {
   for (FXint i=0;i<tracks.no();i++){
     delete_tag_track.update(tracks[i]);
     }
+  for (FXint i=0;i<tracks.no();i++){
+    delete_play_history.update(tracks[i]);
+    }
   for (FXint i=0;i<tracks.no();i++){
     delete_track.update(tracks[i]);
     }
   GM_TICKS_END();
   sync_tracks_removed();
+  sync_summary(albums);
   }
 
 void GMTrackDatabase::removeTrack(FXint track) {
@@ -23,6 +23,10 @@
 #include "GMDatabase.h"
 #endif
 
+#ifndef GMSTRINGDICTIONARY_H
+#include "GMStringDictionary.h"
+#endif
+
 class GMTrackList;
 
 enum {
@@ -51,11 +55,22 @@ struct GMPlayListItem {
 typedef FXArray<GMPlayListItem> GMPlayListItemList;
 
 
+struct GMPlayEvent {
+  FXint  track;
+  FXlong date;
+  };
+
+typedef FXArray<GMPlayEvent> GMPlayEventList;
+
+
 class GMTrackDatabase : public GMDatabase {
 protected:
-  FXHash   pathdict;
-  FXHash   artistdict;
+  GMStringDictionary paths;
+  GMStringDictionary artists;
   FXString empty;
+  FXbool   opened = false;  // opened by prepare()
+  FXbool   ready  = false;  // fully initialized by prepare()
+  GMPlayEventList played;   // play events not yet written to the database
 public:
   GMQuery insert_path;                  /// Insert Path
   GMQuery insert_artist;                /// Insert Artist;
@@ -70,16 +85,20 @@ public:
   GMQuery query_track_filename;         /// Query filename by track id
   GMQuery query_album_artists;          /// Query artist and album for track
   GMQuery update_track_playcount;       /// Update Track as played
+  GMQuery insert_play_history;          /// Append to play history
   GMQuery update_track_importdate;      /// Update Track as played
   GMQuery update_track_filename;  		/// Update track filename
 
   GMQuery delete_track;					/// Delete Track
   GMQuery delete_playlist_track;
   GMQuery delete_tag_track;
+  GMQuery delete_play_history;
   GMQuery update_track_rating;          /// Update track rating
+  GMQuery query_track_journal;          /// Query track journal version
 private: /// Called from init()
   FXbool init_database();
   FXbool init_queries();
+  FXbool init_journal();
   void   init_index();
   void   fix_empty_tags();
   void   init_album_properties();
@@ -88,10 +107,7 @@ protected:
   FXbool reorderPlaylist(FXint pl);
   FXbool reorderQueue();
 protected:
-  void setup_path_lookup();
-  void clear_path_lookup();
-  void setup_artist_lookup();
-  void clear_artist_lookup();
+  const GMStringEntry * lookup(GMStringDictionary &,FXint id);
 
   void clean_tags();
 public:
@@ -104,6 +120,10 @@ public:
   /// Initialize the database. Return FALSE if failed else TRUE
   FXbool init(const FXString & filename);
 
+  /// Initialize the database without user interaction. Safe to call from a worker thread.
+  /// If this fails, init() still needs to be called to upgrade or report the problem.
+  FXbool prepare(const FXString & filename);
+
 
   ///=======================================================================================
   ///   QUERY ITEMS
@@ -119,6 +139,9 @@ public:
   /// Return artist, album id
   FXbool getTrackAssociation(FXint id,FXint & artist,FXint & album);
 
+  /// Append the albums of the given tracks
+  void getTrackAlbums(const FXIntList & tracks,FXIntList & albums);
+
   /// Return filename for track
   FXString getTrackFilename(FXint id);
 
@@ -140,15 +163,27 @@ public:
   /// Return the track path;
   const FXchar * getTrackPath(FXint pid);
 
-  /// Return the track path;
+  /// Return the artist
   const FXString * getArtist(FXint aid);
 
+  /// Compare two artists by sort key
+  FXint compareArtist(FXint a,FXint b);
+
+  /// Compare two track paths
+  FXint comparePath(FXint a,FXint b);
+
+  /// Set the keywords ignored when sorting artists
+  void setSortKeywords(const FXStringList & keywords);
+
   /// Get the track stats
   void getTrackStats(FXint & ntracks,FXint & nartists,FXint & nalbums,FXint & ntime,FXint playlist=0);
 
   /// Check if database is empty
   FXbool isEmpty();
 
+  /// Return the track journal version and epoch
+  void getTrackJournal(FXlong & version,FXlong & epoch);
+
   /// Return number of tracks in database
   FXint getNumTracks();
 
@@ -236,9 +271,15 @@ public:
   /// Set Track Rating
   void setTrackRating(FXint id,FXuchar rating);
 
-  /// Set Track Played
+  /// Set Track Played. Recorded in memory until syncTrackPlayed
   void setTrackPlayed(FXint id,FXlong time);
 
+  /// Write pending play events. Unless forced, skipped while a task holds the database
+  FXbool syncTrackPlayed(FXbool force=false);
+
+  /// Any play events not yet written
+  FXbool hasTrackPlayed() const { return played.no()>0; }
+
   /// Change the filename of id
   void setTrackFilename(FXint id,const FXString & filename);
 
@@ -330,6 +371,8 @@ public:
   ///=======================================================================================
   void sync_tracks_removed();
   void sync_album_year();
+  void sync_summary();
+  void sync_summary(const FXIntList & albums);
 
   void initArtistLookup();
   void initPathLookup();
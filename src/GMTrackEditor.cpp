@@ -842,10 +842,14 @@ FXbool GMEditTrackDialog::saveTracks() {
   FXString field;
   FXString altfield;
   FXStringList tags;
+  FXIntList albums;
 
   try {
     GMLockTransaction transaction(db);
 
+    // Albums the tracks are on before the edit. Summaries are refreshed for these and the new ones.
+    db->getTrackAlbums(tracks,albums);
+
     /// Update Title
     if (tracks.no()==1) {
       field=titlefield->getText().trim().simplify();
@@ -980,6 +984,8 @@ FXbool GMEditTrackDialog::saveTracks() {
 
     db->sync_tracks_removed();
     db->sync_album_year();
+    db->getTrackAlbums(tracks,albums);
+    db->sync_summary(albums);
     transaction.commit();
     }
   catch(GMDatabaseException&) {
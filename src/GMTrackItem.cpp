@@ -37,7 +37,7 @@
 #define VALUE_SORT_ASC(a,b) (a>b) ? 1 : ((a<b) ? -1 : 0);
 #define VALUE_SORT_DSC(a,b) (a>b) ? -1 : ((a<b) ? 1 : 0);
 
-#define GET_ARTIST_STRING(x)  GMPlayerManager::instance()->getTrackDatabase()->getArtist(x)
+#define COMPARE_ARTIST(a,b)   GMPlayerManager::instance()->getTrackDatabase()->compareArtist(a,b)
 
 
 // return true if string starts with configured keyword
@@ -48,32 +48,6 @@ static inline FXbool begins_with_keyword(const FXString & t){
   return false;
   }
 
-// return true if string starts with configured keyword
-static inline FXbool begins_with_keyword_ptr(const FXString * t){
-  for (FXint i=0;i<GMPlayerManager::instance()->getPreferences().gui_sort_keywords.no();i++){
-    if (FXString::comparecase(*t,GMPlayerManager::instance()->getPreferences().gui_sort_keywords[i],GMPlayerManager::instance()->getPreferences().gui_sort_keywords[i].length())==0) return true;
-    }
-  return false;
-  }
-
-// compare two string taking into account the configured keywords it needs to ignore
-static inline FXint keywordcompare(const FXString *a,const FXString *b) {
-  FXint pa,pb;
-
-  if (a==b) return 0;
-
-  if (begins_with_keyword_ptr(a))
-    pa=FXMIN(a->length()-1,a->find(' ')+1);
-  else
-    pa=0;
-
-  if (begins_with_keyword_ptr(b))
-    pb=FXMIN(b->length()-1,b->find(' ')+1);
-  else
-    pb=0;
-  return FXString::comparecase(&((*a)[pa]),&((*b)[pb]));
-  }
-
 // compare two string taking into account the configured keywords it needs to ignore
 static inline FXint keywordcompare(const FXString & a,const FXString & b) {
   FXint pa,pb;
@@ -277,7 +251,7 @@ FXint GMDBTrackItem::list_sort(const GMTrackItem * pa,const GMTrackItem * pb){
   x = keywordcompare(ta->album,tb->album);
   if (x!=0) return (GMTrackView::reverse_album) ? -x : x;
 
-  x = keywordcompare(GET_ARTIST_STRING(ta->albumartist),GET_ARTIST_STRING(tb->albumartist));
+  x = COMPARE_ARTIST(ta->albumartist,tb->albumartist);
   if (x!=0) return (GMTrackView::reverse_artist) ? -x : x;
 
   if (ta->albumid>tb->albumid) return 1;
@@ -296,7 +270,7 @@ FXint GMDBTrackItem::browse_sort(const GMTrackItem * pa,const GMTrackItem * pb){
   const GMDBTrackItem * const ta = static_cast<const GMDBTrackItem*>(pa);
   const GMDBTrackItem * const tb = static_cast<const GMDBTrackItem*>(pb);
 
-  FXint x = keywordcompare(GET_ARTIST_STRING(ta->albumartist),GET_ARTIST_STRING(tb->albumartist));
+  FXint x = COMPARE_ARTIST(ta->albumartist,tb->albumartist);
   if (x!=0) return (GMTrackView::reverse_album == !GMTrackView::reverse_artist) ? -x : x;
 
   if (GMTrackView::album_by_year) {
@@ -336,7 +310,7 @@ FXint GMDBTrackItem::browseSort(const GMTrackItem * pa,const GMTrackItem * pb){
   x = keywordcompare(ta->album,tb->album);
   if (x!=0) return (GMTrackView::reverse_album) ? -x : x;
 
-  x = keywordcompare(GET_ARTIST_STRING(ta->albumartist),GET_ARTIST_STRING(tb->albumartist));
+  x = COMPARE_ARTIST(ta->albumartist,tb->albumartist);
   if (x!=0) return (GMTrackView::reverse_artist) ? -x : x;
 
   if (ta->albumid>tb->albumid) return 1;
@@ -355,7 +329,7 @@ FXint GMDBTrackItem::ascendingFilename(const GMTrackItem* pa,const GMTrackItem*
   const GMDBTrackItem * const tb = static_cast<const GMDBTrackItem*>(pb);
   if (ta->path!=tb->path) {
     GMTrackDatabase* const db = GMPlayerManager::instance()->getTrackDatabase();
-    FXint x = FXString::comparecase(db->getTrackPath(ta->path),db->getTrackPath(tb->path));
+    FXint x = db->comparePath(ta->path,tb->path);
     if (x!=0) return x;
     }
   return FXString::comparecase(ta->mrl,tb->mrl);
@@ -367,7 +341,7 @@ FXint GMDBTrackItem::descendingFilename(const GMTrackItem* pa,const GMTrackItem*
   const GMDBTrackItem * const tb = static_cast<const GMDBTrackItem*>(pb);
   if (ta->path!=tb->path) {
     GMTrackDatabase* const db = GMPlayerManager::instance()->getTrackDatabase();
-    FXint x = FXString::comparecase(db->getTrackPath(ta->path),db->getTrackPath(tb->path));
+    FXint x = db->comparePath(ta->path,tb->path);
     if (x!=0) return -x;
     }
   return -FXString::comparecase(ta->mrl,tb->mrl);
@@ -562,7 +536,7 @@ FXint GMDBTrackItem::ascendingArtist(const GMTrackItem* pa,const GMTrackItem* pb
   const GMDBTrackItem * const tb = static_cast<const GMDBTrackItem*>(pb);
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(ta->artist),GET_ARTIST_STRING(tb->artist));
+  x = COMPARE_ARTIST(ta->artist,tb->artist);
   if (x!=0) return x;
 
   x = keywordcompare(ta->album,tb->album);
@@ -581,7 +555,7 @@ FXint GMDBTrackItem::descendingArtist(const GMTrackItem* pa,const GMTrackItem* p
   const GMDBTrackItem * const tb = static_cast<const GMDBTrackItem*>(pb);
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(tb->artist),GET_ARTIST_STRING(ta->artist));
+  x = COMPARE_ARTIST(tb->artist,ta->artist);
   if (x!=0) return x;
 
   x = keywordcompare(ta->album,tb->album);
@@ -601,7 +575,7 @@ FXint GMDBTrackItem::ascendingAlbumArtist(const GMTrackItem* pa,const GMTrackIte
 
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(ta->albumartist),GET_ARTIST_STRING(tb->albumartist));
+  x = COMPARE_ARTIST(ta->albumartist,tb->albumartist);
   if (x!=0) return x;
 
   x = keywordcompare(ta->album,tb->album);
@@ -622,7 +596,7 @@ FXint GMDBTrackItem::descendingAlbumArtist(const GMTrackItem* pa,const GMTrackIt
 
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(tb->albumartist),GET_ARTIST_STRING(ta->albumartist));
+  x = COMPARE_ARTIST(tb->albumartist,ta->albumartist);
   if (x!=0) return x;
 
   x = keywordcompare(ta->album,tb->album);
@@ -643,7 +617,7 @@ FXint GMDBTrackItem::ascendingComposer(const GMTrackItem* pa,const GMTrackItem*
 
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(ta->composer),GET_ARTIST_STRING(tb->composer));
+  x = COMPARE_ARTIST(ta->composer,tb->composer);
   if (x!=0) return x;
 
   x = keywordcompare(ta->album,tb->album);
@@ -663,7 +637,7 @@ FXint GMDBTrackItem::descendingComposer(const GMTrackItem* pa,const GMTrackItem*
 
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(tb->composer),GET_ARTIST_STRING(ta->composer));
+  x = COMPARE_ARTIST(tb->composer,ta->composer);
   if (x!=0) return x;
 
   x = keywordcompare(tb->album,ta->album);
@@ -683,7 +657,7 @@ FXint GMDBTrackItem::ascendingConductor(const GMTrackItem* pa,const GMTrackItem*
 
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(ta->composer),GET_ARTIST_STRING(tb->composer));
+  x = COMPARE_ARTIST(ta->composer,tb->composer);
   if (x!=0) return x;
 
   x = keywordcompare(ta->album,tb->album);
@@ -703,7 +677,7 @@ FXint GMDBTrackItem::descendingConductor(const GMTrackItem* pa,const GMTrackItem
 
   FXint x;
 
-  x = keywordcompare(GET_ARTIST_STRING(tb->composer),GET_ARTIST_STRING(ta->composer));
+  x = COMPARE_ARTIST(tb->composer,ta->composer);
   if (x!=0) return x;
 
   x = keywordcompare(tb->album,ta->album);
@@ -932,6 +906,8 @@ const FXString * GMFeedItem::getColumnData(FXint type,FXString&text,FXuint & jus
                           break;
     case HEADER_STATUS  : if (flags&(1<<ITEM_FLAG_LOCAL))
                             text = "On Disk";
+                          else if (flags&(1<<ITEM_FLAG_QUEUE) && progress>=0)
+                            text.format("Downloading %d%%",progress);
                           else if (flags&(1<<ITEM_FLAG_QUEUE))
                             text = "In Queue";
                           else
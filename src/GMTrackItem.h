@@ -209,6 +209,7 @@ protected:
   FXTime   date;
   FXuint   time;
   FXuint   flags;
+  FXint    progress = -1;
 public:
   static FXint ascendingDate(const GMTrackItem*,const GMTrackItem*);
   static FXint descendingDate(const GMTrackItem*,const GMTrackItem*);
@@ -230,6 +231,8 @@ public:
 
   void setFlags(FXuint f) { flags=f; }
 
+  void setProgress(FXint p) { progress=p; }
+
   virtual ~GMFeedItem() {}
   };
 
@@ -964,6 +964,13 @@ void GMTrackView::redrawAlbumList() {
   albumlist->update();
   }
 
+void GMTrackView::loadCovers() {
+  if (source && (albumlist->getListStyle()&ALBUMLIST_BROWSER)) {
+    source->loadCovers();
+    redrawAlbumList();
+    }
+  }
+
 void GMTrackView::redrawTrackList() {
   tracklist->update();
   }
@@ -1234,7 +1241,10 @@ void GMTrackView::loadSettings(const FXString & key) {
   if (getApp()->reg().readBoolEntry(key.text(),"album-list-browser",false)){
     FXuint opts=albumlist->getListStyle();
     albumlist->setListStyle(opts|ALBUMLIST_BROWSER);
-    source->loadCovers();
+
+    // Deferred until the window is shown
+    if (!GMPlayerManager::instance()->isStarting())
+      source->loadCovers();
     }
   else {
     FXuint opts=albumlist->getListStyle();
@@ -302,6 +302,8 @@ public:
 
   void redrawAlbumList();
 
+  void loadCovers();
+
   void redrawTrackList();
 
   void setActive(FXint item,FXbool show=true);
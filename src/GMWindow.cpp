@@ -161,8 +161,12 @@ FXIMPLEMENT(GMWindow,FXMainWindow,GMWindowMap,ARRAYNUMBER(GMWindowMap))
 GMWindow::GMWindow(FXApp* a,FXObject*tgt,FXSelector msg) : FXMainWindow(a,"Goggles Music Manager",nullptr,nullptr,DECOR_ALL,5,5,700,580) {
   flags|=FLAG_ENABLED;
 
-  icontheme = new GMIconTheme(getApp());
-  icontheme->load();
+  // Usually loaded during startup already
+  icontheme = GMIconTheme::instance();
+  if (icontheme==nullptr) {
+    icontheme = new GMIconTheme(getApp());
+    icontheme->load();
+    }
 
   setIcon(icontheme->icon_applogo);
   setMiniIcon(icontheme->icon_applogo_small);
@@ -1372,7 +1376,7 @@ void GMWindow::updateCover() {
     else
       size = 0;
 
-    FXImage * image = GMCover::copyToImage(cover,size);
+    FXImage * image = GMPlayerManager::instance()->getCoverManager()->getImage(size);
     if (image) {
       if (coverview_x11) {
         image->create();
@@ -909,3 +909,34 @@ parsefield:
   timestamp += seconds * ((hour*3600)+(minute*60)+(second)-(tzoffset));
   return true;
   }
+
+
+void gm_varint_put(FXString & buffer,FXulong v) {
+  while(v>=0x80) {
+    buffer.append((FXchar)((v&0x7f)|0x80));
+    v>>=7;
+    }
+  buffer.append((FXchar)v);
+  }
+
+void gm_varint_put(FXString & buffer,const FXString & s) {
+  gm_varint_put(buffer,(FXulong)s.length());
+  buffer.append(s);
+  }
+
+FXbool gm_varint_get(const FXuchar *& p,const FXuchar * end,FXulong & v) {
+  v=0;
+  for (FXuint shift=0;p<end && shift<64;shift+=7) {
+    v|=((FXulong)(*p&0x7f))<<shift;
+    if (!(*p++&0x80)) return true;
+    }
+  return false;
+  }
+
+FXbool gm_varint_get(const FXuchar *& p,const FXuchar * end,FXString & s) {
+  FXulong n;
+  if (!gm_varint_get(p,end,n) || n>(FXulong)(end-p)) return false;
+  s.assign((const FXchar*)p,(FXint)n);
+  p+=n;
+  return true;
+  }
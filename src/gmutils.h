@@ -95,4 +95,16 @@ extern void gm_print_time(FXint nseconds,FXString & result);
 
 extern FXbool gm_parse_datetime(const FXString & str,FXTime & timestamp);
 
+/// Append v as a little endian base 128 varint
+extern void gm_varint_put(FXString & buffer,FXulong v);
+
+/// Append a varint length followed by the string
+extern void gm_varint_put(FXString & buffer,const FXString & s);
+
+/// Read a varint from [p,end) and advance p. Returns false on truncated input
+extern FXbool gm_varint_get(const FXuchar *& p,const FXuchar * end,FXulong & v);
+
+/// Read a length prefixed string from [p,end) and advance p
+extern FXbool gm_varint_get(const FXuchar *& p,const FXuchar * end,FXString & s);
+
 #endif
@@ -26,6 +26,7 @@ set(SOURCES
     GMIconTheme.cpp
     GMImportDialog.cpp
     GMImageView.cpp
+    GMLibrarySnapshot.cpp
     GMList.cpp
     GMLocalSource.cpp
     GMLyrics.cpp
@@ -40,6 +41,7 @@ set(SOURCES
     GMScanner.cpp
     GMSource.cpp
     GMSourceView.cpp
+    GMStringDictionary.cpp
     GMTag.cpp
     GMTaskManager.cpp
     GMTrack.cpp